@@ -8,6 +8,6 @@ DEPENDPATH += . QtTelnet
 INCLUDEPATH += . QtTelnet
 
 QT += network
-HEADERS += mainwidget.h QtTelnet/qttelnet.h
+HEADERS += mainwidget.h ansifilter.h logview.h outputrenderer.h ocdtransport.h gdbremote.h flashimage.h station.h loadstats.h ocdsupervisor.h ocdlog.h profile.h batch.h targetflow.h memview.h watch.h memparse.h snapshot.h dump.h spscqueue.h QtTelnet/qttelnet.h
 FORMS += mainwidget.ui
-SOURCES += main.cpp mainwidget.cpp QtTelnet/qttelnet.cpp
+SOURCES += main.cpp mainwidget.cpp ansifilter.cpp logview.cpp outputrenderer.cpp ocdtransport.cpp gdbremote.cpp flashimage.cpp station.cpp loadstats.cpp ocdsupervisor.cpp ocdlog.cpp profile.cpp batch.cpp targetflow.cpp memview.cpp watch.cpp memparse.cpp snapshot.cpp dump.cpp QtTelnet/qttelnet.cpp
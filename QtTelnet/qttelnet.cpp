@@ -71,11 +71,15 @@
 #include <QtNetwork/QTcpSocket>
 #include <QtCore/QList>
 #include <QtCore/QMap>
-#include <QtCore/QPair>
+#include <QtCore/QPointer>
+#include <QtCore/QQueue>
+#include <QtCore/QVector>
+#include <QtCore/QStringList>
 #include <QtCore/QVariant>
 #include <QtCore/QSocketNotifier>
 #include <QtCore/QBuffer>
 #include <QtCore/QVarLengthArray>
+#include <string.h>
 
 #ifdef Q_WS_WIN
 #  include <winsock2.h>
@@ -111,27 +115,245 @@ private:
     int   cd;
 };
 
+/*
+  Fixed-capacity byte ring between the socket and the stream parser.
+  The parser reads the filled region in place through readPointer(),
+  the socket writes straight into the free region via writePointer().
+*/
 class QtTelnetReceiveBuffer
 {
 public:
-    QtTelnetReceiveBuffer() : bytesAvailable(0) {}
-    void append(const QByteArray &data) { buffers.append(data); }
-    void push_back(const QByteArray &data) { buffers.prepend(data); }
-    long size() const { return bytesAvailable; }
-    QByteArray readAll()
+    QtTelnetReceiveBuffer(int capacity) : buf(capacity, '\0'), head(0), used(0) {}
+
+    int capacity() const { return buf.size(); }
+    int size() const { return used; }
+    bool isEmpty() const { return used == 0; }
+    bool isFull() const { return used == buf.size(); }
+    void clear() { head = used = 0; }
+
+    // Never shrinks below the bytes still waiting to be parsed.
+    void setCapacity(int capacity)
+    {
+        capacity = qMax(capacity, used);
+        QByteArray nbuf(capacity, '\0');
+        for (int i = 0; i < used; ++i)
+            nbuf[i] = buf.at((head + i) % buf.size());
+        buf = nbuf;
+        head = 0;
+    }
+
+    // Contiguous free space following the filled region.
+    char *writePointer(int *length)
+    {
+        const int tail = (head + used) % buf.size();
+        if (used == buf.size())
+            *length = 0;
+        else if (tail >= head)
+            *length = buf.size() - tail;
+        else
+            *length = head - tail;
+        return buf.data() + tail;
+    }
+    void commit(int length) { used += length; }
+
+    // Contiguous filled region starting at the read position.
+    const char *readPointer(int *length) const
+    {
+        *length = qMin(used, buf.size() - head);
+        return buf.constData() + head;
+    }
+    void free(int length)
     {
-        QByteArray a;
-        while (!buffers.isEmpty()) {
-            a.append(buffers.takeFirst());
+        used -= length;
+        head = (used == 0) ? 0 : (head + length) % buf.size();
+    }
+
+private:
+    QByteArray buf;
+    int head;
+    int used;
+};
+
+/*
+  Option negotiation state of both sides of the connection, following
+  the RFC 1143 "Q method": each side of an option is NO, YES, WANTNO or
+  WANTYES, plus a queue bit for a request made while still waiting for
+  an answer. Kept as bit planes indexed by option, so every lookup is
+  a shift and a mask and nothing is allocated.
+*/
+class QtTelnetOptions
+{
+public:
+    enum Side { Us = 0, Him = 1 };
+    enum State { No = 0, Yes = 1, WantNo = 2, WantYes = 3 };
+
+    QtTelnetOptions() { clear(); }
+
+    void clear() { memset(bits, 0, sizeof(bits)); }
+
+    State state(Side side, uchar option) const
+    { return State(test(side * 3, option) | (test(side * 3 + 1, option) << 1)); }
+    void setState(Side side, uchar option, State state)
+    {
+        assign(side * 3, option, state & 1);
+        assign(side * 3 + 1, option, state & 2);
+    }
+    bool isQueued(Side side, uchar option) const { return test(side * 3 + 2, option); }
+    void setQueued(Side side, uchar option, bool queued) { assign(side * 3 + 2, option, queued); }
+
+private:
+    int test(int plane, uchar option) const
+    { return (bits[plane][option >> 5] >> (option & 31)) & 1; }
+    void assign(int plane, uchar option, bool on)
+    {
+        if (on)
+            bits[plane][option >> 5] |= (1u << (option & 31));
+        else
+            bits[plane][option >> 5] &= ~(1u << (option & 31));
+    }
+
+    quint32 bits[6][8]; // state low, state high, queue; for Us and Him
+};
+
+/*
+  Aho-Corasick automaton for a handful of literal byte patterns,
+  compiled into a full transition table so that every received byte
+  costs one lookup. The state survives between reads, so a pattern
+  split across two TCP segments is still found. step() returns the
+  ids (bits) of all patterns ending at the byte just fed.
+*/
+class QtTelnetMatcher
+{
+public:
+    QtTelnetMatcher() { clear(); }
+
+    void clear()
+    {
+        next.fill(-1, 256);
+        out.fill(0, 1);
+        state = 0;
+    }
+
+    void add(const QByteArray &literal, uint id)
+    {
+        int s = 0;
+        for (int i = 0; i < literal.size(); ++i) {
+            const int c = uchar(literal.at(i));
+            if (next.at(s * 256 + c) < 0) {
+                next[s * 256 + c] = out.size();
+                out.append(0);
+                next.insert(next.size(), 256, -1);
+            }
+            s = next.at(s * 256 + c);
         }
-        return a;
+        out[s] |= id;
+    }
+
+    void build()
+    {
+        QVector<int> fail(out.size(), 0);
+        QQueue<int> pending;
+        for (int c = 0; c < 256; ++c) {
+            if (next.at(c) < 0)
+                next[c] = 0;
+            else
+                pending.enqueue(next.at(c));
+        }
+        while (!pending.isEmpty()) {
+            const int s = pending.dequeue();
+            out[s] |= out.at(fail.at(s));
+            for (int c = 0; c < 256; ++c) {
+                const int t = next.at(s * 256 + c);
+                const int f = next.at(fail.at(s) * 256 + c);
+                if (t < 0) {
+                    next[s * 256 + c] = f;
+                } else {
+                    fail[t] = f;
+                    pending.enqueue(t);
+                }
+            }
+        }
+        reset();
+    }
+
+    // Start of the stream counts as the start of a line
+    void reset() { state = next.at('\n'); }
+
+    uint step(uchar c)
+    {
+        state = next.constData()[state * 256 + c];
+        return out.constData()[state];
     }
 
 private:
-    QList<QByteArray> buffers;
-    long bytesAvailable;
+    QVector<int> next;
+    QVector<uint> out;
+    int state;
 };
 
+/*
+  Finds the plain string \a literal a regular expression stands for,
+  if it is one. A trailing "$" or "\\s*$" sets \a atEnd; anything
+  else that is not a literal character makes this return false.
+*/
+static bool literalPattern(const QRegExp &rx, QByteArray *literal, bool *atEnd)
+{
+    *atEnd = false;
+    if (rx.caseSensitivity() != Qt::CaseSensitive)
+        return false;
+    if (rx.patternSyntax() == QRegExp::FixedString) {
+        *literal = rx.pattern().toLocal8Bit();
+        return !literal->isEmpty();
+    }
+    if (rx.patternSyntax() != QRegExp::RegExp && rx.patternSyntax() != QRegExp::RegExp2)
+        return false;
+
+    QString pattern = rx.pattern();
+    if (pattern.endsWith(QLatin1String("\\s*$"))) {
+        pattern.chop(4);
+        *atEnd = true;
+    } else if (pattern.endsWith(QLatin1Char('$')) && !pattern.endsWith(QLatin1String("\\$"))) {
+        pattern.chop(1);
+        *atEnd = true;
+    }
+
+    QString text;
+    for (int i = 0; i < pattern.size(); ++i) {
+        const QChar c = pattern.at(i);
+        if (c == QLatin1Char('\\')) {
+            if (++i == pattern.size())
+                return false;
+            const QChar e = pattern.at(i);
+            if (e == QLatin1Char('n'))
+                text += QLatin1Char('\n');
+            else if (e == QLatin1Char('r'))
+                text += QLatin1Char('\r');
+            else if (e == QLatin1Char('t'))
+                text += QLatin1Char('\t');
+            else if (e.isLetterOrNumber())
+                return false;
+            else
+                text += e;
+        } else if (QString::fromLatin1(".^$|()[]{}*+?").contains(c)) {
+            return false;
+        } else {
+            text += c;
+        }
+    }
+    *literal = text.toLocal8Bit();
+    return !literal->isEmpty();
+}
+
+static inline bool onlySpace(const char *data, int length)
+{
+    for (int i = 0; i < length; ++i) {
+        const char c = data[i];
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n' && c != '\v' && c != '\f')
+            return false;
+    }
+    return true;
+}
+
 namespace Common // RFC854
 {
     // Commands
@@ -499,12 +721,12 @@ public:
     QtTelnetPrivate(QtTelnet *parent);
     ~QtTelnetPrivate();
 
-    QMap<char, bool> modes;
-    QList< QPair<uchar, uchar> > osent;
+    QtTelnetOptions options;
 
     QtTelnet *q;
     QTcpSocket *socket;
     QtTelnetReceiveBuffer buffer;
+    bool bufferhigh, drainpending;
     QSocketNotifier *notifier;
 
     QSize windowSize;
@@ -519,29 +741,73 @@ public:
     QRegExp loginp, passp, promptp;
     QString login, pass;
 
+    // Stream parser state, kept between socketReadyRead() calls so that
+    // IAC sequences split across TCP segments are resumed in place.
+    enum ParseState { StateData, StateIAC, StateOption, StateSub, StateSubIAC };
+    ParseState pstate;
+    uchar poperation;
+    QByteArray subopt;
+
+    // Command/response correlation, see QtTelnet::execute(). Replies
+    // are queued in the order their commands were written; a null entry
+    // stands for a line sent with sendData() or deleted by its owner.
+    QQueue< QPointer<QtTelnetReply> > replies;
+    QByteArray unsent;
+    QByteArray response;
+    bool promptseen;
+    int lastid;
+
+    // Prompt, login and password are found with one incremental matcher
+    // over the raw bytes while they are plain strings; other patterns
+    // are tried on the last line received. Rebuilt when a pattern changes.
+    enum MatchId { MatchPromptLF = 1, MatchPromptCR = 2, MatchLogin = 4, MatchPassword = 8,
+                   MatchPrompt = MatchPromptLF | MatchPromptCR };
+    QtTelnetMatcher matcher;
+    bool matcherdirty;
+    uint literals;
+    int promptlen;
+    bool loginend, passend;
+    QByteArray tail;
+    bool tailvalid;
+
+    // Telnet Synch from the server: text is dropped from the urgent
+    // notification up to the Data Mark. After abort() the output of the
+    // commands already written is dropped up to their prompts.
+    bool synching, marked;
+    int swallow;
+
     bool allowOption(int oper, int opt);
     void sendOptions();
     void sendCommand(const QByteArray &command);
     void sendCommand(const char *command, int length);
     void sendCommand(const char operation, const char option);
+    void sendNegotiation(uchar operation, uchar option);
     void sendString(const QString &str);
-    bool replyNeeded(uchar operation, uchar option);
-    void setMode(uchar operation, uchar option);
-    bool alreadySent(uchar operation, uchar option);
-    void addSent(uchar operation, uchar option);
+    void sendLine(const QByteArray &line);
+    void queueLines(const QStringList &lines, const QList<QtTelnetReply*> &owners);
+    void buildMatcher();
+    void updateTail(const char *data, int length);
+    void promptFound(const QByteArray &out);
+    void abortReplies();
+    void failReplies();
+    void abortCommands();
+    void dataMark();
+    void setOption(QtTelnetOptions::Side side, uchar option,
+                   QtTelnetOptions::State state);
     void sendWindowSize();
 
-    int  parsePlaintext(const QByteArray &data);
-    int parseIAC(const QByteArray &data);
+    void parsePlaintext(const char *data, int length);
+    bool parseIAC(const uchar c);
+    void parseOperation(uchar operation, uchar option);
+    void parseSubOption(const QByteArray &data);
     bool isOperation(const uchar c);
     bool isCommand(const uchar c);
-    QByteArray getSubOption(const QByteArray &data);
     void parseSubAuth(const QByteArray &data);
     void parseSubTT(const QByteArray &data);
     void parseSubNAWS(const QByteArray &data);
-    uchar opposite(uchar operation, bool positive);
 
-    void consume();
+    void fill();
+    void consume(const char *data, int size);
 
     void setSocket(QTcpSocket *socket);
 
@@ -551,14 +817,30 @@ public slots:
     void socketReadyRead();
     void socketError(QAbstractSocket::SocketError error);
     void socketException(int);
+    void drain();
 };
 
+// Receive buffer defaults: socket reads stop when the buffer is full,
+// and at most ConsumeSlice bytes are parsed per event loop pass.
+static const int ReceiveBufferSize = 64 * 1024;
+static const int ConsumeSlice = 16 * 1024;
+
+// Longest suboption accepted; the ones handled here (TTYPE, NAWS, AUTH)
+// are a few bytes. Anything longer is consumed and dropped unseen.
+static const int MaxSubOption = 256;
+
 QtTelnetPrivate::QtTelnetPrivate(QtTelnet *parent)
-    : q(parent), socket(0), notifier(0),
+    : q(parent), socket(0), buffer(ReceiveBufferSize),
+      bufferhigh(false), drainpending(false), notifier(0),
       connected(false), nocheckp(false),
       triedlogin(false), triedpass(false), firsttry(true),
       curauth(0), nullauth(false),
-      loginp("ogin:\\s*$"), passp("assword:\\s*$")
+      loginp("ogin:\\s*$"), passp("assword:\\s*$"),
+      pstate(StateData), poperation(0),
+      promptseen(false), lastid(0),
+      matcherdirty(true), literals(0), promptlen(0),
+      loginend(false), passend(false), tailvalid(true),
+      synching(false), marked(false), swallow(0)
 {
     setSocket(new QTcpSocket(this));
 }
@@ -586,68 +868,103 @@ void QtTelnetPrivate::setSocket(QTcpSocket *s)
         connect(socket, SIGNAL(readyRead()), this, SLOT(socketReadyRead()));
         connect(socket, SIGNAL(error(QAbstractSocket::SocketError)),
                 this, SLOT(socketError(QAbstractSocket::SocketError)));
+        // Bound Qt's own read buffer as well; once both are full the
+        // kernel window closes and TCP flow control throttles the server.
+        socket->setReadBufferSize(buffer.capacity());
     }
 }
 
 /*
-   Returns the opposite value of the one we pass in.
-*/
-uchar QtTelnetPrivate::opposite(uchar operation, bool positive)
-{
-    if (operation == Common::DO)
-        return (positive ? Common::WILL : Common::WONT);
-    else if (operation == Common::DONT) // Not allowed to say WILL
-        return Common::WONT;
-    else if (operation == Common::WILL)
-        return (positive ? Common::DO : Common::DONT);
-    else if (operation == Common::WONT) // Not allowed to say DO
-        return Common::DONT;
-    return 0;
-}
-
-void QtTelnetPrivate::consume()
-{
-    const QByteArray data = buffer.readAll();
-    int currpos = 0;
-    int prevpos = -1;;
-    while (prevpos < currpos && currpos < data.size()) {
-        prevpos = currpos;
-        const uchar c = uchar(data[currpos]);
-        if (c == Common::DM)
-            ++currpos;
-        else if (c == Common::IAC)
-            currpos += parseIAC(data.mid(currpos));
-        else // Assume plain text
-            currpos += parsePlaintext(data.mid(currpos));
+  Moves as much data from the socket into the receive buffer as fits.
+*/
+void QtTelnetPrivate::fill()
+{
+    while (!buffer.isFull() && socket->bytesAvailable() > 0) {
+        int length;
+        char *data = buffer.writePointer(&length);
+        const qint64 n = socket->read(data, length);
+        if (n <= 0)
+            break;
+        buffer.commit(int(n));
+    }
+    if (!bufferhigh && buffer.size() >= buffer.capacity() / 4 * 3) {
+        bufferhigh = true;
+        emit q->receiveBufferHigh();
     }
-    if (currpos < data.size())
-        buffer.push_back(data.mid(currpos));
 }
 
-bool QtTelnetPrivate::isCommand(const uchar c)
+/*
+  Parses up to ConsumeSlice bytes of the receive buffer, then yields to
+  the event loop if more is left so a flood of output cannot starve the
+  GUI. Reading from the socket resumes as space becomes free.
+*/
+void QtTelnetPrivate::drain()
 {
-    return (c == Common::DM);
+    drainpending = false;
+    int budget = ConsumeSlice;
+    while (budget > 0 && !buffer.isEmpty()) {
+        int length;
+        const char *data = buffer.readPointer(&length);
+        length = qMin(length, budget);
+        consume(data, length);
+        buffer.free(length);
+        budget -= length;
+    }
+    if (bufferhigh && buffer.size() <= buffer.capacity() / 4) {
+        bufferhigh = false;
+        emit q->receiveBufferLow();
+    }
+    if (socket && socket->bytesAvailable() > 0)
+        fill();
+    if (!buffer.isEmpty() && !drainpending) {
+        drainpending = true;
+        QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
+    }
 }
 
-bool QtTelnetPrivate::isOperation(const uchar c)
+/*
+  Walks the received bytes in place. Plain text runs are handed to
+  parsePlaintext() as pointer ranges into \a data; only the bytes of
+  IAC sequences go through the parser state, which survives the end
+  of \a data so a sequence may be split anywhere.
+*/
+void QtTelnetPrivate::consume(const char *data, int size)
 {
-    return (c == Common::WILL || c == Common::WONT
-            || c == Common::DO ||c == Common::DONT);
+    const char *end = data + size;
+    const char *text = 0;
+    for (const char *p = data; p < end; ++p) {
+        const uchar c = uchar(*p);
+        if (pstate == StateData) {
+            if (c == Common::IAC) {
+                if (text)
+                    parsePlaintext(text, p - text);
+                text = 0;
+                pstate = StateIAC;
+            } else if (c == '\0') {
+                if (text)
+                    parsePlaintext(text, p - text);
+                text = 0;
+            } else if (!text) {
+                text = p;
+            }
+        } else if (parseIAC(c)) { // IAC IAC, a literal 255 data byte
+            text = p;
+        }
+    }
+    if (text)
+        parsePlaintext(text, end - text);
 }
 
-QByteArray QtTelnetPrivate::getSubOption(const QByteArray &data)
+bool QtTelnetPrivate::isCommand(const uchar c)
 {
-    Q_ASSERT(!data.isEmpty() && uchar(data[0]) == Common::IAC);
-
-    if (data.size() < 4 || uchar(data[1]) != Common::SB)
-        return QByteArray();
+    // RFC854 commands, plus EOF, SUSP and ABORT from RFC1184
+    return (c >= Common::CEOF);
+}
 
-    for (int i = 2; i < data.size() - 1; ++i) {
-        if (uchar(data[i]) == Common::IAC && uchar(data[i+1]) == Common::SE) {
-            return data.mid(2, i-2);
-        }
-    }
-    return QByteArray();
+bool QtTelnetPrivate::isOperation(const uchar c)
+{
+    return (c == Common::WILL || c == Common::WONT
+            || c == Common::DO ||c == Common::DONT);
 }
 
 void QtTelnetPrivate::parseSubNAWS(const QByteArray &data)
@@ -674,7 +991,7 @@ void QtTelnetPrivate::parseSubAuth(const QByteArray &data)
 {
     Q_ASSERT(data[0] == Common::Authentication);
 
-    if (!curauth && data[1] == Common::SEND) {
+    if (!curauth && data.size() > 1 && data[1] == Common::SEND) {
         int pos = 2;
         while (pos < data.size() && !curauth) {
             curauth = auths[data[pos]];
@@ -711,43 +1028,127 @@ void QtTelnetPrivate::parseSubAuth(const QByteArray &data)
 }
 
 /*
-  returns number of bytes consumed
+  Feeds one byte of an IAC sequence to the parser. Returns true if the
+  byte turned out to be an escaped data byte (IAC IAC).
 */
-int QtTelnetPrivate::parseIAC(const QByteArray &data)
+bool QtTelnetPrivate::parseIAC(const uchar c)
 {
-    if (data.isEmpty())
-        return 0;
-
-    Q_ASSERT(uchar(data.at(0)) == Common::IAC);
-
-    if (data.size() >= 3 && isOperation(data[1])) { // IAC, Operation, Option
-        const uchar operation = data[1];
-        const uchar option = data[2];
-        if (operation == Common::WONT && option == Common::Logout) {
-            q->close();
-            return 3;
+    switch (pstate) {
+    case StateIAC:
+        if (c == Common::IAC) {
+            pstate = StateData;
+            return true;
         }
-        if (operation == Common::DONT && option == Common::Authentication) {
-            if (loginp.isEmpty() && passp.isEmpty())
-                emit q->loggedIn();
-            nullauth = true;
+        if (isOperation(c)) { // IAC, Operation, Option
+            poperation = c;
+            pstate = StateOption;
+        } else if (c == Common::SB) { // IAC SB Option SubOption [...] IAC SE
+            subopt.clear();
+            pstate = StateSub;
+        } else { // IAC Command
+            pstate = StateData;
+            if (c == Common::DM)
+                dataMark();
+            else if (!isCommand(c))
+                qWarning("QtTelnetPrivate::parseIAC: unknown command %d", c);
         }
-        if (replyNeeded(operation, option)) {
-            bool allowed = allowOption(operation, option);
-            sendCommand(opposite(operation, allowed), option);
-            setMode(operation, option);
+        break;
+    case StateOption:
+        pstate = StateData;
+        parseOperation(poperation, c);
+        break;
+    case StateSub:
+        if (c == Common::IAC)
+            pstate = StateSubIAC;
+        else if (subopt.size() <= MaxSubOption)
+            subopt.append(char(c));
+        break;
+    case StateSubIAC:
+        if (c == Common::IAC) {
+            if (subopt.size() <= MaxSubOption)
+                subopt.append(char(c));
+            pstate = StateSub;
+            break;
         }
-        return 3;
+        pstate = StateData;
+        if (subopt.size() > MaxSubOption)
+            qWarning("QtTelnetPrivate::parseIAC: suboption too long, dropped");
+        else if (c == Common::SE && !subopt.isEmpty())
+            parseSubOption(subopt);
+        subopt.clear();
+        break;
+    case StateData:
+        break;
     }
-    if (data.size() >= 2 && isCommand(data[1])) { // IAC Command
-        return 2;
+    return false;
+}
+
+void QtTelnetPrivate::parseOperation(uchar operation, uchar option)
+{
+    if (operation == Common::WONT && option == Common::Logout) {
+        q->close();
+        return;
+    }
+    if (operation == Common::DONT && option == Common::Authentication) {
+        if (loginp.isEmpty() && passp.isEmpty())
+            emit q->loggedIn();
+        nullauth = true;
     }
 
-    QByteArray suboption = getSubOption(data);
-    if (suboption.isEmpty())
-        return 0;
+    // RFC 1143: answer requests only when they change the state, so
+    // the two sides can never get into a negotiation loop
+    const QtTelnetOptions::Side side =
+        (operation == Common::WILL || operation == Common::WONT)
+        ? QtTelnetOptions::Him : QtTelnetOptions::Us;
+    const bool enable = (operation == Common::WILL || operation == Common::DO);
+    const uchar yes = (side == QtTelnetOptions::Him ? Common::DO : Common::WILL);
+    const uchar no = (side == QtTelnetOptions::Him ? Common::DONT : Common::WONT);
+    const bool queued = options.isQueued(side, option);
+
+    switch (options.state(side, option)) {
+    case QtTelnetOptions::No:
+        if (!enable)
+            break;
+        if (allowOption(operation, option)) {
+            sendNegotiation(yes, option);
+            setOption(side, option, QtTelnetOptions::Yes);
+        } else {
+            sendNegotiation(no, option);
+        }
+        break;
+    case QtTelnetOptions::Yes:
+        if (enable)
+            break;
+        sendNegotiation(no, option);
+        setOption(side, option, QtTelnetOptions::No);
+        break;
+    case QtTelnetOptions::WantNo:
+        options.setQueued(side, option, false);
+        if (!queued) {
+            setOption(side, option, QtTelnetOptions::No);
+        } else if (enable) {
+            setOption(side, option, QtTelnetOptions::Yes);
+        } else {
+            sendNegotiation(yes, option);
+            setOption(side, option, QtTelnetOptions::WantYes);
+        }
+        break;
+    case QtTelnetOptions::WantYes:
+        options.setQueued(side, option, false);
+        if (!enable) {
+            setOption(side, option, QtTelnetOptions::No);
+        } else if (!queued) {
+            setOption(side, option, QtTelnetOptions::Yes);
+        } else {
+            sendNegotiation(no, option);
+            setOption(side, option, QtTelnetOptions::WantNo);
+        }
+        break;
+    }
+}
 
-    // IAC SB Operation SubOption [...] IAC SE
+void QtTelnetPrivate::parseSubOption(const QByteArray &suboption)
+{
     switch (suboption[0]) {
     case Common::Authentication:
         parseSubAuth(suboption);
@@ -756,57 +1157,126 @@ int QtTelnetPrivate::parseIAC(const QByteArray &data)
         parseSubTT(suboption);
         break;
     case Common::NAWS:
-        parseSubNAWS(data);
+        parseSubNAWS(suboption);
         break;
     default:
-        qWarning("QtTelnetPrivate::parseIAC: unknown suboption %d",
+        qWarning("QtTelnetPrivate::parseSubOption: unknown suboption %d",
                  quint8(suboption.at(0)));
         break;
     }
-    return suboption.size() + 4;
 }
 
-int QtTelnetPrivate::parsePlaintext(const QByteArray &data)
+void QtTelnetPrivate::parsePlaintext(const char *data, int length)
 {
-    int consumed = 0;
-    int length = data.indexOf('\0');
-    if (length == -1) {
-        length = data.size();
-        consumed = length;
-    } else {
-        consumed = length + 1; // + 1 for removing '\0'
+    if (matcherdirty)
+        buildMatcher();
+
+    // Between an urgent notification and its Data Mark, text is noise
+    if (synching)
+        return;
+
+    // Output of aborted commands ends with their prompts
+    if (swallow > 0) {
+        int i = 0;
+        while (i < length && swallow > 0) {
+            if (matcher.step(uchar(data[i++])) & MatchPrompt)
+                --swallow;
+        }
+        data += i;
+        length -= i;
+        if (length == 0)
+            return;
     }
 
-    QString text = QString::fromLocal8Bit(data.constData(), length);
+    if (q->receivers(SIGNAL(rawMessage(QByteArray))) > 0)
+        emit q->rawMessage(QByteArray(data, length));
+
+    const bool checkp = !nocheckp && nullauth;
+    const bool correlate = !promptp.isEmpty()
+                           && (!promptseen || !replies.isEmpty());
+    if (correlate)
+        response.append(data, length);
+    int base = response.size() - length; // where data starts in response
+
+    bool prompt = false, loginseen = false, passseen = false;
+    for (int i = 0; i < length; ++i) {
+        const uint hit = matcher.step(uchar(data[i]));
+        if (!hit)
+            continue;
+        if (hit & MatchPrompt) {
+            prompt = true;
+            if (correlate) {
+                const int end = base + i + 1;
+                promptFound(response.left(qMax(0, end - promptlen)));
+                response.remove(0, end);
+                base -= end;
+            }
+        }
+        if ((hit & MatchLogin) && (!loginend || onlySpace(data + i + 1, length - i - 1)))
+            loginseen = true;
+        if ((hit & MatchPassword) && (!passend || onlySpace(data + i + 1, length - i - 1)))
+            passseen = true;
+    }
 
-    if (!nocheckp && nullauth) {
-        if (!promptp.isEmpty() && promptp.indexIn(text) != -1) {
-            emit q->loggedIn();
-            nocheckp = true;
+    // Patterns that are not plain strings are tried on the last line
+    const bool promptrx = !promptp.isEmpty() && !(literals & MatchPrompt);
+    const bool loginrx = checkp && ((!loginp.isEmpty() && !(literals & MatchLogin))
+                                    || (!passp.isEmpty() && !(literals & MatchPassword)));
+    if (promptrx || loginrx) {
+        updateTail(data, length);
+        if (tailvalid && !tail.isEmpty()) {
+            const QString line = QString::fromLocal8Bit(tail.constData(), tail.size());
+            if (promptrx && promptp.indexIn(line) == 0) {
+                prompt = true;
+                if (correlate) {
+                    promptFound(response.left(qMax(0, response.size() - tail.size())));
+                    response.clear();
+                }
+                tailvalid = false; // until the next line
+            }
+            if (loginrx && !(literals & MatchLogin) && loginp.indexIn(line) != -1)
+                loginseen = true;
+            if (loginrx && !(literals & MatchPassword) && passp.indexIn(line) != -1)
+                passseen = true;
         }
     }
+
+    // Nothing is waiting, so drop what came in between commands
+    if (correlate && promptseen && replies.isEmpty())
+        response.clear();
+
+    // Only decode if someone is going to look at the text
+    const bool show = q->receivers(SIGNAL(message(QString))) > 0;
+    bool shown = false;
+
+    if (checkp && prompt) {
+        emit q->loggedIn();
+        nocheckp = true;
+    }
     if (!nocheckp && nullauth) {
-        if (!loginp.isEmpty() && loginp.indexIn(text) != -1) {
+        if (loginseen) {
             if (triedlogin || firsttry) {
-                emit q->message(text);    // Display the login prompt
-                text.clear();
+                if (show && !shown)
+                    emit q->message(QString::fromLocal8Bit(data, length)); // Display the login prompt
+                shown = true;
                 emit q->loginRequired();  // Get a (new) login
                 firsttry = false;
             }
             if (!triedlogin) {
-                q->sendData(login);
+                sendLine(login.toLocal8Bit());
                 triedlogin = true;
             }
         }
-        if (!passp.isEmpty() && passp.indexIn(text) != -1) {
+        if (passseen) {
             if (triedpass || firsttry) {
-                emit q->message(text);    // Display the password prompt
-                text.clear();
+                if (show && !shown)
+                    emit q->message(QString::fromLocal8Bit(data, length)); // Display the password prompt
+                shown = true;
                 emit q->loginRequired();  // Get a (new) pass
                 firsttry = false;
             }
             if (!triedpass) {
-                q->sendData(pass);
+                sendLine(pass.toLocal8Bit());
                 triedpass = true;
                 // We don't have to store the password anymore
                 pass.fill(' ');
@@ -815,37 +1285,75 @@ int QtTelnetPrivate::parsePlaintext(const QByteArray &data)
         }
     }
 
-    if (!text.isEmpty())
-        emit q->message(text);
-    return consumed;
+    if (show && !shown)
+        emit q->message(QString::fromLocal8Bit(data, length));
 }
 
-bool QtTelnetPrivate::replyNeeded(uchar operation, uchar option)
+/*
+  Compiles the prompt, login and password patterns that are plain
+  strings into the matcher. The prompt only counts at the start of a
+  line, so it is added once after a line feed and once after a
+  carriage return.
+*/
+void QtTelnetPrivate::buildMatcher()
 {
-    if (operation == Common::DO || operation == Common::DONT) {
-        // RFC854 requires that we don't acknowledge
-        // requests to enter a mode we're already in
-        if (operation == Common::DO && modes[option])
-            return false;
-        if (operation == Common::DONT && !modes[option])
-            return false;
+    QByteArray literal;
+    bool atend;
+
+    matcher.clear();
+    literals = 0;
+    promptlen = 0;
+    if (!promptp.isEmpty() && literalPattern(promptp, &literal, &atend) && !atend) {
+        matcher.add('\n' + literal, MatchPromptLF);
+        matcher.add('\r' + literal, MatchPromptCR);
+        promptlen = literal.size();
+        literals |= MatchPrompt;
     }
-    return true;
+    if (!loginp.isEmpty() && literalPattern(loginp, &literal, &loginend)) {
+        matcher.add(literal, MatchLogin);
+        literals |= MatchLogin;
+    }
+    if (!passp.isEmpty() && literalPattern(passp, &literal, &passend)) {
+        matcher.add(literal, MatchPassword);
+        literals |= MatchPassword;
+    }
+    matcher.build();
+    matcherdirty = false;
 }
 
-void QtTelnetPrivate::setMode(uchar operation, uchar option)
+/*
+  Keeps the bytes received since the last line feed, up to a limit;
+  a longer line is no prompt and is skipped until the next one.
+*/
+void QtTelnetPrivate::updateTail(const char *data, int length)
 {
-    if (operation != Common::DO && operation != Common::DONT)
-        return;
+    int i = length;
+    while (i > 0 && data[i - 1] != '\n')
+        --i;
+    if (i > 0) {
+        tail = QByteArray(data + i, length - i);
+        tailvalid = true;
+    } else if (tailvalid) {
+        tail.append(data, length);
+    }
+    if (tail.size() > 256) {
+        tail.clear();
+        tailvalid = false;
+    }
+}
 
-    modes[option] = (operation == Common::DO);
-    if (option == Common::NAWS && modes[Common::NAWS])
+void QtTelnetPrivate::setOption(QtTelnetOptions::Side side, uchar option,
+                                QtTelnetOptions::State state)
+{
+    options.setState(side, option, state);
+    if (side == QtTelnetOptions::Us && option == Common::NAWS
+        && state == QtTelnetOptions::Yes)
         sendWindowSize();
 }
 
 void QtTelnetPrivate::sendWindowSize()
 {
-    if (!modes[Common::NAWS])
+    if (options.state(QtTelnetOptions::Us, Common::NAWS) != QtTelnetOptions::Yes)
         return;
     if (!q->isValidWindowSize())
         return;
@@ -858,27 +1366,132 @@ void QtTelnetPrivate::sendWindowSize()
     sendCommand(c, sizeof(c));
 }
 
-void QtTelnetPrivate::addSent(uchar operation, uchar option)
+void QtTelnetPrivate::sendString(const QString &str)
 {
-    osent.append(QPair<uchar, uchar>(operation, option));
+    if (!connected || str.length() == 0)
+        return;
+
+    socket->write(str.toLocal8Bit());
 }
 
-bool QtTelnetPrivate::alreadySent(uchar operation, uchar option)
+void QtTelnetPrivate::sendLine(const QByteArray &line)
 {
-    QPair<uchar, uchar> value(operation, option);
-    if (osent.contains(value)) {
-        osent.removeAll(value);
-        return true;
-    }
-    return false;
+    if (!connected)
+        return;
+
+    // One write per line, the terminator must not end up in a
+    // segment of its own
+    QByteArray data(line);
+    data.append("\r\n\0", 3);
+    socket->write(data);
 }
 
-void QtTelnetPrivate::sendString(const QString &str)
+/*
+  Writes the command \a lines with a single write and queues the
+  matching \a owners (entries may be 0) to receive the text up to the
+  next prompt each. Until the server has shown its first prompt lines
+  are held back, so the banner is not taken for a response.
+*/
+void QtTelnetPrivate::queueLines(const QStringList &lines,
+                                 const QList<QtTelnetReply*> &owners)
 {
-    if (!connected || str.length() == 0)
+    if (!connected || lines.isEmpty())
         return;
 
-    socket->write(str.toLocal8Bit());
+    QByteArray data;
+    for (int i = 0; i < lines.size(); ++i) {
+        data += lines.at(i).toLocal8Bit();
+        data.append("\r\n\0", 3);
+    }
+    if (promptp.isEmpty()) {
+        socket->write(data);
+        return;
+    }
+
+    for (int i = 0; i < owners.size(); ++i)
+        replies.enqueue(owners.at(i));
+    if (!promptseen) {
+        unsent += data;
+        return;
+    }
+    for (int i = 0; i < owners.size(); ++i)
+        if (owners.at(i))
+            owners.at(i)->start();
+    socket->write(data);
+}
+
+/*
+  Called for every prompt while commands are being correlated, with
+  what the server sent since the previous one.
+*/
+void QtTelnetPrivate::promptFound(const QByteArray &out)
+{
+    if (!promptseen) {
+        // The banner is done, release what was written so far
+        promptseen = true;
+        for (int i = 0; i < replies.size(); ++i)
+            if (replies.at(i))
+                replies.at(i)->start();
+        socket->write(unsent);
+        unsent.clear();
+    } else if (!replies.isEmpty()) {
+        QPointer<QtTelnetReply> reply = replies.dequeue();
+        if (reply)
+            reply->finish(out, false);
+    }
+}
+
+/*
+  Finishes all outstanding replies after the connection went away.
+*/
+void QtTelnetPrivate::abortReplies()
+{
+    promptseen = false;
+    swallow = 0;
+    failReplies();
+}
+
+void QtTelnetPrivate::failReplies()
+{
+    QQueue< QPointer<QtTelnetReply> > pending = replies;
+    replies.clear();
+    unsent.clear();
+    response.clear();
+    while (!pending.isEmpty()) {
+        QPointer<QtTelnetReply> reply = pending.dequeue();
+        if (reply)
+            reply->finish(QByteArray(), true);
+    }
+}
+
+/*
+  Gives up on all commands not answered yet. The server still owes a
+  prompt for each one already written; their output is skipped up to
+  the last of these, so it can be parsed away without being decoded.
+*/
+void QtTelnetPrivate::abortCommands()
+{
+    if (promptseen && (literals & MatchPrompt))
+        swallow += replies.size();
+    failReplies();
+}
+
+/*
+  IAC DM in the data stream. If it ends a Synch, text is shown again;
+  if it came first, the urgent notification is still to follow and
+  must not start a new Synch. Both arrive in the same event loop pass,
+  so the next read ends that wait; a DM sent without urgent data must
+  not swallow the notification of a later Synch.
+*/
+void QtTelnetPrivate::dataMark()
+{
+    if (synching) {
+        synching = false;
+        if (notifier)
+            notifier->setEnabled(true);
+    } else {
+        marked = true;
+    }
 }
 
 void QtTelnetPrivate::sendCommand(const QByteArray &command)
@@ -886,19 +1499,51 @@ void QtTelnetPrivate::sendCommand(const QByteArray &command)
     if (!connected || command.isEmpty())
         return;
 
-    if (command.size() == 3) {
-        const char operation = command.at(1);
-        const char option = command.at(2);
-        if (alreadySent(operation, option))
-            return;
-        addSent(operation, option);
-    }
     socket->write(command);
 }
 
+/*
+  Asks to enable (WILL, DO) or disable (WONT, DONT) an option. Per
+  RFC 1143 nothing is sent if the option is already in, or on its way
+  to, that state; a request made while waiting for an answer is queued.
+*/
 void QtTelnetPrivate::sendCommand(const char operation, const char option)
 {
-    const char c[3] = { Common::IAC, operation, option };
+    if (!connected)
+        return;
+
+    const uchar op = operation;
+    const uchar opt = option;
+    const QtTelnetOptions::Side side =
+        (op == Common::DO || op == Common::DONT)
+        ? QtTelnetOptions::Him : QtTelnetOptions::Us;
+    const bool enable = (op == Common::WILL || op == Common::DO);
+
+    switch (options.state(side, opt)) {
+    case QtTelnetOptions::No:
+        if (enable) {
+            options.setState(side, opt, QtTelnetOptions::WantYes);
+            sendNegotiation(op, opt);
+        }
+        break;
+    case QtTelnetOptions::Yes:
+        if (!enable) {
+            options.setState(side, opt, QtTelnetOptions::WantNo);
+            sendNegotiation(op, opt);
+        }
+        break;
+    case QtTelnetOptions::WantNo:
+        options.setQueued(side, opt, enable);
+        break;
+    case QtTelnetOptions::WantYes:
+        options.setQueued(side, opt, !enable);
+        break;
+    }
+}
+
+void QtTelnetPrivate::sendNegotiation(uchar operation, uchar option)
+{
+    const char c[3] = { Common::IAC, char(operation), char(option) };
     sendCommand(c, 3);
 }
 
@@ -935,7 +1580,24 @@ void QtTelnetPrivate::sendOptions()
 void QtTelnetPrivate::socketConnected()
 {
     connected = true;
+    buffer.clear();
+    bufferhigh = false;
+    pstate = StateData;
+    options.clear();
+    promptseen = false;
+    response.clear();
+    matcher.reset();
+    tail.clear();
+    tailvalid = true;
+    synching = marked = false;
+    swallow = 0;
+    // Commands are short and answered one by one, don't let Nagle
+    // hold them back waiting for an ACK
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
     delete notifier;
+    const int on = 1;
+    ::setsockopt(socket->socketDescriptor(), SOL_SOCKET, SO_OOBINLINE,
+                 (const char *)&on, sizeof(on));
     notifier = new QSocketNotifier(socket->socketDescriptor(),
                                    QSocketNotifier::Exception, this);
     connect(notifier, SIGNAL(activated(int)),
@@ -945,7 +1607,16 @@ void QtTelnetPrivate::socketConnected()
 
 void QtTelnetPrivate::socketException(int)
 {
-    // qDebug("out-of-band data received, should handle that here!");
+    // Urgent data: the server sent a Synch. The Data Mark stays in the
+    // stream (SO_OOBINLINE); drop text until it has been parsed. The
+    // exception condition lasts until the mark was read, so stop
+    // listening for it meanwhile.
+    if (marked) {
+        marked = false;
+        return;
+    }
+    synching = true;
+    notifier->setEnabled(false);
 }
 
 void QtTelnetPrivate::socketConnectionClosed()
@@ -953,13 +1624,16 @@ void QtTelnetPrivate::socketConnectionClosed()
     delete notifier;
     notifier = 0;
     connected = false;
+    abortReplies();
     emit q->loggedOut();
 }
 
 void QtTelnetPrivate::socketReadyRead()
 {
-    buffer.append(socket->readAll());
-    consume();
+    marked = false;
+    fill();
+    if (!drainpending)
+        drain();
 }
 
 void QtTelnetPrivate::socketError(QAbstractSocket::SocketError error)
@@ -1060,6 +1734,7 @@ void QtTelnet::close()
     d->notifier = 0;
     d->connected = false;
     d->socket->close();
+    d->abortReplies();
     emit loggedOut();
 }
 
@@ -1120,16 +1795,83 @@ void QtTelnet::sendControl(Control ctrl)
     Sends the string \a data to the Telnet server. This is often a
     command the Telnet server will execute.
 
-    \sa sendControl()
+    If a prompt pattern is set the line takes its place in the queue
+    of commands, so its output is not mistaken for the response to a
+    later execute().
+
+    \sa sendControl() execute()
 */
 void QtTelnet::sendData(const QString &data)
 {
     if (!d->connected)
         return;
 
-    QByteArray str = data.toLocal8Bit();
-    d->socket->write(str);
-    d->socket->write("\r\n\0", 3);
+    d->queueLines(QStringList(data), QList<QtTelnetReply*>() << 0);
+}
+
+/*!
+    Sends \a command to the Telnet server and returns a reply object
+    that collects its response.
+
+    The response is everything the server sends after the command up to
+    the next line starting with the prompt set by setPromptPattern();
+    the echoed command line is left out. Commands may be issued without
+    waiting for earlier ones, they are answered in order. The reply's
+    finished() signal is emitted once the prompt has been seen, or with
+    isAborted() set if the connection is closed first or no prompt
+    pattern is set.
+
+    The reply is owned by the QtTelnet object; call deleteLater() on it
+    when you are done with it.
+
+    \sa sendData(), pendingReplies()
+*/
+QtTelnetReply *QtTelnet::execute(const QString &command)
+{
+    QtTelnetReply *reply = new QtTelnetReply(++d->lastid, command, this);
+    if (!d->connected || d->promptp.isEmpty()) {
+        reply->abrt = reply->done = true;
+        QMetaObject::invokeMethod(reply, "finished", Qt::QueuedConnection);
+        return reply;
+    }
+    d->queueLines(QStringList(command), QList<QtTelnetReply*>() << reply);
+    return reply;
+}
+
+/*!
+    \overload
+
+    Sends all \a commands to the Telnet server with a single write and
+    returns one reply per command, in the same order. The server still
+    answers the commands one after the other, but they travel in as
+    few TCP segments as possible instead of one or more per command.
+
+    \sa sendData()
+*/
+QList<QtTelnetReply*> QtTelnet::execute(const QStringList &commands)
+{
+    QList<QtTelnetReply*> batch;
+    for (int i = 0; i < commands.size(); ++i) {
+        QtTelnetReply *reply = new QtTelnetReply(++d->lastid, commands.at(i), this);
+        if (!d->connected || d->promptp.isEmpty()) {
+            reply->abrt = reply->done = true;
+            QMetaObject::invokeMethod(reply, "finished", Qt::QueuedConnection);
+        }
+        batch.append(reply);
+    }
+    if (d->connected && !d->promptp.isEmpty())
+        d->queueLines(commands, batch);
+    return batch;
+}
+
+/*!
+    Returns the number of commands still waiting for their prompt.
+
+    \sa execute()
+*/
+int QtTelnet::pendingReplies() const
+{
+    return d->replies.size();
 }
 
 /*!
@@ -1186,7 +1928,8 @@ void QtTelnet::setWindowSize(int width, int height)
 */
 QSize QtTelnet::windowSize() const
 {
-    return (d->modes[Common::NAWS] ? d->windowSize : QSize());
+    return (d->options.state(QtTelnetOptions::Us, Common::NAWS) == QtTelnetOptions::Yes
+            ? d->windowSize : QSize());
 }
 
 /*!
@@ -1238,6 +1981,8 @@ void QtTelnet::sendSync()
 {
     if (!d->connected)
         return;
+    const char iac = (char)Common::IAC;
+    d->socket->write(&iac, 1);
     d->socket->flush(); // Force the socket to send all the pending data before
                         // sending the SYNC sequence.
     int s = d->socket->socketDescriptor();
@@ -1245,18 +1990,85 @@ void QtTelnet::sendSync()
     ::send(s, &tosend, 1, MSG_OOB); // Send the DATA MARK as out-of-band
 }
 
+/*!
+    Interrupts the command the server is running and gives up on all
+    commands that have not been answered yet.
+
+    Sends \c IP followed by the Telnet \c SYNC sequence, like
+    sendControl(InterruptProcess). Replies returned by execute() that
+    are still pending finish with isAborted() set; the output still
+    arriving for commands already written is discarded up to their
+    prompts instead of being delivered by message() and rawMessage().
+
+    \sa sendControl(), execute()
+*/
+void QtTelnet::abort()
+{
+    if (!d->connected)
+        return;
+    sendControl(InterruptProcess);
+    d->abortCommands();
+}
+
 /*!
     Sets the expected shell prompt pattern.
 
     The \a pattern is used to automatically recognize when the client
     has successfully logged in. When a line is read that matches the
-    \a pattern, the loggedIn() signal will be emitted.
+    \a pattern, the loggedIn() signal will be emitted. The prompt also
+    delimits the responses collected by execute().
 
-    \sa login(), loggedIn()
+    \sa login(), loggedIn(), execute()
 */
 void QtTelnet::setPromptPattern(const QRegExp &pattern)
 {
     d->promptp = pattern;
+    d->matcherdirty = true;
+    // A banner already shown will not come again
+    if (d->connected)
+        d->promptseen = true;
+}
+
+/*!
+    Sets the capacity of the receive buffer to \a bytes.
+
+    Received data is staged in a fixed-size buffer before it is parsed.
+    When the buffer is full QtTelnet stops reading from the socket, so
+    a server producing output faster than it can be handled is
+    throttled by TCP flow control instead of growing memory use.
+
+    Data that has been received but not yet parsed is never discarded;
+    if it does not fit into \a bytes, the buffer keeps just enough room
+    for it.
+
+    \sa receiveBufferCapacity(), receiveBufferSize()
+*/
+void QtTelnet::setReceiveBufferCapacity(int bytes)
+{
+    if (bytes <= 0)
+        return;
+    d->buffer.setCapacity(bytes);
+    d->socket->setReadBufferSize(bytes);
+}
+
+/*!
+    Returns the capacity of the receive buffer in bytes.
+
+    \sa setReceiveBufferCapacity()
+*/
+int QtTelnet::receiveBufferCapacity() const
+{
+    return d->buffer.capacity();
+}
+
+/*!
+    Returns the number of received bytes waiting to be parsed.
+
+    \sa receiveBufferHigh(), receiveBufferLow()
+*/
+int QtTelnet::receiveBufferSize() const
+{
+    return d->buffer.size();
 }
 
 /*!
@@ -1279,6 +2091,7 @@ void QtTelnet::setPromptPattern(const QRegExp &pattern)
 void QtTelnet::setLoginPattern(const QRegExp &pattern)
 {
     d->loginp = pattern;
+    d->matcherdirty = true;
 }
 
 /*!
@@ -1301,6 +2114,7 @@ void QtTelnet::setLoginPattern(const QRegExp &pattern)
 void QtTelnet::setPasswordPattern(const QRegExp &pattern)
 {
     d->passp = pattern;
+    d->matcherdirty = true;
 }
 
 /*!
@@ -1390,5 +2204,149 @@ void QtTelnet::login(const QString &username, const QString &password)
     \sa sendData()
 */
 
+/*!
+    \fn void QtTelnet::rawMessage(const QByteArray &data)
+
+    This signal is emitted together with message() and carries
+    the received \a data undecoded, as sent by the server. Text
+    is only decoded for message() if that signal is connected.
+
+    \sa message()
+*/
+
+/*!
+    \fn void QtTelnet::receiveBufferHigh()
+
+    This signal is emitted when the receive buffer fills up to
+    three quarters of its capacity. Reading from the socket stops
+    once the buffer is full.
+
+    \sa receiveBufferLow(), receiveBufferSize()
+*/
+
+/*!
+    \fn void QtTelnet::receiveBufferLow()
+
+    This signal is emitted when the receive buffer has drained
+    below a quarter of its capacity after receiveBufferHigh().
+
+    \sa receiveBufferHigh(), receiveBufferSize()
+*/
+
+/*!
+    \class QtTelnetReply
+    \brief The QtTelnetReply class holds the response to a command
+    sent with QtTelnet::execute().
+
+    A reply is created for every call to QtTelnet::execute(). Once the
+    server shows its prompt again the collected response() is available
+    and finished() is emitted. latency() tells how long the server took
+    from the command being written until the prompt was read.
+*/
+
+QtTelnetReply::QtTelnetReply(int id, const QString &command, QObject *parent)
+    : QObject(parent), rid(id), cmd(command),
+      done(false), abrt(false), usecs(-1)
+{
+}
+
+/*!
+    Destroys the reply. A command still running on the server will
+    finish, but its response is discarded.
+*/
+QtTelnetReply::~QtTelnetReply()
+{
+}
+
+void QtTelnetReply::start()
+{
+    timer.start();
+}
+
+void QtTelnetReply::finish(const QByteArray &response, bool aborted)
+{
+    if (done)
+        return;
+    if (timer.isValid())
+        usecs = timer.nsecsElapsed() / 1000;
+
+    resp = QString::fromLocal8Bit(response);
+    resp.remove(QLatin1Char('\r'));
+    // Leave out the echo of the command line itself
+    const int eol = resp.indexOf(QLatin1Char('\n'));
+    if (eol != -1 && resp.left(eol).trimmed() == cmd.trimmed())
+        resp.remove(0, eol + 1);
+
+    done = true;
+    abrt = aborted;
+    emit finished();
+}
+
+/*!
+    Returns the sequence number of the command. Numbers increase by
+    one with every call to QtTelnet::execute().
+*/
+int QtTelnetReply::id() const
+{
+    return rid;
+}
+
+/*!
+    Returns the command line this reply belongs to.
+*/
+QString QtTelnetReply::command() const
+{
+    return cmd;
+}
+
+/*!
+    Returns the text the server sent in response to command(), or an
+    empty string while the reply is not finished.
+
+    \sa isFinished()
+*/
+QString QtTelnetReply::response() const
+{
+    return resp;
+}
+
+/*!
+    Returns true once the prompt following the command has been read
+    or the reply was aborted.
+
+    \sa finished(), isAborted()
+*/
+bool QtTelnetReply::isFinished() const
+{
+    return done;
+}
+
+/*!
+    Returns true if the connection was closed before the response was
+    complete.
+*/
+bool QtTelnetReply::isAborted() const
+{
+    return abrt;
+}
+
+/*!
+    Returns the time in microseconds from writing the command until
+    its prompt was read, or -1 if the command was never written.
+*/
+qint64 QtTelnetReply::latency() const
+{
+    return usecs;
+}
+
+/*!
+    \fn void QtTelnetReply::finished()
+
+    This signal is emitted once the response is complete or the
+    reply was aborted.
+
+    \sa isFinished()
+*/
+
 #include "qttelnet.moc"
 
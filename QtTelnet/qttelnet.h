@@ -49,8 +49,10 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 #include <QtCore/QSize>
 #include <QtCore/QRegExp>
+#include <QtCore/QElapsedTimer>
 #include <QtNetwork/QTcpSocket>
 
 class QtTelnetPrivate;
@@ -71,6 +73,36 @@ class QtTelnetPrivate;
 #  define QT_QTTELNET_EXPORT
 #endif
 
+class QT_QTTELNET_EXPORT QtTelnetReply : public QObject
+{
+    Q_OBJECT
+    friend class QtTelnet;
+    friend class QtTelnetPrivate;
+public:
+    ~QtTelnetReply();
+
+    int id() const;
+    QString command() const;
+    QString response() const;
+    bool isFinished() const;
+    bool isAborted() const;
+    qint64 latency() const; // In microseconds
+
+Q_SIGNALS:
+    void finished();
+
+private:
+    QtTelnetReply(int id, const QString &command, QObject *parent);
+    void start();
+    void finish(const QByteArray &response, bool aborted);
+
+    int rid;
+    QString cmd, resp;
+    bool done, abrt;
+    QElapsedTimer timer;
+    qint64 usecs;
+};
+
 class QT_QTTELNET_EXPORT QtTelnet : public QObject
 {
     Q_OBJECT
@@ -98,12 +130,21 @@ public:
     void setPromptPattern(const QRegExp &pattern);
     void setPromptString(const QString &pattern)
     { setPromptPattern(QRegExp(QRegExp::escape(pattern))); }
+
+    void setReceiveBufferCapacity(int bytes);
+    int receiveBufferCapacity() const;
+    int receiveBufferSize() const;
+
+    QtTelnetReply *execute(const QString &command);
+    QList<QtTelnetReply*> execute(const QStringList &commands);
+    int pendingReplies() const;
 public Q_SLOTS:
     void close();
     void logout();
     void sendControl(Control ctrl);
     void sendData(const QString &data);
     void sendSync();
+    void abort();
 
 Q_SIGNALS:
     void loginRequired();
@@ -112,6 +153,9 @@ Q_SIGNALS:
     void loggedOut();
     void connectionError(QAbstractSocket::SocketError error);
     void message(const QString &data);
+    void rawMessage(const QByteArray &data);
+    void receiveBufferHigh();
+    void receiveBufferLow();
 
 public:
     void setLoginPattern(const QRegExp &pattern);
@@ -0,0 +1,130 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ansifilter.h"
+#include <QTextCodec>
+#include <QTextDecoder>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static const char ESC = 0x1b;
+static const char BEL = 0x07;
+static const int MaxSequence = 256;	// give up on unterminated sequences
+
+
+// index of the first ESC or CR in data, size if there is none
+static int findSpecial(const char *data, int size)
+{
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i esc = _mm_set1_epi8(ESC);
+    const __m128i cr = _mm_set1_epi8('\r');
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, esc), _mm_cmpeq_epi8(v, cr)));
+        if (mask)
+        {
+            while (!(mask & 1))
+            {
+                mask >>= 1;
+                ++i;
+            }
+            return i;
+        }
+    }
+#endif
+    for (; i < size; ++i)
+        if (data[i] == ESC || data[i] == '\r')
+            return i;
+    return size;
+}
+
+
+AnsiFilter::AnsiFilter() : state(Text), seqLength(0)
+{
+    decoder = QTextCodec::codecForLocale()->makeDecoder();
+}
+
+AnsiFilter::~AnsiFilter()
+{
+    delete decoder;
+}
+
+void AnsiFilter::reset()
+{
+    state = Text;
+    seqLength = 0;
+    delete decoder;
+    decoder = QTextCodec::codecForLocale()->makeDecoder();
+}
+
+QByteArray AnsiFilter::filter(const char *data, int size)
+{
+    QByteArray out;
+    out.reserve(size);
+
+    const char *p = data;
+    const char *end = data + size;
+    while (p < end)
+    {
+        if (state == Text)	// copy everything up to the next ESC or CR at once
+        {
+            int n = findSpecial(p, end - p);
+            out.append(p, n);
+            p += n;
+            if (p == end)
+                break;
+            if (*p++ == ESC)
+            {
+                state = Escape;
+                seqLength = 0;
+            }
+            continue;
+        }
+
+        const uchar c = uchar(*p++);
+        if (++seqLength > MaxSequence)
+            state = Text;
+        else if (state == Escape)
+            state = (c == '[') ? Csi : (c == ']') ? Osc : (c == uchar(ESC)) ? Escape : Text;
+        else if (state == Csi && c >= 0x40 && c <= 0x7e)	// final byte
+            state = Text;
+        else if (state == Csi && c < 0x20)	// control inside a sequence ends it
+        {
+            state = (c == uchar(ESC)) ? Escape : Text;
+            seqLength = 0;
+            if (state == Text && c != '\r')
+                out.append(char(c));
+        }
+        else if (state == Osc && c == uchar(BEL))
+            state = Text;
+        else if (state == Osc && c == uchar(ESC))
+            state = OscEscape;
+        else if (state == OscEscape)
+            state = (c == '\\') ? Text : Osc;
+    }
+    return out;
+}
+
+QString AnsiFilter::toUnicode(const QByteArray &data)
+{
+    return decoder->toUnicode(filter(data));
+}
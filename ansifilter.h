@@ -0,0 +1,51 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ANSIFILTER_H
+#define ANSIFILTER_H
+
+#include <QByteArray>
+#include <QString>
+
+class QTextDecoder;
+
+// Removes carriage returns and terminal escape sequences (CSI, OSC and
+// two byte ESC sequences) from a byte stream. A sequence cut off at the
+// end of one chunk is remembered and dropped from the next.
+class AnsiFilter
+{
+public:
+    AnsiFilter();
+    ~AnsiFilter();
+
+    QByteArray filter(const char *data, int size);
+    QByteArray filter(const QByteArray &data) { return filter(data.constData(), data.size()); }
+    QString toUnicode(const QByteArray &data);
+    void reset();
+
+private:
+    AnsiFilter(const AnsiFilter &);
+    AnsiFilter &operator=(const AnsiFilter &);
+
+    enum State { Text, Escape, Csi, Osc, OscEscape };
+    State state;
+    int seqLength;
+    QTextDecoder *decoder;	// keeps multibyte characters split across chunks
+};
+
+#endif // ANSIFILTER_H
@@ -0,0 +1,453 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "batch.h"
+#include "ocdtransport.h"
+#include "ocdsupervisor.h"
+#include "gdbremote.h"
+#include "targetflow.h"
+#include <QCoreApplication>
+#include <QTimer>
+#include <QFile>
+#include <QTextStream>
+#include <cstdio>
+#include <cstring>
+
+static const int ConnectRetries = 25;	// of 200 ms while a started openOCD comes up
+
+static const char usage[] =
+    "usage: OpenOCD-QtGUI --batch [options] step...\n"
+    "options:\n"
+    "  --profile FILE   target profile (default openocd-qtgui.conf)\n"
+    "  --host HOST      openOCD server (default localhost)\n"
+    "  --port PORT      Tcl RPC port (default 6666, 4444 with --telnet)\n"
+    "  --telnet         talk to the telnet server instead of Tcl RPC\n"
+    "  --openocd CFG    start openOCD with this config and connect to it\n"
+    "  --erase          erase the sectors written by flash steps\n"
+    "  --delta          flash only the sectors that differ on target\n"
+    "  --gdb PORT       load RAM over this gdb port (the one of --openocd)\n"
+    "  --timeout SEC    limit for each command (default 120)\n"
+    "  --script FILE    read steps from FILE, one per line\n"
+    "steps: halt softreset reset resume poll probe info unlock erase\n"
+    "       remap resetcpu resetperiph\n"
+    "       flash FILE  ram FILE  verify FILE  cmd TEXT\n"
+    "exit codes: 0 passed, 1 command failed, 2 usage, 3 no connection, 4 bad image\n";
+
+
+// One event as a JSON object on a line of its own.
+class JsonLine
+{
+public:
+    JsonLine(const char *event) : line("{\"event\":" + quote(event)) {}
+
+    JsonLine &text(const char *key, const QString &value)
+    {
+        line += QString(",\"%1\":").arg(key) + quote(value);
+        return *this;
+    }
+    JsonLine &number(const char *key, qint64 value)
+    {
+        line += QString(",\"%1\":%2").arg(key).arg(value);
+        return *this;
+    }
+    JsonLine &real(const char *key, double value)
+    {
+        line += QString(",\"%1\":%2").arg(key).arg(value, 0, 'f', 1);
+        return *this;
+    }
+    JsonLine &flag(const char *key, bool value)
+    {
+        line += QString(",\"%1\":%2").arg(key).arg(value ? "true" : "false");
+        return *this;
+    }
+    void print() const
+    {
+        QByteArray data = (line + "}\n").toUtf8();
+        fwrite(data.constData(), 1, data.size(), stdout);
+        fflush(stdout);
+    }
+
+private:
+    static QString quote(const QString &value)
+    {
+        QString result = "\"";
+        for (int i = 0; i < value.size(); i++)
+        {
+            QChar c = value.at(i);
+            if (c == '"' || c == '\\')
+                result += QString("\\") + c;
+            else if (c == '\n')
+                result += "\\n";
+            else if (c == '\t')
+                result += "\\t";
+            else if (c.unicode() < 0x20)
+                result += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+            else
+                result += c;
+        }
+        return result + "\"";
+    }
+
+    QString line;
+};
+
+
+static bool loadStep(const QString &name, TargetFlow::Load *what) // the steps that take an image
+{
+    if (name == "flash")
+        *what = TargetFlow::Flash;
+    else if (name == "ram")
+        *what = TargetFlow::Ram;
+    else if (name == "verify")
+        *what = TargetFlow::Verify;
+    else
+        return false;
+    return true;
+}
+
+
+BatchRunner::BatchRunner(const QStringList &arguments, QObject *parent)
+    : QObject(parent), host("localhost"), port(0), gdbPort(0), telnet(false), timeout(120), retries(0),
+      transport(0), supervisor(0), timedOut(false), done(false),
+      bytesDone(0), bytesTotal(0), loadDone(0), percent(0), failure(Passed)
+{
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    connect(timer, SIGNAL(timeout()), this, SLOT(commandTimeout()));
+    gdb = new GdbRemote(this);
+    flow = new TargetFlow(gdb, this);
+    connect(flow, SIGNAL(message(QString)), this, SLOT(flowMessage(QString)));
+    connect(flow, SIGNAL(commandFinished(OcdReply*)), this, SLOT(commandFinished(OcdReply*)));
+    connect(flow, SIGNAL(progress(qint64,qint64)), this, SLOT(loadProgress(qint64,qint64)));
+    connect(flow, SIGNAL(loaded(LoadRecord)), this, SLOT(loaded(LoadRecord)));
+    connect(flow, SIGNAL(finished(bool)), this, SLOT(stepFinished(bool)));
+
+    QString profileFile = "openocd-qtgui.conf";
+    QStringList args = arguments.mid(1);	// without the program
+    int at = args.indexOf("--profile");
+    if (at != -1 && at + 1 < args.size())
+        profileFile = args.at(at + 1);
+    if (!profile.load(profileFile) && at != -1)
+    {
+        failure = UsageError;
+        failureText = "Can not read profile " + profileFile;
+        return;
+    }
+    flow->setProfile(profile);
+
+    if (parseArguments(args))
+        checkSteps();
+}
+
+bool BatchRunner::requested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+        if (!strcmp(argv[i], "--batch"))
+            return true;
+    return false;
+}
+
+void BatchRunner::start()
+{
+    if (failure != Passed)
+    {
+        if (failure == UsageError)
+            fputs(usage, stderr);
+        finish(failure, failureText);
+        return;
+    }
+    clock.start();
+    JsonLine("start").number("steps", requests.size()).number("bytes", bytesTotal).print();
+
+    if (telnet)
+        transport = new TelnetTransport("> ", this);
+    else
+        transport = new TclRpcTransport(this);
+    flow->setTransport(transport);
+    connect(transport, SIGNAL(connected()), this, SLOT(connected()));
+    connect(transport, SIGNAL(error(QString)), this, SLOT(connectError(QString)));
+
+    if (serverConfig.isEmpty())
+    {
+        connectToServer();
+        return;
+    }
+    supervisor = new OcdSupervisor(this);
+    connect(supervisor, SIGNAL(ready(quint16, quint16, quint16)), this, SLOT(serverReady(quint16, quint16, quint16)));
+    connect(supervisor, SIGNAL(error(QString)), this, SLOT(serverError(QString)));
+    connect(supervisor, SIGNAL(crashed(int)), this, SLOT(serverCrashed(int)));
+    supervisor->start(serverConfig);
+}
+
+
+
+// private slots:
+void BatchRunner::connectToServer()
+{
+    flow->setGdbPort(host, gdbPort);
+    transport->connectToHost(host, port ? port : (telnet ? 4444 : 6666));
+}
+
+void BatchRunner::serverReady(quint16 telnetPort, quint16 tclPort, quint16 gdbPort)
+{
+    port = telnet ? telnetPort : tclPort;
+    if (this->gdbPort)
+        this->gdbPort = gdbPort;
+    host = "localhost";
+    JsonLine("server").number("port", port).print();
+    connectToServer();
+}
+
+void BatchRunner::serverError(const QString &message)
+{
+    finish(transport->isConnected() ? CommandFailed : ConnectFailed, message);
+}
+
+void BatchRunner::serverCrashed(int exitCode)
+{
+    serverError(QString("openOCD exited with code %1").arg(exitCode));
+}
+
+void BatchRunner::connected()
+{
+    JsonLine("connected").text("host", host).number("port", port ? port : (telnet ? 4444 : 6666)).print();
+    next();
+}
+
+void BatchRunner::connectError(const QString &message)
+{
+    if (done || (transport->isConnected() && flow->isBusy()))
+        return;		// a failing command reports itself
+    if (supervisor && ++retries < ConnectRetries)
+    {
+        QTimer::singleShot(200, this, SLOT(connectToServer()));
+        return;
+    }
+    finish(ConnectFailed, message);
+}
+
+void BatchRunner::flowMessage(const QString &text)
+{
+    JsonLine("message").text("step", step).text("text", text).print();
+}
+
+void BatchRunner::commandFinished(OcdReply *reply)
+{
+    timer->start(timeout * 1000);	// for the next command of the step
+    JsonLine line("command");
+    line.text("step", step).text("command", reply->command()).real("ms", reply->latency() / 1000.0).flag("ok", !reply->failed());
+    if (reply->failed())
+        line.text("error", timedOut ? QString("timeout") : reply->isAborted() ? QString("aborted") : OcdReply::errorLine(reply->response()));
+    line.print();
+}
+
+void BatchRunner::loadProgress(qint64 done, qint64 total)
+{
+    Q_UNUSED(total);
+    bytesDone += done - loadDone;
+    loadDone = done;
+    int now = int(bytesDone * 100 / qMax<qint64>(bytesTotal, 1));
+    if (now == percent)
+        return;
+    percent = now;
+    JsonLine("progress").number("done", bytesDone).number("total", bytesTotal).number("percent", percent).print();
+}
+
+void BatchRunner::loaded(const LoadRecord &record) // phase timing, as the GUI keeps it in its history
+{
+    JsonLine("load").text("step", step).text("image", record.image).flag("ok", record.ok).number("bytes", record.bytes)
+                    .number("halt_ms", record.haltMs).number("erase_ms", record.eraseMs)
+                    .number("write_ms", record.writeMs).number("verify_ms", record.verifyMs)
+                    .real("kib_per_s", record.rate()).print();
+}
+
+void BatchRunner::stepFinished(bool ok)
+{
+    timer->stop();
+    if (done)
+        return;
+    if (!ok)
+    {
+        finish(CommandFailed, "'" + step + "' failed");
+        return;
+    }
+    next();
+}
+
+void BatchRunner::commandTimeout()
+{
+    timedOut = true;
+    flow->abort();		// the reply comes back aborted
+}
+
+
+
+// private Funktions:
+bool BatchRunner::parseArguments(const QStringList &args)
+{
+    QStringList words;		// steps with their arguments
+    for (int i = 0; i < args.size(); i++)
+    {
+        QString arg = args.at(i);
+        bool hasValue = (i + 1 < args.size());
+        if (arg == "--batch")
+            continue;
+        else if (arg == "--telnet")
+            telnet = true;
+        else if (arg == "--erase")
+            flow->setErase(true);
+        else if (arg == "--delta")
+            flow->setDelta(true);
+        else if (arg == "--gdb" && hasValue)
+            gdbPort = args.at(++i).toUShort();
+        else if (arg == "--profile" && hasValue)
+            i++;		// read before
+        else if (arg == "--host" && hasValue)
+            host = args.at(++i);
+        else if (arg == "--port" && hasValue)
+            port = args.at(++i).toUShort();
+        else if (arg == "--openocd" && hasValue)
+            serverConfig = args.at(++i);
+        else if (arg == "--timeout" && hasValue)
+            timeout = qMax(1, args.at(++i).toInt());
+        else if (arg == "--script" && hasValue)
+        {
+            QFile script(args.at(++i));
+            if (!script.open(QIODevice::ReadOnly | QIODevice::Text))
+            {
+                failure = UsageError;
+                failureText = "Can not read script " + script.fileName();
+                return false;
+            }
+            QTextStream in(&script);
+            while (!in.atEnd())
+            {
+                QString line = in.readLine().trimmed();
+                if (line.isEmpty() || line.startsWith('#'))
+                    continue;
+                int space = line.indexOf(' ');
+                words << line.left(space);
+                if (space != -1)
+                    words << line.mid(space + 1).trimmed();
+                else if (line == "flash" || line == "ram" || line == "verify" || line == "cmd")
+                    words << QString();
+            }
+        }
+        else if (arg.startsWith("--"))
+        {
+            failure = UsageError;
+            failureText = "Unknown option " + arg;
+            return false;
+        }
+        else
+            words << arg;
+    }
+
+    for (int i = 0; i < words.size(); i++)
+    {
+        QStringList request(words.at(i));
+        if (words.at(i) == "flash" || words.at(i) == "ram" || words.at(i) == "verify" || words.at(i) == "cmd")
+        {
+            if (i + 1 >= words.size() || words.at(i + 1).isEmpty())
+            {
+                failure = UsageError;
+                failureText = words.at(i) + " needs an argument";
+                return false;
+            }
+            request << words.at(++i);
+        }
+        requests << request;
+    }
+    if (requests.isEmpty())
+    {
+        failure = UsageError;
+        failureText = "No steps given";
+        return false;
+    }
+    return true;
+}
+
+bool BatchRunner::checkSteps() // all known and every image fits the memory map, before anything is sent
+{
+    TargetFlow::Load what;
+    for (int i = 0; i < requests.size(); i++)
+    {
+        QString name = requests.at(i).at(0);
+        if (loadStep(name, &what))
+        {
+            qint64 bytes;
+            if (!TargetFlow::checkImage(profile, what, requests.at(i).at(1), &bytes, &failureText))
+            {
+                failure = ImageInvalid;
+                return false;
+            }
+            bytesTotal += bytes;
+        }
+        else if (name != "cmd" && flow->stepCommands(name).isEmpty())
+        {
+            failure = UsageError;
+            failureText = "Unknown step " + name;
+            return false;
+        }
+    }
+    return true;
+}
+
+void BatchRunner::next()
+{
+    if (done)
+        return;
+    if (requests.isEmpty())
+    {
+        finish(Passed);
+        return;
+    }
+    QStringList request = requests.takeFirst();
+    step = request.at(0);
+    loadDone = 0;
+    timedOut = false;
+    timer->start(timeout * 1000);
+
+    TargetFlow::Load what;
+    if (step == "cmd")
+        flow->run(QStringList(request.at(1)));
+    else if (!loadStep(step, &what))
+        flow->runStep(step);
+    else if (!flow->load(what, request.at(1)))
+        finish(ImageInvalid, flow->errorString());
+}
+
+void BatchRunner::finish(int code, const QString &message)
+{
+    if (done)
+        return;
+    done = true;
+    timer->stop();
+    JsonLine line("done");
+    line.flag("ok", code == Passed).number("code", code).number("ms", clock.isValid() ? clock.elapsed() : 0)
+        .number("bytes", bytesDone);
+    if (!message.isEmpty())
+        line.text("message", message);
+    line.print();
+    if (transport)
+        transport->close();
+    gdb->close();
+    if (supervisor)
+        supervisor->stop();
+    QCoreApplication::exit(code);
+}
@@ -0,0 +1,101 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <QObject>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QList>
+#include "profile.h"
+
+class OcdTransport;
+class OcdReply;
+class OcdSupervisor;
+class GdbRemote;
+class TargetFlow;
+struct LoadRecord;
+class QTimer;
+
+// Headless mode for scripts and CI: "--batch" runs a list of steps against
+// openOCD through the flows and with the profile of the GUI, needs no
+// display and reports every command as one JSON object per line on stdout.
+// The exit code tells how it went.
+class BatchRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum ExitCode { Passed = 0, CommandFailed = 1, UsageError = 2, ConnectFailed = 3, ImageInvalid = 4 };
+
+    BatchRunner(const QStringList &arguments, QObject *parent = 0);
+
+    static bool requested(int argc, char *argv[]);
+
+public slots:
+    void start();
+
+private slots:
+    void connectToServer();
+    void serverReady(quint16 telnetPort, quint16 tclPort, quint16 gdbPort);
+    void serverError(const QString &message);
+    void serverCrashed(int exitCode);
+    void connected();
+    void connectError(const QString &message);
+    void flowMessage(const QString &text);
+    void commandFinished(OcdReply *reply);
+    void loadProgress(qint64 done, qint64 total);
+    void loaded(const LoadRecord &record);
+    void stepFinished(bool ok);
+    void commandTimeout();
+
+private:
+    bool parseArguments(const QStringList &arguments);
+    bool checkSteps();
+    void next();
+    void finish(int code, const QString &message = QString());
+
+    Profile profile;
+    QList<QStringList> requests;	// step and argument
+    QString step;			// running
+    QString host;
+    quint16 port;
+    quint16 gdbPort;		// RAM loads over the gdb port if set
+    bool telnet;
+    QString serverConfig;		// start openOCD with this config
+    int timeout;			// seconds per command
+    int retries;
+
+    OcdTransport *transport;
+    OcdSupervisor *supervisor;
+    GdbRemote *gdb;
+    TargetFlow *flow;
+    QTimer *timer;
+    bool timedOut;
+    bool done;
+    QElapsedTimer clock;
+    qint64 bytesDone;
+    qint64 bytesTotal;
+    qint64 loadDone;		// of the running load
+    int percent;
+    int failure;			// exit code found while parsing
+    QString failureText;
+};
+
+#endif // BATCH_H
@@ -0,0 +1,120 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ansifilter.h"
+#include <QStringList>
+#include <QRegExp>
+#include <QElapsedTimer>
+#include <cstdio>
+
+static const int OutputBytes = 4 * 1024 * 1024;
+static const int ChunkBytes = 4096;	// one read from the openOCD pipe
+static const int Runs = 10;
+
+// Times AnsiFilter against the stripCR() it replaced, chunk by chunk as the
+// pipe and telnet reads deliver openOCD output. Before the timing both have
+// to give the same text for the whole output.
+
+
+// what MainWidget::stripCR() did to every read
+static QString stripCR(const QString &msg)
+{
+    QString nmsg(msg);
+    nmsg.remove('\r');
+    nmsg.remove(QRegExp("\033\\[[0-9;]*[A-Za-z]"));
+    return nmsg;
+}
+
+// openOCD log lines, every colored one wrapped in SGR sequences
+static QByteArray output(int coloredEvery)
+{
+    QByteArray text;
+    text.reserve(OutputBytes + 1024);
+    char line[160];
+    for (int i = 0; text.size() < OutputBytes; i++)
+    {
+        bool colored = coloredEvery && i % coloredEvery == 0;
+        sprintf(line, "%sInfo : 0x%08x: target halted due to debug-request, current mode: Thread%s\r\n",
+                colored ? "\033[1;32m" : "", 0x00200000 + 4 * i, colored ? "\033[0m" : "");
+        text += line;
+    }
+    return text;
+}
+
+static QString viaStripCR(const QByteArray &data)
+{
+    QString text;
+    for (int i = 0; i < data.size(); i += ChunkBytes)
+        text += stripCR(QString::fromLocal8Bit(data.constData() + i, qMin(ChunkBytes, data.size() - i)));
+    return text;
+}
+
+static QString viaFilter(const QByteArray &data)
+{
+    AnsiFilter filter;
+    QString text;
+    for (int i = 0; i < data.size(); i += ChunkBytes)
+        text += filter.toUnicode(data.mid(i, ChunkBytes));
+    return text;
+}
+
+static double bestMs(const QByteArray &data, QString (*convert)(const QByteArray &))
+{
+    qint64 best = -1;
+    for (int run = 0; run < Runs; run++)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        convert(data);
+        qint64 ns = timer.nsecsElapsed();
+        if (best < 0 || ns < best)
+            best = ns;
+    }
+    return best / 1e6;
+}
+
+int main()
+{
+    struct Kind
+    {
+        const char *name;
+        int coloredEvery;
+    } kinds[] = {
+        { "plain lines", 0 },
+        { "every 10th line colored", 10 },
+        { "every line colored", 1 },
+    };
+
+    printf("openOCD output in %d byte reads, best of %d runs\n", ChunkBytes, Runs);
+    for (unsigned k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++)
+    {
+        const QByteArray data = output(kinds[k].coloredEvery);
+        // whole, as stripCR() misses sequences split between reads
+        if (stripCR(QString::fromLocal8Bit(data)) != viaFilter(data))
+        {
+            fprintf(stderr, "%s: AnsiFilter and stripCR() differ\n", kinds[k].name);
+            return 1;
+        }
+        double before = bestMs(data, viaStripCR);
+        double after = bestMs(data, viaFilter);
+        printf("  %s, %d bytes\n", kinds[k].name, data.size());
+        printf("    %-28s %8.3f ms %8.1f MB/s\n", "before: stripCR()", before, data.size() / 1e3 / before);
+        printf("    %-28s %8.3f ms %8.1f MB/s\n", "after: AnsiFilter", after, data.size() / 1e3 / after);
+    }
+    return 0;
+}
@@ -0,0 +1,10 @@
+TEMPLATE = app
+TARGET = ansifilter_bench
+CONFIG += console release
+CONFIG -= app_bundle
+QT -= gui
+DEPENDPATH += . ..
+INCLUDEPATH += . ..
+
+HEADERS += ../ansifilter.h
+SOURCES += ansifilter_bench.cpp ../ansifilter.cpp
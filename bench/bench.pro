@@ -0,0 +1,14 @@
+######################################################################
+# Benchmarks, built apart from the application:
+#   cd bench && qmake && make, then run the *_bench programs
+######################################################################
+
+TEMPLATE = subdirs
+memparse.file = memparse_bench.pro
+telnet.file = telnet_bench.pro
+outputrenderer.file = outputrenderer_bench.pro
+ansifilter.file = ansifilter_bench.pro
+gdbremote.file = gdbremote_bench.pro
+transport.file = transport_bench.pro
+ocdlog.file = ocdlog_bench.pro
+SUBDIRS += memparse telnet outputrenderer ansifilter gdbremote transport ocdlog
@@ -0,0 +1,186 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gdbremote.h"
+#include "memparse.h"
+#include "qttelnet.h"
+#include "mockocd.h"
+#include "rspstub.h"
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QVector>
+#include <cstdio>
+#include <cstdlib>
+
+static const quint32 Base = 0x20000000;
+static const int Bytes = 64 * 1024;
+static const int RoundTrip = 1;		// ms both servers wait before every answer
+static const int MdwWords = 1024;	// per mdw, as the snapshots read
+static const int MwwBatch = 256;	// mww commands written at once
+
+// Reads and writes 64 KiB of target memory over the gdb remote protocol,
+// against an RSP stub, and with mdw/mww over telnet, against a mock
+// openOCD. Both servers answer after the same round trip, so the numbers
+// show what the number of round trips costs. Every transfer is checked.
+
+
+// Keeps what GdbRemote read.
+class Collector : public QObject
+{
+    Q_OBJECT
+
+public:
+    QByteArray data;
+
+public slots:
+    void memoryRead(quint32, const QByteArray &bytes) { data = bytes; }
+};
+
+
+// runs the event loop until sender emits signal, false after 30 s
+static bool waitFor(QObject *sender, const char *signal)
+{
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    QObject::connect(sender, signal, &loop, SLOT(quit()));
+    QObject::connect(&timeout, SIGNAL(timeout()), &loop, SLOT(quit()));
+    timeout.start(30000);
+    loop.exec();
+    return timeout.isActive();
+}
+
+static void report(const char *name, qint64 ns, int roundTrips)
+{
+    double ms = ns / 1e6;
+    printf("  %-20s %8.1f ms %8.1f KB/s %6d round trips\n", name, ms, Bytes / ms, roundTrips);
+}
+
+static bool viaRsp(const QByteArray &image)
+{
+    RspStub stub(Base, Bytes);
+    stub.setDelay(RoundTrip);
+    if (!stub.listen())
+        return false;
+    GdbRemote gdb;
+    Collector collector;
+    QObject::connect(&gdb, SIGNAL(memoryRead(quint32, QByteArray)), &collector, SLOT(memoryRead(quint32, QByteArray)));
+    gdb.connectToHost("127.0.0.1", stub.port());
+    if (!waitFor(&gdb, SIGNAL(connected())))
+        return false;
+
+    QElapsedTimer timer;
+    int packets = stub.packets();
+    timer.start();
+    gdb.writeMemory(Base, image);
+    if (!waitFor(&gdb, SIGNAL(memoryWritten(quint32, qint64))) || stub.memory() != image)
+        return false;
+    report("RSP X", timer.nsecsElapsed(), stub.packets() - packets);
+
+    packets = stub.packets();
+    timer.start();
+    gdb.readMemory(Base, Bytes);
+    if (!waitFor(&gdb, SIGNAL(memoryRead(quint32, QByteArray))) || collector.data != image)
+        return false;
+    report("RSP m", timer.nsecsElapsed(), stub.packets() - packets);
+    return true;
+}
+
+static bool viaTelnet(const QByteArray &image)
+{
+    MockOcd mock(MockOcd::Telnet);
+    mock.setDelay(RoundTrip);
+    if (!mock.listen())
+        return false;
+    QtTelnet telnet;
+    telnet.setPromptString("> ");
+    telnet.connectToHost("127.0.0.1", mock.port());
+    if (!waitFor(telnet.socket(), SIGNAL(connected())))
+        return false;
+    QtTelnetReply *ready = telnet.execute("echo ready");	// after the banner
+    if (!waitFor(ready, SIGNAL(finished())))
+        return false;
+
+    const quint32 *words = reinterpret_cast<const quint32 *>(image.constData());
+    QElapsedTimer timer;
+    int reads = mock.reads();
+    timer.start();
+    for (int i = 0; i < Bytes / 4; i += MwwBatch)
+    {
+        QStringList commands;
+        for (int j = i; j < i + MwwBatch; j++)
+            commands << QString("mww 0x%1 0x%2").arg(Base + 4 * j, 8, 16, QChar('0')).arg(words[j], 8, 16, QChar('0'));
+        QList<QtTelnetReply *> replies = telnet.execute(commands);
+        if (!waitFor(replies.last(), SIGNAL(finished())))
+            return false;
+        for (int j = 0; j < replies.size(); j++)
+            replies.at(j)->deleteLater();
+    }
+    qint64 ns = timer.nsecsElapsed();
+    for (int i = 0; i < Bytes / 4; i++)
+        if (mock.word(Base + 4 * i) != words[i])
+            return false;
+    report("telnet mww", ns, mock.reads() - reads);
+
+    QVector<quint32> values(Bytes / 4);
+    MemoryParser parser(Base, 4);
+    reads = mock.reads();
+    timer.start();
+    for (int i = 0; i < values.size(); i += MdwWords)
+    {
+        QtTelnetReply *reply = telnet.execute(QString("mdw 0x%1 %2").arg(Base + 4 * i, 8, 16, QChar('0')).arg(MdwWords));
+        if (!waitFor(reply, SIGNAL(finished())))
+            return false;
+        QByteArray text = reply->response().toLatin1();
+        if (parser.parseDump(text.constData(), text.size(), values.data() + i, MdwWords) != MdwWords)
+            return false;
+        reply->deleteLater();
+    }
+    ns = timer.nsecsElapsed();
+    if (memcmp(values.constData(), words, Bytes))
+        return false;
+    report("telnet mdw", ns, mock.reads() - reads);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QByteArray image(Bytes, 0);
+    srand(0x5a5a);
+    for (int i = 0; i < Bytes; i++)
+        image[i] = char(rand());
+
+    printf("%d KiB of target memory, %d ms round trip\n", Bytes / 1024, RoundTrip);
+    if (!viaRsp(image))
+    {
+        fprintf(stderr, "the transfer over RSP failed or returned other data\n");
+        return 1;
+    }
+    if (!viaTelnet(image))
+    {
+        fprintf(stderr, "the transfer with mww/mdw failed or returned other data\n");
+        return 1;
+    }
+    return 0;
+}
+
+#include "gdbremote_bench.moc"
@@ -0,0 +1,12 @@
+TEMPLATE = app
+TARGET = gdbremote_bench
+CONFIG += console release
+CONFIG -= app_bundle
+QT += network
+QT -= gui
+DEPENDPATH += . .. ../QtTelnet ../tests/shared
+INCLUDEPATH += . .. ../QtTelnet ../tests/shared
+
+HEADERS += ../gdbremote.h ../memparse.h ../QtTelnet/qttelnet.h ../tests/shared/mockocd.h ../tests/shared/rspstub.h
+SOURCES += gdbremote_bench.cpp ../gdbremote.cpp ../memparse.cpp ../QtTelnet/qttelnet.cpp \
+           ../tests/shared/mockocd.cpp ../tests/shared/rspstub.cpp
@@ -0,0 +1,164 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "memparse.h"
+#include <QVector>
+#include <QElapsedTimer>
+#include <cstdio>
+#include <cstdlib>
+
+static const quint32 Base = 0x00200000;
+static const int Words = 256 * 1024;		// 1 MiB of target memory
+static const int Runs = 20;
+
+// Times MemoryParser on 1 MiB of target memory printed as mdw text, with
+// the SSE2 word pair decoder and with the scalar one. Before that, both have
+// to agree on the whole text and on every damaged variant of a few lines,
+// so hexWordPair is checked against the scalar decoder byte for byte.
+
+
+// words as openOCD prints them with mdw, four to a line
+static QByteArray mdwText(const QVector<quint32> &words, quint32 address, bool upper)
+{
+    QByteArray text;
+    text.reserve(words.size() / 4 * 48);
+    char line[64];
+    for (int i = 0; i < words.size(); i += 4)
+    {
+        int length = sprintf(line, "0x%08x:", address + 4 * i);
+        for (int j = i; j < words.size() && j < i + 4; j++)
+            length += sprintf(line + length, upper ? " %08X" : " %08x", words.at(j));
+        line[length++] = ' ';
+        line[length++] = '\n';
+        text.append(line, length);
+    }
+    return text;
+}
+
+struct Result
+{
+    QVector<quint32> values;
+    int count;
+    quint32 next;
+    bool error;
+
+    bool operator==(const Result &other) const
+    {
+        return count == other.count && next == other.next && error == other.error
+               && !memcmp(values.constData(), other.values.constData(), count * sizeof(quint32));
+    }
+};
+
+static Result parse(const QByteArray &text, int words, bool vectorised)
+{
+    MemoryParser parser(Base, 4);
+    parser.setVectorised(vectorised);
+    Result result;
+    result.values.resize(words);
+    result.count = parser.parseDump(text.constData(), text.size(), result.values.data(), words);
+    result.next = parser.nextAddress();
+    result.error = parser.hasError();
+    return result;
+}
+
+static bool agree(const QByteArray &text, int words)
+{
+    return parse(text, words, true) == parse(text, words, false);
+}
+
+// every character of a few lines replaced by the ones the decoders might mistake
+static int damagedDisagreements(const QVector<quint32> &words)
+{
+    static const char replacements[] = " \t\r\n:x/0@9`AaFfGg\xff";
+    QVector<quint32> few = words.mid(0, 16);
+    const QByteArray clean = mdwText(few, Base, false);
+    int failures = 0;
+    for (int i = 0; i < clean.size(); i++)
+    {
+        for (unsigned r = 0; r < sizeof(replacements) - 1; r++)
+        {
+            QByteArray text = clean;
+            text[i] = replacements[r];
+            if (!agree(text, few.size()))
+            {
+                fprintf(stderr, "decoders differ with 0x%02x at offset %d\n", quint8(replacements[r]), i);
+                failures++;
+            }
+        }
+        if (!agree(clean.left(i), few.size()))
+        {
+            fprintf(stderr, "decoders differ on the text cut at offset %d\n", i);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+static double bestMs(const QByteArray &text, bool vectorised)
+{
+    QVector<quint32> values(Words);
+    qint64 best = -1;
+    for (int run = 0; run < Runs; run++)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        MemoryParser parser(Base, 4);
+        parser.setVectorised(vectorised);
+        if (parser.parseDump(text.constData(), text.size(), values.data(), Words) != Words)
+            return -1;
+        qint64 ns = timer.nsecsElapsed();
+        if (best < 0 || ns < best)
+            best = ns;
+    }
+    return best / 1e6;
+}
+
+int main()
+{
+    QVector<quint32> words(Words);
+    srand(0x5a5a);
+    for (int i = 0; i < Words; i++)
+        words[i] = (quint32(rand() & 0xffff) << 16) | quint32(rand() & 0xffff);
+    const QByteArray text = mdwText(words, Base, false);
+
+    int failures = damagedDisagreements(words);
+    if (!agree(text, Words) || !agree(mdwText(words, Base, true), Words))
+    {
+        fprintf(stderr, "decoders differ on the full dump\n");
+        failures++;
+    }
+    if (parse(text, Words, false).values != words)
+    {
+        fprintf(stderr, "scalar decoder does not return the dumped words\n");
+        failures++;
+    }
+    if (failures)
+        return 1;
+
+#ifdef __SSE2__
+    const char *simd = "SSE2";
+#else
+    const char *simd = "scalar, no SSE2 in this build";
+#endif
+    double vector = bestMs(text, true);
+    double scalar = bestMs(text, false);
+    printf("mdw text: %d bytes for %d KiB of memory, best of %d runs\n", text.size(), Words * 4 / 1024, Runs);
+    printf("  %-30s %8.3f ms %8.1f MB/s\n", simd, vector, text.size() / 1e3 / vector);
+    printf("  %-30s %8.3f ms %8.1f MB/s\n", "scalar", scalar, text.size() / 1e3 / scalar);
+    return 0;
+}
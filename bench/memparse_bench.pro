@@ -0,0 +1,10 @@
+TEMPLATE = app
+TARGET = memparse_bench
+CONFIG += console release
+CONFIG -= app_bundle
+QT -= gui
+DEPENDPATH += . ..
+INCLUDEPATH += . ..
+
+HEADERS += ../memparse.h
+SOURCES += memparse_bench.cpp ../memparse.cpp
@@ -0,0 +1,139 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ocdlog.h"
+#include <QCoreApplication>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <cstdio>
+
+static const int OutputBytes = 8 * 1024 * 1024;
+static const int ChunkBytes = 4096;	// one read from the openOCD pipe
+static const int Runs = 5;
+
+// Lines per second the openOCD log pipeline takes at debug level 3, when
+// nearly every line is "Debug: ...": the output goes through OcdLog::feed
+// in pipe sized chunks, cut anywhere, and every line comes out assembled
+// and classified. classify() is also timed alone on the finished lines.
+
+
+// Counts what comes out of OcdLog.
+class Sink : public QObject
+{
+    Q_OBJECT
+
+public:
+    Sink() : lines(0), tagged(0) {}
+
+    qint64 lines;
+    qint64 tagged;
+
+public slots:
+    void received(const QStringList &complete) { lines += complete.size(); }
+    void warning(int, const QString &) { tagged++; }
+};
+
+
+// what "openocd -d3" prints while flashing: debug lines with the source
+// location, now and then an info, a warning or an error
+static QByteArray output(int *lines, int *tagged)
+{
+    QByteArray text;
+    text.reserve(OutputBytes + 1024);
+    char line[200];
+    *lines = 0;
+    *tagged = 0;
+    for (int i = 0; text.size() < OutputBytes; i++)
+    {
+        if (i % 2000 == 1999)
+            sprintf(line, "Error: %d %d target.c:%d target_write_memory(): Failed to write memory at 0x%08x\r\n",
+                    1000 + i, 5, 1800 + i % 7, 0x00100000 + 4 * i);
+        else if (i % 500 == 499)
+            sprintf(line, "Warn : %d %d arm7_9_common.c:%d arm7_9_poll(): DBGACK set while target was in unknown state\r\n",
+                    1000 + i, 5, 900 + i % 11);
+        else if (i % 50 == 49)
+            sprintf(line, "Info : %d %d core.c:%d flash_write(): wrote %d bytes to 0x%08x\r\n",
+                    1000 + i, 5, 600 + i % 13, 256, 0x00100000 + 256 * i);
+        else
+            sprintf(line, "Debug: %d %d target.c:%d target_read_u32(): address: 0x%08x, value: 0x%08x\r\n",
+                    1000 + i, 5, 2345 + i % 17, 0x00200000 + 4 * i, i * 2654435761u);
+        text += line;
+        (*lines)++;
+        if (i % 500 == 499 || i % 2000 == 1999)
+            (*tagged)++;
+    }
+    return text;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);	// for the idle timer of OcdLog
+    int expectedLines, expectedTagged;
+    const QByteArray data = output(&expectedLines, &expectedTagged);
+
+    qint64 best = -1;
+    for (int run = 0; run < Runs; run++)
+    {
+        OcdLog log;
+        Sink sink;
+        QObject::connect(&log, SIGNAL(lines(QStringList)), &sink, SLOT(received(QStringList)));
+        QObject::connect(&log, SIGNAL(tagged(int, QString)), &sink, SLOT(warning(int, QString)));
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < data.size(); i += ChunkBytes)
+            log.feed(data.mid(i, ChunkBytes));
+        log.flush();
+        qint64 ns = timer.nsecsElapsed();
+        if (sink.lines != expectedLines || sink.tagged != expectedTagged
+            || log.count(OcdLog::Debug) + log.count(OcdLog::Info) + log.count(OcdLog::Warn) + log.count(OcdLog::Error) != expectedLines)
+        {
+            fprintf(stderr, "%lld lines and %lld warnings/errors out of OcdLog, %d and %d expected\n",
+                    sink.lines, sink.tagged, expectedLines, expectedTagged);
+            return 1;
+        }
+        if (best < 0 || ns < best)
+            best = ns;
+    }
+    const QStringList all = QString::fromLatin1(data).remove('\r').split('\n', QString::SkipEmptyParts);
+
+    qint64 bestClassify = -1;
+    int errors = 0;
+    for (int run = 0; run < Runs; run++)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        errors = 0;
+        for (int i = 0; i < all.size(); i++)
+            errors += OcdLog::classify(all.at(i)) == OcdLog::Error;
+        qint64 ns = timer.nsecsElapsed();
+        if (bestClassify < 0 || ns < bestClassify)
+            bestClassify = ns;
+    }
+
+    double ms = best / 1e6;
+    printf("-d3 output, %d bytes in %d lines, %d byte reads, best of %d runs\n",
+           data.size(), expectedLines, ChunkBytes, Runs);
+    printf("  %-24s %8.1f ms %8.1f MB/s %10.0f lines/s\n", "feed() to lines()", ms,
+           data.size() / 1e3 / ms, expectedLines * 1e3 / ms);
+    ms = bestClassify / 1e6;
+    printf("  %-24s %8.1f ms %8.1f ns/line %5d errors\n", "classify() alone", ms,
+           bestClassify / double(all.size()), errors);
+    return 0;
+}
+
+#include "ocdlog_bench.moc"
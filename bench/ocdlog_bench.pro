@@ -0,0 +1,9 @@
+TEMPLATE = app
+TARGET = ocdlog_bench
+CONFIG += console release
+CONFIG -= app_bundle
+DEPENDPATH += . ..
+INCLUDEPATH += . ..
+
+HEADERS += ../ocdlog.h ../ansifilter.h
+SOURCES += ocdlog_bench.cpp ../ocdlog.cpp ../ansifilter.cpp
@@ -0,0 +1,113 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "outputrenderer.h"
+#include "logview.h"
+#include <QApplication>
+#include <QTextEdit>
+#include <QScrollBar>
+#include <QElapsedTimer>
+#include <cstdio>
+
+static const int ChunkLines = 8;	// about one telnet read of openOCD output
+
+// Lines per second the output views take, fed chunk by chunk with the event
+// loop running in between as it does for network reads. "before" is how
+// the output used to be shown: QTextEdit::append() and a jump to the bottom
+// per chunk. "after" is OutputRenderer batching into a LogView. Needs a
+// display, the views are shown so painting is part of the time.
+
+
+static QString chunk(int first)
+{
+    QStringList lines;
+    for (int i = first; i < first + ChunkLines; i++)
+        lines << QString("Info : 0x%1: target halted in Thumb state due to debug-request, line %2")
+                 .arg(0x00200000 + 4 * i, 8, 16, QChar('0')).arg(i);
+    return lines.join("\n");
+}
+
+static double textEditMs(int lines)
+{
+    QTextEdit edit;
+    edit.setReadOnly(true);
+    edit.setUndoRedoEnabled(false);
+    edit.resize(800, 600);
+    edit.show();
+    QApplication::processEvents();
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < lines; i += ChunkLines)
+    {
+        edit.append(chunk(i));
+        edit.verticalScrollBar()->setValue(edit.verticalScrollBar()->maximum());
+        QApplication::processEvents();
+    }
+    QApplication::processEvents();
+    return timer.nsecsElapsed() / 1e6;
+}
+
+static double rendererMs(int lines)
+{
+    LogView view;
+    view.resize(800, 600);
+    view.show();
+    OutputRenderer renderer(&view, 20);
+    QApplication::processEvents();
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < lines; i += ChunkLines)
+    {
+        renderer.append(chunk(i));
+        QApplication::processEvents();
+    }
+    renderer.flush();
+    QApplication::processEvents();
+    double ms = timer.nsecsElapsed() / 1e6;
+    if (view.lineCount() != lines)
+        return -1;
+    return ms;
+}
+
+static void report(const char *name, int lines, double ms)
+{
+    printf("  %-32s %8d lines %9.1f ms %10.0f lines/s\n", name, lines, ms, lines / ms * 1e3);
+}
+
+int main(int argc, char **argv)
+{
+    QApplication app(argc, argv);
+    const int sizes[] = { 10000, 50000 };
+
+    printf("output views, %d lines per append\n", ChunkLines);
+    for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        double after = rendererMs(sizes[s]);
+        if (after < 0)
+        {
+            fprintf(stderr, "LogView does not hold the %d lines appended\n", sizes[s]);
+            return 1;
+        }
+        report("before: QTextEdit::append", sizes[s], textEditMs(sizes[s]));
+        report("after: OutputRenderer, LogView", sizes[s], after);
+    }
+    report("after: OutputRenderer, LogView", 1000000, rendererMs(1000000));
+    return 0;
+}
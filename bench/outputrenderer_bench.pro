@@ -0,0 +1,9 @@
+TEMPLATE = app
+TARGET = outputrenderer_bench
+CONFIG += release
+CONFIG -= app_bundle
+DEPENDPATH += . ..
+INCLUDEPATH += . ..
+
+HEADERS += ../outputrenderer.h ../logview.h
+SOURCES += outputrenderer_bench.cpp ../outputrenderer.cpp ../logview.cpp
@@ -0,0 +1,158 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "qttelnet.h"
+#include <QCoreApplication>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <QEventLoop>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <cstdio>
+
+static const int CaptureBytes = 8 * 1024 * 1024;
+static const int Runs = 5;
+static const char Marker[] = "end of capture";
+
+// Throughput of the QtTelnet stream parser: a local server sends a few MiB
+// of captured mdw output, the time runs until the end marker has come out
+// of message(). Only the API QtTelnet always had is used, so the same
+// program built with QTTELNET=<old dir> gives the numbers from before.
+
+
+// Counts what comes out of the parser and stops the loop at the marker.
+class Sink : public QObject
+{
+    Q_OBJECT
+
+public:
+    Sink() : received(0) {}
+
+    qint64 received;
+    QString tail;
+
+signals:
+    void done();
+
+public slots:
+    void message(const QString &text)
+    {
+        received += text.size();
+        tail = (tail + text).right(64);
+        if (tail.contains(Marker))
+            emit done();
+    }
+};
+
+
+// mdw output with the given telnet sequence after every interval bytes
+static QByteArray capture(const QByteArray &sequence, int interval)
+{
+    QByteArray text;
+    text.reserve(CaptureBytes + CaptureBytes / interval * sequence.size() + 64);
+    char line[64];
+    quint32 address = 0x00200000;
+    int next = interval;
+    while (text.size() < CaptureBytes)
+    {
+        int length = sprintf(line, "0x%08x: %08x %08x %08x %08x \r\n",
+                             address, address * 7, ~address, address ^ 0x5a5a5a5a, address + 1);
+        address += 16;
+        for (int i = 0; i < length; i++)
+        {
+            text += line[i];
+            if (!sequence.isEmpty() && text.size() >= next)
+            {
+                text += sequence;
+                next = text.size() + interval;
+            }
+        }
+    }
+    return text + "\r\n> " + Marker + "\r\n";
+}
+
+// ms from the connection until the marker was parsed, -1 on a timeout
+static double receive(const QByteArray &data)
+{
+    QTcpServer server;
+    if (!server.listen(QHostAddress::LocalHost))
+        return -1;
+    QtTelnet telnet;
+    Sink sink;
+    QObject::connect(&telnet, SIGNAL(message(const QString &)), &sink, SLOT(message(const QString &)));
+
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    QObject::connect(&timeout, SIGNAL(timeout()), &loop, SLOT(quit()));
+    QObject::connect(&server, SIGNAL(newConnection()), &loop, SLOT(quit()));
+    QObject::connect(&sink, SIGNAL(done()), &loop, SLOT(quit()));
+    telnet.connectToHost("127.0.0.1", server.serverPort());
+    timeout.start(5000);
+    loop.exec();
+    QTcpSocket *peer = server.nextPendingConnection();
+    if (!peer)
+        return -1;
+
+    QElapsedTimer timer;
+    timer.start();
+    peer->write(data);
+    timeout.start(60000);
+    loop.exec();
+    double ms = timer.nsecsElapsed() / 1e6;
+    telnet.close();
+    return timeout.isActive() ? ms : -1;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    struct Kind
+    {
+        const char *name;
+        QByteArray sequence;
+        int interval;
+    } kinds[] = {
+        { "plain mdw text", QByteArray(), 0 },
+        { "IAC NOP every 64 bytes", QByteArray("\xff\xf1"), 64 },
+        { "IAC IAC every 16 bytes", QByteArray("\xff\xff"), 16 },
+    };
+
+    printf("telnet stream from a local server, best of %d runs\n", Runs);
+    for (unsigned k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++)
+    {
+        const QByteArray data = capture(kinds[k].sequence, kinds[k].interval);
+        double best = -1;
+        for (int run = 0; run < Runs; run++)
+        {
+            double ms = receive(data);
+            if (ms < 0)
+            {
+                fprintf(stderr, "%s: the end marker never came out of the parser\n", kinds[k].name);
+                return 1;
+            }
+            if (best < 0 || ms < best)
+                best = ms;
+        }
+        printf("  %-30s %5.1f MiB %9.1f ms %8.1f MB/s\n", kinds[k].name,
+               data.size() / 1048576.0, best, data.size() / 1e3 / best);
+    }
+    return 0;
+}
+
+#include "telnet_bench.moc"
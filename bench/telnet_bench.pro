@@ -0,0 +1,15 @@
+# QTTELNET=<dir> builds against another QtTelnet, e.g. one checked out from
+# before the stream parser changed, to compare the two
+isEmpty(QTTELNET): QTTELNET = ../QtTelnet
+
+TEMPLATE = app
+TARGET = telnet_bench
+CONFIG += console release
+CONFIG -= app_bundle
+QT += network
+QT -= gui
+DEPENDPATH += . $$QTTELNET
+INCLUDEPATH += . $$QTTELNET
+
+HEADERS += $$QTTELNET/qttelnet.h
+SOURCES += telnet_bench.cpp $$QTTELNET/qttelnet.cpp
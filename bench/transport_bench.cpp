@@ -0,0 +1,180 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ocdtransport.h"
+#include "mockocd.h"
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QtAlgorithms>
+#include <cstdio>
+
+static const int Pings = 200;		// commands per measurement
+static const int FrameMs = 20;		// the busy GUI blocks once per frame
+
+// Round trip of one command through TelnetTransport and TclRpcTransport
+// while the GUI thread is busy: a timer blocks the event loop for some ms
+// every frame, as a long repaint would. "net" is the latency the reply
+// reports, "seen" the time from execute() until finished() was handled
+// on the GUI thread. Medians and 99th percentiles in ms.
+
+
+// Blocks the thread it lives on for a while every frame.
+class BusyGui : public QObject
+{
+    Q_OBJECT
+
+public:
+    BusyGui(int ms) : ms(ms)
+    {
+        timer.setInterval(FrameMs);
+        connect(&timer, SIGNAL(timeout()), this, SLOT(frame()));
+        if (ms > 0)
+            timer.start();
+    }
+
+private slots:
+    void frame()
+    {
+        QElapsedTimer clock;
+        clock.start();
+        while (clock.elapsed() < ms)
+            ;
+    }
+
+private:
+    int ms;
+    QTimer timer;
+};
+
+
+// Sends "echo ping" one after the other and keeps both latencies.
+class Pinger : public QObject
+{
+    Q_OBJECT
+
+public:
+    Pinger(OcdTransport *transport) : ok(true), transport(transport) {}
+
+    QVector<double> net;
+    QVector<double> seen;
+    bool ok;
+
+signals:
+    void done();
+
+public slots:
+    void ping()
+    {
+        if (seen.size() == Pings)
+        {
+            emit done();
+            return;
+        }
+        OcdReply *reply = transport->execute("echo ping");
+        connect(reply, SIGNAL(finished()), this, SLOT(replyFinished()));
+        clock.start();
+    }
+
+private slots:
+    void replyFinished()
+    {
+        OcdReply *reply = qobject_cast<OcdReply *>(sender());
+        seen << clock.nsecsElapsed() / 1e6;
+        net << reply->latency() / 1e3;
+        if (reply->isAborted() || !reply->response().contains("ping"))
+            ok = false;
+        reply->deleteLater();
+        ping();
+    }
+
+private:
+    OcdTransport *transport;
+    QElapsedTimer clock;
+};
+
+
+// runs the event loop until sender emits signal, false after 60 s
+static bool waitFor(QObject *sender, const char *signal)
+{
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    QObject::connect(sender, signal, &loop, SLOT(quit()));
+    QObject::connect(&timeout, SIGNAL(timeout()), &loop, SLOT(quit()));
+    timeout.start(60000);
+    loop.exec();
+    return timeout.isActive();
+}
+
+static double percentile(QVector<double> values, int percent)
+{
+    qSort(values);
+    return values.at(qMin(values.size() - 1, values.size() * percent / 100));
+}
+
+static bool measure(const char *name, OcdTransport *transport, MockOcd *mock, int busyMs)
+{
+    if (!mock->listen())
+        return false;
+    transport->connectToHost("127.0.0.1", mock->port());
+    if (!transport->isConnected() && !waitFor(transport, SIGNAL(connected())))
+        return false;
+
+    Pinger pinger(transport);
+    BusyGui busy(busyMs);
+    QTimer::singleShot(0, &pinger, SLOT(ping()));
+    if (!waitFor(&pinger, SIGNAL(done())) || !pinger.ok)
+        return false;
+    transport->close();
+    printf("  %-8s %3d ms busy %8.2f %8.2f %8.2f %8.2f\n", name, busyMs,
+           percentile(pinger.net, 50), percentile(pinger.net, 99),
+           percentile(pinger.seen, 50), percentile(pinger.seen, 99));
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    const int busy[] = { 0, 5, 15 };
+
+    printf("%d pings, GUI busy for n ms every %d ms\n", Pings, FrameMs);
+    printf("  %-8s %10s %8s %8s %8s %8s\n", "", "", "net p50", "net p99", "seen p50", "seen p99");
+    for (unsigned i = 0; i < sizeof(busy) / sizeof(busy[0]); i++)
+    {
+        MockOcd telnetMock(MockOcd::Telnet);
+        TelnetTransport telnet;
+        if (!measure("telnet", &telnet, &telnetMock, busy[i]))
+        {
+            fprintf(stderr, "telnet: no connection or a wrong answer\n");
+            return 1;
+        }
+        MockOcd tclMock(MockOcd::TclRpc);
+        TclRpcTransport tcl;
+        if (!measure("tcl rpc", &tcl, &tclMock, busy[i]))
+        {
+            fprintf(stderr, "tcl rpc: no connection or a wrong answer\n");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#include "transport_bench.moc"
@@ -0,0 +1,11 @@
+TEMPLATE = app
+TARGET = transport_bench
+CONFIG += console release
+CONFIG -= app_bundle
+QT += network
+QT -= gui
+DEPENDPATH += . .. ../QtTelnet ../tests/shared
+INCLUDEPATH += . .. ../QtTelnet ../tests/shared
+
+HEADERS += ../ocdtransport.h ../spscqueue.h ../QtTelnet/qttelnet.h ../tests/shared/mockocd.h
+SOURCES += transport_bench.cpp ../ocdtransport.cpp ../QtTelnet/qttelnet.cpp ../tests/shared/mockocd.cpp
@@ -1,7 +1,7 @@
 #!/bin/sh
 
 make distclean
-qmake -project
+qmake -project -norecursive . QtTelnet
 mv OpenOCD-QtGUI.pro OpenOCD-QtGUI.pro.tmp
 cat OpenOCD-QtGUI.pro.tmp | sed 's/\#\ Input/QT\ +=\ network/g' > OpenOCD-QtGUI.pro
 qmake
@@ -0,0 +1,253 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "dump.h"
+#include "memparse.h"
+#include "ocdtransport.h"
+#include "gdbremote.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QTextStream>
+#include <QStringList>
+
+static const quint32 BinaryChunk = 64 * 1024;	// per GDB read or dump_image
+static const quint32 TextChunk = 16 * 1024;	// per mdw, almost three times that as text
+
+static QString sidecarOf(const QString &fileName)
+{
+    return fileName + ".part";
+}
+
+
+MemoryDump::MemoryDump(GdbRemote *gdb, QObject *parent)
+    : QObject(parent), gdb(gdb), method(Text), address(0), length(0), done(0), chunk(0), resumedAt(0),
+      reply(0), running(false)
+{
+    connect(gdb, SIGNAL(memoryRead(quint32, QByteArray)), this, SLOT(gdbRead(quint32, QByteArray)));
+    connect(gdb, SIGNAL(disconnected()), this, SLOT(linkLost()));
+    connect(gdb, SIGNAL(error(QString)), this, SLOT(linkLost(QString)));
+}
+
+void MemoryDump::setTransport(OcdTransport *transport)
+{
+    if (transport == this->transport)
+        return;
+    if (this->transport)
+        disconnect(this->transport, 0, this, 0);
+    this->transport = transport;
+    connect(transport, SIGNAL(disconnected()), this, SLOT(linkLost()));
+    connect(transport, SIGNAL(error(QString)), this, SLOT(linkLost(QString)));
+}
+
+bool MemoryDump::start(const QString &fileName, quint32 address, quint32 length, Method method) // carries on with a partial dump of the same range
+{
+    if (running)
+    {
+        message = "Dump already running";
+        return false;
+    }
+    if (method == Gdb ? !gdb->isConnected() : (!transport || !transport->isConnected()))
+    {
+        message = (method == Gdb) ? "GDB not connected" : "Not connected";
+        return false;
+    }
+    if (length == 0 || quint32(address + length - 1) < address)
+    {
+        message = "Invalid range";
+        return false;
+    }
+
+    quint32 partAddress, partLength, partDone;
+    resumedAt = 0;
+    if (partial(fileName, &partAddress, &partLength, &partDone) && partAddress == address && partLength == length)
+        resumedAt = partDone;
+    out.setFileName(fileName);
+    if (!out.open(resumedAt ? QIODevice::ReadWrite : QIODevice::WriteOnly | QIODevice::Truncate)
+        || !out.resize(resumedAt) || !out.seek(resumedAt))
+    {
+        out.close();
+        message = "Can not write " + fileName;
+        return false;
+    }
+
+    this->address = address;
+    this->length = length;
+    this->method = method;
+    done = resumedAt;
+    scratch = QDir::tempPath() + QString("/oocdqt-dump-%1.bin").arg(QCoreApplication::applicationPid());
+    message.clear();
+    running = true;
+    clock.start();
+    next();
+    return true;
+}
+
+bool MemoryDump::partial(const QString &fileName, quint32 *address, quint32 *length, quint32 *done) // range and progress of an unfinished dump
+{
+    QFile sidecar(sidecarOf(fileName));
+    if (!sidecar.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+    QStringList fields = QTextStream(&sidecar).readLine().split(' ', QString::SkipEmptyParts);
+    bool addressOk, lengthOk, doneOk;
+    *address = fields.value(0).toUInt(&addressOk, 0);
+    *length = fields.value(1).toUInt(&lengthOk, 0);
+    *done = fields.value(2).toUInt(&doneOk, 0);
+    return addressOk && lengthOk && doneOk && *done <= *length && QFile(fileName).size() >= *done;
+}
+
+void MemoryDump::cancel() // the sidecar stays, so the dump can be resumed
+{
+    if (!running)
+        return;
+    if (method == Gdb)
+        gdb->cancel();
+    reply = 0;		// a read in flight is dropped when it comes back
+    stop(false, QString("Dump cancelled after %1 of %2 bytes, start it again to resume").arg(done).arg(length));
+}
+
+
+
+// private Slots:
+void MemoryDump::chunkRead()
+{
+    OcdReply *finished = qobject_cast<OcdReply *>(sender());
+    if (!finished)
+        return;
+    finished->deleteLater();
+    if (finished != reply || !running)
+        return;
+    reply = 0;
+
+    quint32 at = address + done;
+    if (finished->failed())
+    {
+        stop(false, QString("Read at 0x%1 failed").arg(at, 8, 16, QChar('0')));
+        return;
+    }
+    QByteArray data;
+    if (method == DumpImage)
+    {
+        QFile part(scratch);
+        if (part.open(QIODevice::ReadOnly))
+            data = part.readAll();
+        part.close();
+        QFile::remove(scratch);
+        if (quint32(data.size()) != chunk)
+        {
+            stop(false, QString("dump_image left %1 of %2 bytes in %3, does openOCD run on another host?")
+                 .arg(data.size()).arg(chunk).arg(scratch));
+            return;
+        }
+    }
+    else
+    {
+        data = MemoryParser::dump(finished->response(), at, 4, int((chunk + 3) & ~3u));
+        if (data.isEmpty())
+        {
+            stop(false, QString("Unexpected mdw output at 0x%1").arg(at, 8, 16, QChar('0')));
+            return;
+        }
+        data.truncate(chunk);	// the last word may reach past the range
+    }
+    if (append(data))
+        next();
+}
+
+void MemoryDump::gdbRead(quint32 at, const QByteArray &data)
+{
+    if (!running || method != Gdb || at != address + done)
+        return;
+    if (data.isEmpty())
+    {
+        stop(false, QString("GDB read at 0x%1 failed").arg(at, 8, 16, QChar('0')));
+        return;
+    }
+    if (append(data))
+        next();
+}
+
+void MemoryDump::linkLost(const QString &message)
+{
+    if (!running || (sender() == gdb) != (method == Gdb))
+        return;
+    reply = 0;
+    stop(false, QString("Connection lost after %1 of %2 bytes%3, start the dump again to resume")
+         .arg(done).arg(length).arg(message.isEmpty() ? QString() : " (" + message + ")"));
+}
+
+
+
+// private Funktions:
+void MemoryDump::next()
+{
+    if (done >= length)
+    {
+        qint64 ms = qMax<qint64>(clock.elapsed(), 1);
+        stop(true, QString("Dumped %1 bytes from 0x%2 to %3 in %4 s (%5 KiB/s)%6")
+             .arg(length).arg(address, 8, 16, QChar('0')).arg(out.fileName()).arg(ms / 1000.0, 0, 'f', 1)
+             .arg((length - resumedAt) * 1000.0 / 1024 / ms, 0, 'f', 1)
+             .arg(resumedAt ? QString(", resumed at %1").arg(resumedAt) : QString()));
+        return;
+    }
+
+    chunk = qMin(length - done, method == Text ? TextChunk : BinaryChunk);
+    quint32 at = address + done;
+    if (method == Gdb)
+    {
+        gdb->readMemory(at, chunk);
+        return;
+    }
+    QString command;
+    if (method == DumpImage)	// openOCD writes binary into a file on its host, this one if it is local
+        command = QString("dump_image %1 0x%2 %3").arg(scratch).arg(at, 8, 16, QChar('0')).arg(chunk);
+    else
+        command = QString("mdw 0x%1 %2").arg(at, 8, 16, QChar('0')).arg((chunk + 3) / 4);
+    reply = transport->execute(command);
+    connect(reply, SIGNAL(finished()), this, SLOT(chunkRead()));
+}
+
+bool MemoryDump::append(const QByteArray &data) // the chunk first, then the sidecar that counts it
+{
+    if (out.write(data) != data.size() || !out.flush())
+    {
+        stop(false, "Can not write " + out.fileName());
+        return false;
+    }
+    done += data.size();
+
+    QFile sidecar(sidecarOf(out.fileName()));
+    if (sidecar.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        QTextStream(&sidecar) << QString("0x%1 0x%2 0x%3\n").arg(address, 8, 16, QChar('0'))
+                                 .arg(length, 8, 16, QChar('0')).arg(done, 8, 16, QChar('0'));
+
+    qint64 ms = qMax<qint64>(clock.elapsed(), 1);
+    emit progress(done, length, (done - resumedAt) * 1000.0 / 1024 / ms);
+    return true;
+}
+
+void MemoryDump::stop(bool ok, const QString &text)
+{
+    running = false;
+    out.close();
+    if (ok)
+        QFile::remove(sidecarOf(out.fileName()));
+    if (method == DumpImage)
+        QFile::remove(scratch);
+    message = text;
+    emit finished(ok, text);
+}
@@ -0,0 +1,85 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DUMP_H
+#define DUMP_H
+
+#include <QObject>
+#include <QFile>
+#include <QPointer>
+#include <QElapsedTimer>
+
+class OcdTransport;
+class OcdReply;
+class GdbRemote;
+
+// Saves a range of target memory to a file, one chunk at a time, so the
+// range never has to fit into memory. A sidecar file next to the output
+// ("<file>.part") records the range and how much of it is on disk; it
+// goes away when the dump is complete, else start() carries on after the
+// last chunk written.
+class MemoryDump : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Method { Gdb, DumpImage, Text };	// fastest first
+
+    MemoryDump(GdbRemote *gdb, QObject *parent = 0);
+
+    void setTransport(OcdTransport *transport);
+
+    bool start(const QString &fileName, quint32 address, quint32 length, Method method);
+    bool isRunning() const { return running; }
+    QString errorString() const { return message; }
+    static bool partial(const QString &fileName, quint32 *address, quint32 *length, quint32 *done);
+
+public slots:
+    void cancel();
+
+signals:
+    void progress(qint64 done, qint64 total, double rate);	// KiB/s of this run
+    void finished(bool ok, const QString &message);
+
+private slots:
+    void chunkRead();
+    void gdbRead(quint32 address, const QByteArray &data);
+    void linkLost(const QString &message = QString());
+
+private:
+    void next();
+    bool append(const QByteArray &data);
+    void stop(bool ok, const QString &text);
+
+    QPointer<OcdTransport> transport;
+    GdbRemote *gdb;
+    Method method;
+    QFile out;
+    quint32 address;
+    quint32 length;
+    quint32 done;		// bytes on disk
+    quint32 chunk;		// size of the read in flight
+    quint32 resumedAt;
+    OcdReply *reply;
+    QString scratch;		// file of dump_image
+    QElapsedTimer clock;
+    bool running;
+    QString message;
+};
+
+#endif // DUMP_H
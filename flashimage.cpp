@@ -0,0 +1,215 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "flashimage.h"
+#include <QFileInfo>
+#include <QTemporaryFile>
+#include <QDir>
+
+static const int ElfHeaderSize = 52;
+static const int ElfPhdrSize = 32;
+static const quint32 PT_LOAD = 1;
+
+
+static quint16 elfHalf(const uchar *p, bool big)
+{
+    return big ? quint16(p[0] << 8 | p[1]) : quint16(p[1] << 8 | p[0]);
+}
+
+static quint32 elfWord(const uchar *p, bool big)
+{
+    return big ? quint32(elfHalf(p, big)) << 16 | elfHalf(p + 2, big)
+               : quint32(elfHalf(p + 2, big)) << 16 | elfHalf(p, big);
+}
+
+
+FlashImage::FlashImage() : map(0), size(0), type(Invalid)
+{
+}
+
+FlashImage::~FlashImage()
+{
+    close();
+}
+
+bool FlashImage::open(const QString &fileName, quint32 binaryBase)
+{
+    close();
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return fail("Can not read " + fileName);
+    size = file.size();
+    if (size <= 0)
+        return fail(fileName + " is empty");
+    map = file.map(0, size);
+    if (!map)
+        return fail("Can not map " + fileName);
+
+    if (size >= 4 && map[0] == 0x7f && map[1] == 'E' && map[2] == 'L' && map[3] == 'F')
+    {
+        type = Elf;
+        return parseElf();
+    }
+    if (QFileInfo(fileName).suffix().toLower() == "elf")
+        return fail(fileName + " is not an ELF file");
+
+    if (size > qint64(0xffffffffu - binaryBase) + 1)
+        return fail(fileName + " does not fit into the address space");
+    type = Binary;		// one segment, the whole file
+    Segment segment;
+    segment.address = binaryBase;
+    segment.size = quint32(size);
+    segment.offset = 0;
+    parts << segment;
+    return true;
+}
+
+bool FlashImage::openIn(const QString &fileName, quint32 start, quint32 length) // and check it against a memory range
+{
+    if (!open(fileName, start))
+        return false;
+    QString why;
+    if (!fits(start, length, &why))
+        return fail(fileName + " does not fit, " + why);
+    return true;
+}
+
+void FlashImage::close()
+{
+    if (map)
+        file.unmap(map);
+    map = 0;
+    file.close();
+    size = 0;
+    type = Invalid;
+    parts.clear();
+}
+
+qint64 FlashImage::totalSize() const
+{
+    qint64 total = 0;
+    for (int i = 0; i < parts.size(); i++)
+        total += parts.at(i).size;
+    return total;
+}
+
+QByteArray FlashImage::data(const Segment &segment) const
+{
+    if (!map)
+        return QByteArray();
+    return QByteArray(reinterpret_cast<const char *>(map + segment.offset), segment.size);
+}
+
+bool FlashImage::fits(quint32 start, quint32 length, QString *why) const // all segments inside [start, start+length)
+{
+    for (int i = 0; i < parts.size(); i++)
+    {
+        const Segment &segment = parts.at(i);
+        if (segment.address < start || segment.address - start > length ||
+            segment.size > length - (segment.address - start))
+        {
+            if (why)
+                *why = QString("segment 0x%1-0x%2 is outside 0x%3-0x%4")
+                       .arg(segment.address, 8, 16, QChar('0'))
+                       .arg(quint32(segment.address + segment.size - 1), 8, 16, QChar('0'))
+                       .arg(start, 8, 16, QChar('0'))
+                       .arg(quint32(start + length - 1), 8, 16, QChar('0'));
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+QStringList FlashImage::transferCommands(const QString &write, QList<qint64> *sizes, QStringList *files) const // one per segment
+{
+    QStringList commands;
+    for (int i = 0; i < parts.size(); i++)
+    {
+        QString file = fileName();	// a binary goes as it is
+        if (type == Elf)
+        {
+            file = writeSlice(data(parts.at(i)), parts.at(i).address);
+            if (file.isEmpty())
+                return QStringList();
+            *files << file;
+        }
+        commands << write + file + QString(" 0x%1 bin").arg(parts.at(i).address, 8, 16, QChar('0'));
+        *sizes << parts.at(i).size;
+    }
+    return commands;
+}
+
+QString FlashImage::writeSlice(const QByteArray &data, quint32 address) // part of an image as file for openOCD
+{
+    QTemporaryFile slice(QDir::tempPath() + QString("/oocdqt-%1-XXXXXX.bin").arg(address, 8, 16, QChar('0')));
+    if (!slice.open() || slice.write(data) != data.size())
+        return QString();
+    slice.setAutoRemove(false);	// removed once openOCD is done with it
+    return slice.fileName();
+}
+
+
+
+// private Funktions:
+bool FlashImage::parseElf() // program headers of a 32 bit executable
+{
+    if (size < ElfHeaderSize || map[4] != 1)
+        return fail(file.fileName() + " is not a 32 bit ELF file");
+    bool big = (map[5] == 2);
+    if (map[5] != 1 && !big)
+        return fail(file.fileName() + " has an unknown byte order");
+
+    quint32 phoff = elfWord(map + 28, big);
+    quint16 phentsize = elfHalf(map + 42, big);
+    quint16 phnum = elfHalf(map + 44, big);
+    if (phnum == 0)
+        return fail(file.fileName() + " has no program headers");
+    if (phentsize < ElfPhdrSize || qint64(phoff) + qint64(phnum) * phentsize > size)
+        return fail(file.fileName() + " has broken program headers");
+
+    for (int i = 0; i < phnum; i++)
+    {
+        qint64 ph = qint64(phoff) + qint64(i) * phentsize;
+        quint32 offset = elfWord(map + ph + 4, big);
+        quint32 paddr = elfWord(map + ph + 12, big);
+        quint32 filesz = elfWord(map + ph + 16, big);
+        if (elfWord(map + ph, big) != PT_LOAD || filesz == 0)
+            continue;		// nothing to load, .bss is cleared by the startup code
+        if (qint64(offset) + filesz > size)
+            return fail(QString("%1: segment %2 ends behind the end of the file").arg(file.fileName()).arg(i));
+        if (quint64(paddr) + filesz > Q_UINT64_C(0x100000000))
+            return fail(QString("%1: segment %2 wraps the address space").arg(file.fileName()).arg(i));
+        Segment segment;
+        segment.address = paddr;	// load address, like openOCD uses it
+        segment.size = filesz;
+        segment.offset = offset;
+        parts << segment;
+    }
+    if (parts.isEmpty())
+        return fail(file.fileName() + " has nothing to load");
+    return true;
+}
+
+bool FlashImage::fail(const QString &text)
+{
+    close();
+    message = text;
+    return false;
+}
@@ -0,0 +1,76 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FLASHIMAGE_H
+#define FLASHIMAGE_H
+
+#include <QFile>
+#include <QList>
+#include <QStringList>
+#include <QString>
+#include <QByteArray>
+
+// Load image for the target, a raw binary or an ELF32 executable. The file
+// is memory-mapped and split into the segments that end up in target
+// memory, so they can be checked against the memory map before any
+// transfer starts and then be sent one by one. Segments of an ELF file are
+// handed to openOCD as temporary binary slices.
+class FlashImage
+{
+public:
+    enum Format { Invalid, Binary, Elf };
+
+    struct Segment
+    {
+        quint32 address;
+        quint32 size;
+        qint64 offset;		// in the file
+    };
+
+    FlashImage();
+    ~FlashImage();
+
+    bool open(const QString &fileName, quint32 binaryBase);
+    bool openIn(const QString &fileName, quint32 start, quint32 length);
+    void close();
+
+    Format format() const { return type; }
+    QString fileName() const { return file.fileName(); }
+    QString errorString() const { return message; }
+    const QList<Segment> &segments() const { return parts; }
+    qint64 totalSize() const;
+
+    QByteArray data(const Segment &segment) const;
+    bool fits(quint32 start, quint32 size, QString *why) const;
+    QStringList transferCommands(const QString &write, QList<qint64> *sizes, QStringList *files) const;
+
+    static QString writeSlice(const QByteArray &data, quint32 address);
+
+private:
+    bool parseElf();
+    bool fail(const QString &text);
+
+    QFile file;
+    uchar *map;
+    qint64 size;
+    Format type;
+    QList<Segment> parts;
+    QString message;
+};
+
+#endif // FLASHIMAGE_H
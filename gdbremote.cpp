@@ -0,0 +1,398 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gdbremote.h"
+#include <QTcpSocket>
+#include <QStringList>
+
+#define GDB_DEFAULT_PACKET 400		// until qSupported tells otherwise
+#define GDB_MAX_PACKET (64 * 1024)
+
+
+GdbRemote::GdbRemote(QObject *parent) : QObject(parent),
+    state(Unconnected), noAck(false), binaryWrite(true), waiting(false), cancelling(false),
+    maxPacket(GDB_DEFAULT_PACKET), chunk(0)
+{
+    socket = new QTcpSocket(this);
+    connect(socket, SIGNAL(connected()), this, SLOT(socketConnected()));
+    connect(socket, SIGNAL(disconnected()), this, SLOT(socketDisconnected()));
+    connect(socket, SIGNAL(readyRead()), this, SLOT(socketReadyRead()));
+    connect(socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(socketError()));
+}
+
+void GdbRemote::connectToHost(const QString &host, quint16 port)
+{
+    if (socket->state() != QAbstractSocket::UnconnectedState)
+        return;
+    socket->connectToHost(host, port);
+}
+
+void GdbRemote::close()
+{
+    if (socket->state() == QAbstractSocket::UnconnectedState)
+        return;
+    if (state == Ready && !waiting)
+        sendPacket("D");	// detach, no reply needed
+    socket->disconnectFromHost();
+}
+
+bool GdbRemote::isConnected() const
+{
+    return state == Ready;
+}
+
+bool GdbRemote::isBusy() const
+{
+    return !transfers.isEmpty();
+}
+
+void GdbRemote::monitor(const QString &command) // like "monitor ..." in gdb
+{
+    Transfer transfer;
+    transfer.type = Transfer::Monitor;
+    transfer.address = 0;
+    transfer.done = 0;
+    transfer.command = command;
+    transfers.enqueue(transfer);
+    sendNext();
+}
+
+void GdbRemote::readMemory(quint32 address, quint32 length)
+{
+    Transfer transfer;
+    transfer.type = Transfer::Read;
+    transfer.address = address;
+    transfer.done = 0;
+    transfer.data.reserve(length);
+    transfer.command = QString::number(length);
+    transfers.enqueue(transfer);
+    sendNext();
+}
+
+void GdbRemote::writeMemory(quint32 address, const QByteArray &data)
+{
+    Transfer transfer;
+    transfer.type = Transfer::Write;
+    transfer.address = address;
+    transfer.done = 0;
+    transfer.data = data;
+    transfers.enqueue(transfer);
+    sendNext();
+}
+
+void GdbRemote::cancel() // drop everything not yet on the wire, cancelled() once the line is quiet
+{
+    if (transfers.isEmpty())
+        return;
+    while (transfers.size() > (waiting ? 1 : 0))
+        transfers.removeLast();
+    if (!waiting)
+    {
+        emit cancelled(0, 0);
+        return;
+    }
+    Transfer &current = transfers.head();
+    if (current.type == Transfer::Write)
+        current.data.truncate(current.done + chunk);
+    else if (current.type == Transfer::Read)
+        current.command = QString::number(current.done + chunk);
+    cancelling = true;
+}
+
+
+
+// private Slots:
+void GdbRemote::socketConnected()
+{
+    received.clear();
+    noAck = false;
+    binaryWrite = true;
+    maxPacket = GDB_DEFAULT_PACKET;
+    state = Supported;
+    sendPacket("qSupported:multiprocess-;swbreak+;hwbreak+");
+}
+
+void GdbRemote::socketReadyRead()
+{
+    received += socket->readAll();
+
+    while (!received.isEmpty())
+    {
+        char c = received.at(0);
+        if (c == '+')			// ack
+        {
+            received.remove(0, 1);
+            continue;
+        }
+        if (c == '-')			// nak, send again
+        {
+            received.remove(0, 1);
+            if (!lastPacket.isEmpty())
+                socket->write(lastPacket);
+            continue;
+        }
+        if (c != '$')			// line noise or notification
+        {
+            int start = received.indexOf('$');
+            received.remove(0, start == -1 ? received.size() : start);
+            continue;
+        }
+
+        int end = received.indexOf('#');
+        if (end == -1 || received.size() < end + 3)
+            return;			// wait for the rest
+        QByteArray payload = received.mid(1, end - 1);
+        bool ok;
+        int sum = received.mid(end + 1, 2).toInt(&ok, 16);
+        received.remove(0, end + 3);
+
+        quint8 check = 0;
+        for (int i = 0; i < payload.size(); i++)
+            check += quint8(payload.at(i));
+        if (!ok || check != sum)
+        {
+            if (noAck)
+            {
+                fail("GDB: Checksum error");
+                return;
+            }
+            socket->write("-");
+            continue;
+        }
+        if (!noAck)
+            socket->write("+");
+        handlePacket(payload);
+    }
+}
+
+void GdbRemote::socketDisconnected()
+{
+    bool wasReady = (state != Unconnected);
+    state = Unconnected;
+    waiting = false;
+    cancelling = false;
+    transfers.clear();
+    if (wasReady)
+        emit disconnected();
+}
+
+void GdbRemote::socketError()
+{
+    emit error("GDB: " + socket->errorString());
+}
+
+
+
+// private Funktions:
+void GdbRemote::sendPacket(const QByteArray &payload)
+{
+    quint8 sum = 0;
+    for (int i = 0; i < payload.size(); i++)
+        sum += quint8(payload.at(i));
+
+    lastPacket = '$' + payload + '#' + QByteArray::number(sum, 16).rightJustified(2, '0');
+    socket->write(lastPacket);
+}
+
+void GdbRemote::sendNext()
+{
+    if (state != Ready || waiting || transfers.isEmpty())
+        return;
+
+    const Transfer &transfer = transfers.head();
+    switch (transfer.type)
+    {
+    case Transfer::Monitor:
+        chunk = 0;
+        sendPacket("qRcmd," + transfer.command.toLocal8Bit().toHex());
+        break;
+    case Transfer::Read:
+    {
+        // hex reply, two characters per byte plus "$#xx"
+        qint64 length = transfer.command.toLongLong();
+        chunk = int(qMin<qint64>(length - transfer.done, (maxPacket - 4) / 2));
+        sendPacket("m" + QByteArray::number(transfer.address + quint32(transfer.done), 16)
+                   + "," + QByteArray::number(chunk, 16));
+        break;
+    }
+    case Transfer::Write:
+        sendPacket(writePacket(transfer, &chunk));
+        break;
+    }
+    waiting = true;
+}
+
+QByteArray GdbRemote::writePacket(const Transfer &transfer, int *length) const
+{
+    QByteArray header = QByteArray(binaryWrite ? "X" : "M")
+                        + QByteArray::number(transfer.address + quint32(transfer.done), 16) + ",";
+    // leave room for the length field, the colon and "$#xx"
+    int room = maxPacket - header.size() - 8 - 1 - 4;
+    const char *data = transfer.data.constData() + transfer.done;
+    int left = int(transfer.data.size() - transfer.done);
+    QByteArray body;
+
+    if (binaryWrite)
+    {
+        body.reserve(room);
+        int n = 0;
+        for (; n < left && body.size() < room - 1; n++)
+        {
+            char c = data[n];
+            if (c == '#' || c == '$' || c == '}' || c == '*')
+            {
+                body += '}';
+                c ^= 0x20;
+            }
+            body += c;
+        }
+        *length = n;
+    }
+    else
+    {
+        *length = qMin(left, room / 2);
+        body = QByteArray::fromRawData(data, *length).toHex();
+    }
+    return header + QByteArray::number(*length, 16) + ":" + body;
+}
+
+void GdbRemote::handlePacket(const QByteArray &payload)
+{
+    switch (state)
+    {
+    case Supported:
+    {
+        QList<QByteArray> features = payload.split(';');
+        bool startNoAck = false;
+        for (int i = 0; i < features.size(); i++)
+        {
+            if (features.at(i).startsWith("PacketSize="))
+            {
+                bool ok;
+                int size = features.at(i).mid(11).toInt(&ok, 16);
+                if (ok && size > 0)
+                    maxPacket = qMin(size, GDB_MAX_PACKET);
+            }
+            else if (features.at(i) == "QStartNoAckMode+")
+                startNoAck = true;
+        }
+        if (startNoAck)
+        {
+            state = NoAck;
+            sendPacket("QStartNoAckMode");
+            return;
+        }
+        state = Ready;
+        emit connected();
+        sendNext();
+        break;
+    }
+    case NoAck:
+        noAck = (payload == "OK");
+        state = Ready;
+        emit connected();
+        sendNext();
+        break;
+    case Ready:
+        handleTransfer(payload);
+        break;
+    default:
+        break;
+    }
+}
+
+void GdbRemote::handleTransfer(const QByteArray &payload)
+{
+    if (!waiting || transfers.isEmpty())
+        return;			// stop reply or other unrequested packet
+    Transfer &transfer = transfers.head();
+
+    if (transfer.type == Transfer::Monitor && payload.startsWith('O') && payload != "OK")
+    {
+        emit output(QString::fromLocal8Bit(QByteArray::fromHex(payload.mid(1))));
+        return;			// more to come
+    }
+    waiting = false;
+
+    if (payload.startsWith('E') && payload.size() == 3)
+    {
+        fail(QString("GDB: Target error %1 at 0x%2").arg(QString(payload.mid(1)))
+             .arg(transfer.address + quint32(transfer.done), 8, 16, QChar('0')));
+        return;
+    }
+
+    switch (transfer.type)
+    {
+    case Transfer::Monitor:
+        if (!endCancelled())
+            emit monitorFinished(transfers.dequeue().command);
+        break;
+    case Transfer::Read:
+    {
+        QByteArray bytes = QByteArray::fromHex(payload);
+        if (bytes.isEmpty())
+        {
+            fail(QString("GDB: No data at 0x%1").arg(transfer.address + quint32(transfer.done), 8, 16, QChar('0')));
+            return;
+        }
+        transfer.data += bytes;
+        transfer.done += bytes.size();
+        qint64 length = transfer.command.toLongLong();
+        emit progress(transfer.done, length);
+        if (transfer.done >= length && !endCancelled())
+        {
+            Transfer finished = transfers.dequeue();
+            emit memoryRead(finished.address, finished.data);
+        }
+        break;
+    }
+    case Transfer::Write:
+        if (payload.isEmpty() && binaryWrite)	// X not supported, use M
+        {
+            binaryWrite = false;
+            break;
+        }
+        transfer.done += chunk;
+        emit progress(transfer.done, transfer.data.size());
+        if (transfer.done >= transfer.data.size() && !endCancelled())
+        {
+            Transfer finished = transfers.dequeue();
+            emit memoryWritten(finished.address, finished.data.size());
+        }
+        break;
+    }
+    sendNext();
+}
+
+void GdbRemote::fail(const QString &message) // drop the queue, keep the connection
+{
+    transfers.clear();
+    waiting = false;
+    cancelling = false;
+    emit error(message);
+}
+
+bool GdbRemote::endCancelled() // the cut transfer is complete: cancelled() instead of its result
+{
+    if (!cancelling)
+        return false;
+    cancelling = false;
+    Transfer cut = transfers.dequeue();
+    emit cancelled(cut.address, cut.type == Transfer::Write ? cut.data.size() : 0);
+    return true;
+}
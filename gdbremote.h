@@ -0,0 +1,100 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GDBREMOTE_H
+#define GDBREMOTE_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QQueue>
+
+class QTcpSocket;
+
+// Client for the gdb remote serial protocol on openOCD's gdb_port, used as
+// the binary path for bulk memory reads and writes. Transfers are queued and
+// carried out one packet at a time, as large as the server allows.
+class GdbRemote : public QObject
+{
+    Q_OBJECT
+
+public:
+    GdbRemote(QObject *parent = 0);
+
+    void connectToHost(const QString &host, quint16 port = 3333);
+    void close();
+    bool isConnected() const;
+    bool isBusy() const;
+    int packetSize() const { return maxPacket; }
+
+    void monitor(const QString &command);
+    void readMemory(quint32 address, quint32 length);
+    void writeMemory(quint32 address, const QByteArray &data);
+    void cancel();
+
+signals:
+    void connected();
+    void disconnected();
+    void error(const QString &message);
+    void output(const QString &text);		// of monitor commands
+    void progress(qint64 done, qint64 total);
+    void monitorFinished(const QString &command);
+    void memoryRead(quint32 address, const QByteArray &data);
+    void memoryWritten(quint32 address, qint64 length);
+    void cancelled(quint32 address, qint64 written);	// after cancel(), for the cut transfer
+
+private slots:
+    void socketConnected();
+    void socketReadyRead();
+    void socketDisconnected();
+    void socketError();
+
+private:
+    struct Transfer
+    {
+        enum Type { Monitor, Read, Write } type;
+        quint32 address;
+        QByteArray data;
+        qint64 done;
+        QString command;
+    };
+
+    enum State { Unconnected, Supported, NoAck, Ready };
+
+    void sendPacket(const QByteArray &payload);
+    void sendNext();
+    void handlePacket(const QByteArray &payload);
+    void handleTransfer(const QByteArray &payload);
+    void fail(const QString &message);
+    bool endCancelled();
+    QByteArray writePacket(const Transfer &transfer, int *length) const;
+
+    QTcpSocket *socket;
+    QByteArray received;
+    QByteArray lastPacket;
+    QQueue<Transfer> transfers;
+    State state;
+    bool noAck;
+    bool binaryWrite;
+    bool waiting;
+    bool cancelling;	// the transfer in flight was cut by cancel()
+    int maxPacket;
+    int chunk;		// bytes covered by the packet in flight
+};
+
+#endif // GDBREMOTE_H
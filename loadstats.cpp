@@ -0,0 +1,197 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "loadstats.h"
+#include "ocdtransport.h"
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <QRegExp>
+#include <QPainter>
+#include <QPaintEvent>
+
+
+LoadRecord::LoadRecord() : bytes(0), haltMs(0), eraseMs(0), writeMs(0), verifyMs(0),
+                           reportedBytes(0), reportedSeconds(0), erasedSectors(0), ok(true)
+{
+}
+
+void LoadRecord::account(const QString &command, const QString &response, qint64 usecs) // one finished command of the run
+{
+    static QRegExp wrote("(?:wrote|downloaded) (\\d+) bytes[^\\n]* in ([0-9.]+) ?s");
+    static QRegExp erased("erased sectors (\\d+) through (\\d+)");
+    qint64 ms = usecs / 1000;
+
+    if (command.contains("verify_image"))
+        verifyMs += ms;
+    else if (command.contains("write_image") || command.contains("load_image") || command.contains("write_bank"))
+        writeMs += ms;		// including the erase of "write_image erase"
+    else if (command.contains("erase"))
+        eraseMs += ms;
+    else if (command.contains("halt"))
+        haltMs += ms;
+
+    if (wrote.indexIn(response) != -1)
+    {
+        reportedBytes += wrote.cap(1).toLongLong();
+        reportedSeconds += wrote.cap(2).toDouble();
+    }
+    for (int pos = 0; (pos = erased.indexIn(response, pos)) != -1; pos += erased.matchedLength())
+        erasedSectors += erased.cap(2).toInt() - erased.cap(1).toInt() + 1;
+    if (!OcdReply::errorLine(response).isNull())
+        ok = false;
+}
+
+double LoadRecord::rate() const // as reported by openOCD if it did, else timed here
+{
+    if (reportedBytes && reportedSeconds > 0)
+        return reportedBytes / 1024.0 / reportedSeconds;
+    if (writeMs > 0)
+        return bytes * 1000.0 / 1024 / writeMs;
+    return 0;
+}
+
+QString LoadRecord::toString() const
+{
+    return (QStringList() << when.toString(Qt::ISODate) << target << image
+                         << QString::number(bytes) << QString::number(haltMs) << QString::number(eraseMs)
+                         << QString::number(writeMs) << QString::number(verifyMs)
+                         << QString::number(reportedBytes) << QString::number(reportedSeconds)
+                         << QString::number(erasedSectors) << (ok ? "ok" : "failed")).join("\t");
+}
+
+bool LoadRecord::fromString(const QString &line, LoadRecord *record)
+{
+    QStringList fields = line.split('\t');
+    if (fields.size() < 12)
+        return false;
+    record->when = QDateTime::fromString(fields.at(0), Qt::ISODate);
+    record->target = fields.at(1);
+    record->image = fields.at(2);
+    record->bytes = fields.at(3).toLongLong();
+    record->haltMs = fields.at(4).toLongLong();
+    record->eraseMs = fields.at(5).toLongLong();
+    record->writeMs = fields.at(6).toLongLong();
+    record->verifyMs = fields.at(7).toLongLong();
+    record->reportedBytes = fields.at(8).toLongLong();
+    record->reportedSeconds = fields.at(9).toDouble();
+    record->erasedSectors = fields.at(10).toInt();
+    record->ok = (fields.at(11) == "ok");
+    return record->when.isValid();
+}
+
+
+
+LoadHistory::LoadHistory(const QString &fileName, int runs) : file(fileName), keep(runs)
+{
+}
+
+bool LoadHistory::load()
+{
+    QFile in(file);
+    if (!in.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+    records.clear();
+    QTextStream stream(&in);
+    while (!stream.atEnd())
+    {
+        LoadRecord record;
+        if (LoadRecord::fromString(stream.readLine(), &record))
+            records << record;
+    }
+    return true;
+}
+
+bool LoadHistory::save() const
+{
+    QFile out(file);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+    QTextStream stream(&out);
+    for (int i = 0; i < records.size(); i++)
+        stream << records.at(i).toString() << "\n";
+    return true;
+}
+
+void LoadHistory::add(const LoadRecord &record)
+{
+    records << record;
+    int count = 0;		// drop the oldest runs of this target beyond keep
+    for (int i = records.size() - 1; i >= 0; i--)
+    {
+        if (records.at(i).target == record.target && ++count > keep)
+            records.removeAt(i);
+    }
+}
+
+QList<LoadRecord> LoadHistory::recent(const QString &target, int count) const // oldest first
+{
+    QList<LoadRecord> result;
+    for (int i = records.size() - 1; i >= 0 && result.size() < count; i--)
+        if (records.at(i).target == target)
+            result.prepend(records.at(i));
+    return result;
+}
+
+
+
+Sparkline::Sparkline(QWidget *parent) : QWidget(parent)
+{
+    setMinimumSize(60, 16);
+}
+
+void Sparkline::setValues(const QList<double> &values)
+{
+    points = values;
+    update();
+}
+
+QSize Sparkline::sizeHint() const
+{
+    return QSize(120, 20);
+}
+
+void Sparkline::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    if (points.size() < 2)
+        return;
+    double low = points.first(), high = points.first();
+    for (int i = 1; i < points.size(); i++)
+    {
+        low = qMin(low, points.at(i));
+        high = qMax(high, points.at(i));
+    }
+    if (high - low < 1e-9)
+        high = low + 1;
+
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(palette().color(QPalette::Text));
+    int w = width() - 4, h = height() - 4;
+    QPointF last;
+    for (int i = 0; i < points.size(); i++)
+    {
+        QPointF point(2 + w * i / double(points.size() - 1), 2 + h - h * (points.at(i) - low) / (high - low));
+        if (i)
+            painter.drawLine(last, point);
+        last = point;
+    }
+    painter.setBrush(palette().color(QPalette::Highlight));
+    painter.drawEllipse(last, 2, 2);	// the latest run
+}
@@ -0,0 +1,87 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOADSTATS_H
+#define LOADSTATS_H
+
+#include <QWidget>
+#include <QDateTime>
+#include <QString>
+#include <QList>
+
+// One image download, timed by phase (halt, erase, write, verify) on the
+// GUI side, together with what openOCD reported about the transfer.
+struct LoadRecord
+{
+    LoadRecord();
+
+    void account(const QString &command, const QString &response, qint64 usecs);
+    double rate() const;	// KiB/s
+    QString toString() const;
+    static bool fromString(const QString &line, LoadRecord *record);
+
+    QDateTime when;
+    QString target;
+    QString image;
+    qint64 bytes;
+    qint64 haltMs;
+    qint64 eraseMs;
+    qint64 writeMs;
+    qint64 verifyMs;
+    qint64 reportedBytes;	// "wrote N bytes ... in X s" of openOCD
+    double reportedSeconds;
+    int erasedSectors;
+    bool ok;
+};
+
+// Persistent list of the last runs of every target.
+class LoadHistory
+{
+public:
+    LoadHistory(const QString &fileName, int runs = 100);
+
+    bool load();
+    bool save() const;
+    void add(const LoadRecord &record);
+    QList<LoadRecord> recent(const QString &target, int count) const;
+
+private:
+    QString file;
+    int keep;			// records per target
+    QList<LoadRecord> records;	// oldest first
+};
+
+// Tiny line chart of the throughput of the recent runs.
+class Sparkline : public QWidget
+{
+    Q_OBJECT
+
+public:
+    Sparkline(QWidget *parent = 0);
+
+    void setValues(const QList<double> &values);
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private:
+    QList<double> points;
+};
+
+#endif // LOADSTATS_H
@@ -0,0 +1,288 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "logview.h"
+#include <QTemporaryFile>
+#include <QDir>
+#include <QPainter>
+#include <QScrollBar>
+#include <QApplication>
+#include <QClipboard>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPaintEvent>
+
+static const int SpillStride = 256;	// spilled lines per index entry
+
+
+LineStore::LineStore(int maxLines) : limit(maxLines), spilled(0), spillFile(0), readIndex(-1), readPos(0)
+{
+}
+
+LineStore::~LineStore()
+{
+    delete spillFile;
+}
+
+void LineStore::setMaxLines(int lines)
+{
+    limit = qMax(lines, 100);
+    if (offsets.size() > limit)
+        spill(offsets.size() - limit);
+}
+
+void LineStore::append(const QString &line)
+{
+    offsets.append(arena.size());
+    arena.append(line.toUtf8());
+    arena.append('\n');
+
+    // spill a quarter at a time, so the arena is compacted rarely
+    if (offsets.size() > limit)
+        spill(offsets.size() - limit + limit / 4);
+}
+
+QString LineStore::line(qint64 index)
+{
+    if (index < 0 || index >= count())
+        return QString();
+    if (index < spilled)
+        return spilledLine(index);
+
+    int i = int(index - spilled);
+    int end = (i + 1 < offsets.size()) ? offsets[i + 1] : arena.size();
+    return QString::fromUtf8(arena.constData() + offsets[i], end - offsets[i] - 1);
+}
+
+void LineStore::clear()
+{
+    arena.clear();
+    offsets.clear();
+    spillIndex.clear();
+    spilled = 0;
+    readIndex = -1;
+    delete spillFile;
+    spillFile = 0;
+}
+
+void LineStore::spill(int lines)
+{
+    lines = qMin(lines, offsets.size());
+    if (lines <= 0)
+        return;
+
+    if (!spillFile)
+    {
+        spillFile = new QTemporaryFile(QDir::tempPath() + "/oocdqt-log-XXXXXX");
+        if (!spillFile->open())
+        {
+            delete spillFile;	// no disk: old lines are dropped instead
+            spillFile = 0;
+        }
+    }
+
+    int bytes = (lines < offsets.size()) ? offsets[lines] : arena.size();
+    if (spillFile)
+    {
+        qint64 base = spillFile->size();
+        for (int i = 0; i < lines; ++i)
+            if ((spilled + i) % SpillStride == 0)
+                spillIndex.append(base + offsets[i]);
+        spillFile->seek(base);
+        spillFile->write(arena.constData(), bytes);
+        spilled += lines;
+    }
+
+    arena.remove(0, bytes);
+    offsets.remove(0, lines);
+    for (int i = 0; i < offsets.size(); ++i)
+        offsets[i] -= bytes;
+}
+
+QString LineStore::spilledLine(qint64 index)
+{
+    if (!spillFile)
+        return QString();
+
+    // rows are painted top down, so usually we continue where we stopped
+    qint64 line = readIndex;
+    if (line < 0 || line > index || index - line >= SpillStride)
+    {
+        line = index - index % SpillStride;
+        readPos = spillIndex.at(int(line / SpillStride));
+    }
+    spillFile->seek(readPos);
+    QByteArray text;
+    for (; line <= index; ++line)
+        text = spillFile->readLine();
+    readIndex = line;
+    readPos = spillFile->pos();
+
+    text.chop(1);	// '\n'
+    return QString::fromUtf8(text.constData(), text.size());
+}
+
+
+
+LogView::LogView(QWidget *parent) : QAbstractScrollArea(parent), maxColumns(0), selAnchor(-1), selCursor(-1)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setCursor(Qt::IBeamCursor);
+}
+
+void LogView::setMaxLines(int lines)
+{
+    store.setMaxLines(lines);
+}
+
+int LogView::maxLines() const
+{
+    return store.maxLines();
+}
+
+qint64 LogView::lineCount() const
+{
+    return store.count();
+}
+
+void LogView::appendLines(const QStringList &lines)
+{
+    QScrollBar *s = verticalScrollBar();
+    bool atBottom = (s->value() == s->maximum());	// don't pull the user back down
+
+    for (int i = 0; i < lines.size(); ++i)
+    {
+        QStringList split = lines.at(i).split('\n');
+        for (int j = 0; j < split.size(); ++j)
+        {
+            store.append(split.at(j));
+            maxColumns = qMax(maxColumns, split.at(j).size());
+        }
+    }
+
+    updateScrollBars();
+    if (atBottom)
+        s->setValue(s->maximum());
+    viewport()->update();
+}
+
+void LogView::clear()
+{
+    store.clear();
+    maxColumns = 0;
+    selAnchor = selCursor = -1;
+    updateScrollBars();
+    viewport()->update();
+}
+
+void LogView::copy() // selected lines to the clipboard
+{
+    if (selAnchor < 0)
+        return;
+
+    QStringList text;
+    for (qint64 i = qMin(selAnchor, selCursor); i <= qMax(selAnchor, selCursor); ++i)
+        text << store.line(i);
+    QApplication::clipboard()->setText(text.join("\n"));
+}
+
+void LogView::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    const QFontMetrics fm(font());
+    int lineHeight = fm.lineSpacing();
+    int x = 2 - horizontalScrollBar()->value();
+
+    qint64 first = verticalScrollBar()->value() + event->rect().top() / lineHeight;
+    qint64 last = qMin(store.count() - 1, verticalScrollBar()->value() + qint64(event->rect().bottom() / lineHeight));
+    qint64 selFirst = qMin(selAnchor, selCursor), selLast = qMax(selAnchor, selCursor);
+
+    for (qint64 i = first; i <= last; ++i)
+    {
+        int y = int(i - verticalScrollBar()->value()) * lineHeight;
+        if (selAnchor >= 0 && i >= selFirst && i <= selLast)
+        {
+            painter.fillRect(0, y, viewport()->width(), lineHeight, palette().color(QPalette::Highlight));
+            painter.setPen(palette().color(QPalette::HighlightedText));
+        }
+        else
+        {
+            painter.setPen(palette().color(QPalette::Text));
+        }
+        painter.drawText(x, y + fm.ascent(), store.line(i));
+    }
+}
+
+void LogView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void LogView::mousePressEvent(QMouseEvent *event)
+{
+    selAnchor = selCursor = lineAt(event->y());
+    viewport()->update();
+}
+
+void LogView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (selAnchor < 0)
+        return;
+    selCursor = lineAt(event->y());
+    viewport()->update();
+}
+
+void LogView::keyPressEvent(QKeyEvent *event)
+{
+    QScrollBar *s = verticalScrollBar();
+    if (event->matches(QKeySequence::Copy))
+        copy();
+    else if (event->key() == Qt::Key_Home)
+        s->setValue(0);
+    else if (event->key() == Qt::Key_End)
+        s->setValue(s->maximum());
+    else if (event->key() == Qt::Key_PageUp)
+        s->setValue(s->value() - s->pageStep());
+    else if (event->key() == Qt::Key_PageDown)
+        s->setValue(s->value() + s->pageStep());
+    else if (event->key() == Qt::Key_Up)
+        s->setValue(s->value() - 1);
+    else if (event->key() == Qt::Key_Down)
+        s->setValue(s->value() + 1);
+    else
+        QAbstractScrollArea::keyPressEvent(event);
+}
+
+void LogView::updateScrollBars()
+{
+    const QFontMetrics fm(font());
+    int rows = viewport()->height() / fm.lineSpacing();
+    qint64 lines = store.count();
+
+    verticalScrollBar()->setPageStep(qMax(rows, 1));
+    verticalScrollBar()->setRange(0, int(qMax(lines - rows, qint64(0))));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setRange(0, qMax(maxColumns * fm.averageCharWidth() - viewport()->width(), 0));
+}
+
+int LogView::lineAt(int y) const
+{
+    int line = verticalScrollBar()->value() + qMax(y, 0) / QFontMetrics(font()).lineSpacing();
+    return int(qMin(qint64(line), store.count() - 1));
+}
@@ -0,0 +1,93 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOGVIEW_H
+#define LOGVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QByteArray>
+#include <QVector>
+#include <QStringList>
+
+class QTemporaryFile;
+
+// Append-only line storage: the newest lines are kept as UTF-8 in one
+// arena with an offset index, older lines are moved to a temporary file
+// once more than maxLines are held in memory.
+class LineStore
+{
+public:
+    LineStore(int maxLines = 50000);
+    ~LineStore();
+
+    void setMaxLines(int lines);
+    int maxLines() const { return limit; }
+    qint64 count() const { return spilled + offsets.size(); }
+
+    void append(const QString &line);
+    QString line(qint64 index);
+    void clear();
+
+private:
+    void spill(int lines);
+    QString spilledLine(qint64 index);
+
+    int limit;
+    QByteArray arena;		// '\n' terminated lines, back to back
+    QVector<int> offsets;	// start of each line in arena
+
+    qint64 spilled;		// lines moved to spillFile
+    QTemporaryFile *spillFile;
+    QVector<qint64> spillIndex;	// file position of every SpillStride-th line
+    qint64 readIndex, readPos;	// where the last spill read stopped
+};
+
+// Read-only log view that only lays out the rows currently visible.
+class LogView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    LogView(QWidget *parent = 0);
+
+    void setMaxLines(int lines);
+    int maxLines() const;
+    qint64 lineCount() const;
+
+public slots:
+    void appendLines(const QStringList &lines);
+    void clear();
+    void copy();
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void resizeEvent(QResizeEvent *event);
+    void mousePressEvent(QMouseEvent *event);
+    void mouseMoveEvent(QMouseEvent *event);
+    void keyPressEvent(QKeyEvent *event);
+
+private:
+    void updateScrollBars();
+    int lineAt(int y) const;
+
+    LineStore store;
+    int maxColumns;		// longest line so far, in characters
+    qint64 selAnchor, selCursor;	// selected lines, -1 if none
+};
+
+#endif // LOGVIEW_H
@@ -17,11 +17,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 	
 #include <QtGui/QApplication>
+#include <QTimer>
 #include "mainwidget.h"
+#include "batch.h"
 
 
 int main(int argc, char *argv[])
 {
+    if (BatchRunner::requested(argc, argv))	// headless, no display needed
+    {
+        QCoreApplication application(argc, argv);
+        BatchRunner runner(application.arguments());
+        QTimer::singleShot(0, &runner, SLOT(start()));
+        return application.exec();
+    }
+
     QApplication application(argc, argv);
     MainWidget widget;
     widget.show();
@@ -1,527 +1,963 @@
-/*
-Graphical frontend for the Open On-Chip Debugger
-Copyright (C) 2013 Sven Sperner
-
-This program is free software: you can redistribute it and/or modify
-it under the terms of the GNU General Public License as published by
-the Free Software Foundation, either version 3 of the License, or
-(at your option) any later version.
-
-This program is distributed in the hope that it will be useful,
-but WITHOUT ANY WARRANTY; without even the implied warranty of
-MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-GNU General Public License for more details.
-
-You should have received a copy of the GNU General Public License
-along with this program.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
-#define SAM7_VERSION "0.3.3"
-
-#include "mainwidget.h"
-#include "ui_mainwidget.h"
-#include <QStringList>
-#include <QScrollBar>
-#include <QFileDialog>
-#include <QByteArray>
-#include <QRect>
-
-#include <iostream>
-using namespace std;
-
-
-MainWidget::MainWidget(QWidget *parent) : QWidget(parent), main(new Ui::MainWidget)
-{
-    main->setupUi(this);
-
-    setGeometry(QRect(100,100,800,480));
-    setWindowTitle(QString("SAM7 openOCD GUI v") + SAM7_VERSION);
-
-    openOCD = new QProcess(this);
-    telnet = new QtTelnet(this);
-
-// control buttons
-    connect(main->pushButtonOocdConnect, SIGNAL(clicked()), this, SLOT(connectToServer()));
-    connect(telnet, SIGNAL(message(QString)), this, SLOT(telnetMessage(QString)));
-    connect(telnet->socket(), SIGNAL(connected()), this, SLOT(telnetConnected()));
-    connect(telnet, SIGNAL(connectionError(QAbstractSocket::SocketError)), this, SLOT(telnetConnectionError()));
-
-    connect(main->pushButtonOocdReset, SIGNAL(clicked()), this, SLOT(resetOocd()));
-    connect(main->lineEditInput, SIGNAL(returnPressed()), this, SLOT(telnetData()));
-
-// ram
-    connect(main->pushButtonRamFile, SIGNAL(clicked()), this, SLOT(ramFileSelect()));
-    connect(main->pushButtonRamLoad, SIGNAL(clicked()), this, SLOT(ramLoad()));
-
-// flash
-    connect(main->pushButtonFlashFile, SIGNAL(clicked()), this, SLOT(flashFileSelect()));
-    connect(main->pushButtonFlashLoad, SIGNAL(clicked()), this, SLOT(flashLoad()));
-
-// command buttons
-    connect(main->pushButtonSoftReset, SIGNAL(clicked()), this, SLOT(softReset()));
-    connect(main->pushButtonReset, SIGNAL(clicked()), this, SLOT(reset()));
-    connect(main->pushButtonResume, SIGNAL(clicked()), this, SLOT(resume()));
-    connect(main->pushButtonHalt, SIGNAL(clicked()), this, SLOT(halt()));
-    connect(main->pushButtonPoll, SIGNAL(clicked()), this, SLOT(poll()));
-    connect(main->pushButtonShowMem, SIGNAL(clicked()), this, SLOT(showMemory()));
-    connect(main->pushButtonEraseFlash, SIGNAL(clicked()), this, SLOT(eraseFlash()));
-    connect(main->pushButtonRemap, SIGNAL(clicked()), this, SLOT(remap()));
-    connect(main->pushButtonPeriphReset, SIGNAL(clicked()), this, SLOT(peripheralReset()));
-    connect(main->pushButtonCpuReset, SIGNAL(clicked()), this, SLOT(cpuReset()));
-
-// openocd tab
-    connect(main->pushButtonOcdConfigFile, SIGNAL(clicked()), this, SLOT(ocdConfigFileSelect()));
-    connect(main->pushButtonOcdConfigStart, SIGNAL(clicked()), this, SLOT(ocdConfigStart()));
-
-    connect(openOCD, SIGNAL(readyRead()), this, SLOT(openOcdMessage()));
-    connect(openOCD, SIGNAL(readyReadStandardOutput()), this, SLOT(openOcdStdout()));
-    connect(openOCD, SIGNAL(readyReadStandardError()), this, SLOT(openOcdStderr()));
-
-    connect(main->pushButtonUndo, SIGNAL(clicked()), this, SLOT(editUndo()));
-    connect(main->pushButtonRedo, SIGNAL(clicked()), this, SLOT(editRedo()));
-    connect(main->pushButtonReload, SIGNAL(clicked()), this, SLOT(editReload()));
-    connect(main->pushButtonSave, SIGNAL(clicked()), this, SLOT(editSave()));
-
-// configuration tab
-    connect(main->pushButtonGuiConfigFile, SIGNAL(clicked()), this, SLOT(selectConfigFile()));
-    connect(main->pushButtonGuiConfigLoad, SIGNAL(clicked()), this, SLOT(loadConfiguration()));
-    connect(main->pushButtonGuiConfigSave, SIGNAL(clicked()), this, SLOT(saveConfiguration()));
-
-    QFile dirFile(DIR_FILE_NAME);
-    if (dirFile.open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        QTextStream dirin(&dirFile);
-        recentDir = dirin.readLine(256);
-    }
-    
-    QFile cfgFile(main->lineEditOcdConfig->text());
-    if (cfgFile.open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        QTextStream cfgin(&cfgFile);
-        main->textEditOcdConfig->setText(cfgin.readAll());
-    }
-}
-
-MainWidget::~MainWidget()
-{
-    QFile dirFile(DIR_FILE_NAME);
-    if (dirFile.open(QIODevice::Truncate | QIODevice::WriteOnly | QIODevice::Text))
-    {
-        QTextStream out(&dirFile);
-        out << recentDir;
-    }
-
-    delete main;
-}
-
-
-
-// private Slots:
-
-// control buttons:
-void MainWidget::connectToServer()
-{
-    if (main->pushButtonOocdConnect->text() == "Connect")
-    {
-        telnet->connectToHost(main->lineEditHost->text(), main->lineEditPort->text().toInt());
-    }
-    else
-    {
-        telnet->close();
-        main->textEditOutput->append("GUI: Connection closed");
-        main->pushButtonOocdConnect->setText("Connect");
-    }
-}
-
-void MainWidget::telnetConnected()
-{
-    main->textEditOutput->append("GUI: Connected to " + main->lineEditHost->text() + ":" + main->lineEditPort->text());
-    main->pushButtonOocdConnect->setText("Disconnect");
-}
-
-void MainWidget::telnetConnectionError()
-{
-    main->textEditOutput->append("GUI: Can not connect to " + main->lineEditHost->text() + ":" + main->lineEditPort->text());
-}
-
-void MainWidget::resetOocd()
-{
-    if (main->pushButtonOocdConnect->text() == "Disconnect")
-    {
-        telnet->close();
-        telnet->connectToHost(main->lineEditHost->text(), main->lineEditPort->text().toInt());
-        main->textEditOutput->append("GUI: Reset Connection");
-    }
-    else
-    {
-        main->textEditOutput->append("GUI: Not connected");
-    }
-}
-
-
-void MainWidget::telnetMessage(const QString &msg) // receive output
-{
-    main->textEditOutput->append(stripCR(msg));
-    QScrollBar *s = main->textEditOutput->verticalScrollBar();
-    s->setValue(s->maximum());
-}
-
-void MainWidget::telnetData() // send command
-{
-    telnet->sendData(main->lineEditInput->text());
-    main->lineEditInput->clear();
-}
-
-
-void MainWidget::ramFileSelect()
-{
-    QFileDialog fDlg(this, "Select RAM Image", recentDir, "*.bin *.BIN *.elf *.ELF");
-
-    if(fDlg.exec())
-    {
-        main->lineEditRam->setText(fDlg.selectedFiles().at(0));
-        recentDir = fDlg.directory().absolutePath();
-    }
-}
-
-void MainWidget::ramLoad() // download image to RAM
-{
-    QString buffer = main->lineEditRam->text();
-    int tmp = buffer.size();
-    
-    if ((buffer[tmp-3] == 'e' && buffer[tmp-2] == 'l' && buffer[tmp-1] == 'f') ||
-        (buffer[tmp-3] == 'E' && buffer[tmp-2] == 'L' && buffer[tmp-1] == 'F'))
-    {
-        telnet->sendData("soft_reset_halt");
-        telnet->sendData("load_image " + main->lineEditRam->text() + " 0x0 elf");
-    }
-    else if ((buffer[tmp-3] == 'b' && buffer[tmp-2] == 'i' && buffer[tmp-1] == 'n') ||
-	     (buffer[tmp-3] == 'B' && buffer[tmp-2] == 'I' && buffer[tmp-1] == 'N'))
-    {
-        telnet->sendData("soft_reset_halt");
-        telnet->sendData("load_image " + main->lineEditRam->text() + " 0x200000 bin");
-    }
-}
-
-void MainWidget::flashFileSelect()
-{
-    QFileDialog fDlg(this, "Select FLASH Image", recentDir, "*.bin *.BIN *.elf *.ELF");
-
-    if(fDlg.exec())
-    {
-        main->lineEditFlash->setText(fDlg.selectedFiles().at(0));
-        recentDir = fDlg.directory().absolutePath();
-    }
-}
-
-void MainWidget::flashLoad() // download image to FLASH
-{
-    QString buffer = main->lineEditFlash->text();
-    int tmp = buffer.size();
-    
-    if ((buffer[tmp-3] == 'e' && buffer[tmp-2] == 'l' && buffer[tmp-1] == 'f') ||
-        (buffer[tmp-3] == 'E' && buffer[tmp-2] == 'L' && buffer[tmp-1] == 'F'))
-    {
-        telnet->sendData("soft_reset_halt");
-        if (main->checkBoxErase->isChecked())
-            telnet->sendData(main->lineEditFlashWriteCmd->text() + " erase " + main->lineEditFlash->text() + " 0x0 elf");
-        else
-            telnet->sendData(main->lineEditFlashWriteCmd->text() + " " + main->lineEditFlash->text() + " 0x0 elf");
-    }
-    else if ((buffer[tmp-3] == 'b' && buffer[tmp-2] == 'i' && buffer[tmp-1] == 'n') ||
-	     (buffer[tmp-3] == 'B' && buffer[tmp-2] == 'I' && buffer[tmp-1] == 'N'))
-    {
-        telnet->sendData("soft_reset_halt");
-        if (main->checkBoxErase->isChecked())
-	{
-	    telnet->sendData(main->lineEditFlashWriteCmd->text() + " erase " + main->lineEditFlash->text() + " 0x100000 bin");
-	}
-        else
-	{
-            telnet->sendData(main->lineEditFlashWriteCmd->text() + " " + main->lineEditFlash->text() + " 0x100000 bin");
-	}
-    }
-}
-
-
-
-// command buttons:
-void MainWidget::softReset()
-{
-    telnet->sendData(main->lineEditSoftResetCmd->text());
-}
-
-void MainWidget::reset()
-{
-    telnet->sendData(main->lineEditResetCmd->text());
-}
-
-void MainWidget::halt()
-{
-    telnet->sendData(main->lineEditHaltCmd->text());
-}
-
-void MainWidget::resume()
-{
-    telnet->sendData(main->lineEditResumeCmd->text());
-}
-
-void MainWidget::poll()
-{
-    telnet->sendData(main->lineEditPollCmd->text());
-}
-
-void MainWidget::eraseFlash()
-{
-    telnet->sendData(main->lineEditSoftResetCmd->text());
-    telnet->sendData(main->lineEditFlashEraseCmd->text());
-}
-
-//
-void MainWidget::showMemory()
-{
-    telnet->sendData("mdw " + main->lineEditBaseAddress->text() + " 0x08");	// base (mapped)
-    telnet->sendData("mdw " + main->lineEditFlashAddress->text() + " 0x08");	// flash
-    telnet->sendData("mdw " + main->lineEditRamAddress->text() + " 0x08");	// sram
-}
-
-void MainWidget::remap()
-{
-    telnet->sendData("mww " + main->lineEditRemapAddress->text() + " " + main->lineEditRemapValue->text());
-}
-
-void MainWidget::peripheralReset()
-{
-    telnet->sendData("mww " + main->lineEditPeriphResetAddress->text() + " " + main->lineEditPeriphResetValue->text());
-}
-
-void MainWidget::cpuReset()
-{
-    telnet->sendData("mww " + main->lineEditCpuResetAddress->text() + " " + main->lineEditCpuResetValue->text());
-}
-
-
-
-// openocd tab
-void MainWidget::ocdConfigFileSelect()
-{
-    QFileDialog fDlg(this, "Select OpenOCD Configuration", recentDir, "*.cfg *.conf *.config *.oocd *.open *.openocd");
-
-    if(fDlg.exec())
-    {
-        main->lineEditOcdConfig->setText(fDlg.selectedFiles().at(0));
-        recentDir = fDlg.directory().absolutePath();
-    }
-    editReload();
-}
-
-void MainWidget::ocdConfigStart() // start OpenOCD with Config
-{
-    if (main->pushButtonOcdConfigStart->text() == "Start")
-    {
-        QString path = "/usr/bin/openocd";
-        QStringList arguments;
-        arguments << "-f" << main->lineEditOcdConfig->text();
-        openOCD->start(path, arguments);
-        main->textEditOcdTerminal->append("GUI: OpenOCD started");
-        main->pushButtonOcdConfigStart->setText("Stop");
-    }
-    else
-    {
-        openOCD->terminate();
-        if (!openOCD->waitForFinished(1000))
-            openOCD->kill();
-        main->textEditOcdTerminal->append("GUI: OpenOCD stopped");
-        main->pushButtonOcdConfigStart->setText("Start");
-    }
-}
-
-void MainWidget::openOcdMessage()
-{
-    main->textEditOcdTerminal->append(stripCR(openOCD->readAll()));
-    QScrollBar *s = main->textEditOcdTerminal->verticalScrollBar();
-    s->setValue(s->maximum());
-}
-
-void MainWidget::openOcdStdout()
-{
-    main->textEditOcdTerminal->append(stripCR(openOCD->readAllStandardOutput()));
-    QScrollBar *s = main->textEditOcdTerminal->verticalScrollBar();
-    s->setValue(s->maximum());
-}
-
-void MainWidget::openOcdStderr()
-{
-    main->textEditOcdTerminal->append(stripCR(openOCD->readAllStandardError()));
-    QScrollBar *s = main->textEditOcdTerminal->verticalScrollBar();
-    s->setValue(s->maximum());
-}
-
-void MainWidget::editUndo()
-{
-    main->textEditOcdConfig->undo();
-}
-
-void MainWidget::editRedo()
-{
-    main->textEditOcdConfig->redo();
-}
-
-void MainWidget::editReload()
-{
-    QFile cfgFile(main->lineEditOcdConfig->text());
-    if (cfgFile.open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        QTextStream cfgin(&cfgFile);
-        main->textEditOcdConfig->setText(cfgin.readAll());
-        main->textEditOcdTerminal->append("GUI: OpenOCD-Config loaded");
-    }
-}
-
-void MainWidget::editSave()
-{
-    QFile cfgFile(main->lineEditOcdConfig->text());
-    if (cfgFile.open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        QTextStream cfgout(&cfgFile);
-        cfgout << main->textEditOcdConfig->toPlainText();
-        main->textEditOcdTerminal->append("GUI: OpenOCD-Config saved");
-    }
-}
-
-
-
-// configuration tab
-void MainWidget::selectConfigFile()
-{
-    QFileDialog fDlg(this, "Select GUI Configuration", recentDir, "*.cfg *.conf *.config");
-
-    if(fDlg.exec())
-    {
-        main->lineEditGuiConfig->setText(fDlg.selectedFiles().at(0));
-        recentDir = fDlg.directory().absolutePath();
-    }
-}
-
-void MainWidget::loadConfiguration()
-{
-    QString buffer;
-    QStringList buflist;
-    QFile cfgFile(main->lineEditGuiConfig->text());
-    if (cfgFile.open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        QTextStream cfgIn(&cfgFile);
-        while (!cfgIn.atEnd())
-        {
-            buffer = cfgIn.readLine();
-            if (buffer[0] == '#')	continue;	//skip comments
-            buflist = buffer.split(' ');
-            if (buflist[0] == "BASE") {
-                main->lineEditBaseAddress->setText(buflist[2]);
-            }
-            else if (buflist[0] == "FLASH") {
-                main->lineEditFlashAddress->setText(buflist[2]);
-            }
-            else if (buflist[0] == "RAM") {
-                main->lineEditRamAddress->setText(buflist[2]);
-            }
-            else if (buflist[0] == "REMAP") {
-                main->lineEditRemapAddress->setText(buflist[2]);
-                main->lineEditRemapValue->setText(buflist[3]);
-            }
-            else if (buflist[0] == "RESETCPU") {
-                main->lineEditCpuResetAddress->setText(buflist[2]);
-                main->lineEditCpuResetValue->setText(buflist[3]);
-            }
-            else if (buflist[0] == "RESETPERIPH") {
-                main->lineEditPeriphResetAddress->setText(buflist[2]);
-                main->lineEditPeriphResetValue->setText(buflist[3]);
-            }
-            else if (buflist[0] == "FLASHPROBE") {
-                main->lineEditFlashProbeCmd->setText(buflist[2]+" "+buflist[3]+" "+buflist[4]);
-            }
-            else if (buflist[0] == "FLASHINFO") {
-                main->lineEditFlashInfoCmd->setText(buflist[2]+" "+buflist[3]+" "+buflist[4]);
-            }
-            else if (buflist[0] == "FLASHERASE") {
-                main->lineEditFlashEraseCmd->setText(buflist[2]+" "+buflist[3]+" "+buflist[4]+" "+buflist[5]);
-            }
-            else if (buflist[0] == "FLASHUNLOCK") {
-                main->lineEditFlashUnlockCmd->setText(buflist[2]+" "+buflist[3]+" "+buflist[4]+" "+buflist[5]+" "+buflist[6]);
-            }
-            else if (buflist[0] == "FLASHWRITE") {
-                main->lineEditFlashWriteCmd->setText(buflist[2]+" "+buflist[3]);
-            }
-            else if (buflist[0] == "ERASESUFFIX") {
-                main->lineEditEraseSuffix->setText(buflist[2]);
-            }
-            else if (buflist[0] == "RAMWRITE") {
-                main->lineEditRamWriteCmd->setText(buflist[2]);
-            }
-            else if (buflist[0] == "RESET") {
-                main->lineEditResetCmd->setText(buflist[2]);
-            }
-            else if (buflist[0] == "HALT") {
-                main->lineEditHaltCmd->setText(buflist[2]);
-            }
-            else if (buflist[0] == "RESUME") {
-                main->lineEditResumeCmd->setText(buflist[2]);
-            }
-            else if (buflist[0] == "POLL") {
-                main->lineEditPollCmd->setText(buflist[2]);
-            }
-            else if (buflist[0] == "SOFTRESET") {
-                main->lineEditSoftResetCmd->setText(buflist[2]);
-            }
-        }
-        main->textEditOcdTerminal->append("GUI: GUI-Config loaded");
-    }
-}
-
-void MainWidget::saveConfiguration()
-{
-    QFile cfgFile(main->lineEditGuiConfig->text());
-    if (cfgFile.open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        QTextStream cfgOut(&cfgFile);
-        cfgOut << "BASE = " << main->lineEditBaseAddress->text() << " " << endl;
-        cfgOut << "FLASH = " << main->lineEditFlashAddress->text() << " " << endl;
-        cfgOut << "RAM = " << main->lineEditRamAddress->text() << " " << endl;
-        cfgOut << "REMAP = " << main->lineEditRemapAddress->text() << " "
-                     << main->lineEditRemapValue->text() << endl;
-        cfgOut << "RESETCPU = " << main->lineEditCpuResetAddress->text() << " "
-                    << main->lineEditCpuResetValue->text() << endl;
-        cfgOut << "RESETPERIPH = " << main->lineEditPeriphResetAddress->text() << " "
-                       << main->lineEditPeriphResetValue->text() << endl;
-        cfgOut << "FLASHPROBE = " << main->lineEditFlashProbeCmd->text() << " " << endl;
-        cfgOut << "FLASHINFO = " << main->lineEditFlashInfoCmd->text() << " " << endl;
-        cfgOut << "FLASHERASE = " << main->lineEditFlashEraseCmd->text() << " " << endl;
-        cfgOut << "FLASHUNLOCK = " << main->lineEditFlashUnlockCmd->text() << " " << endl;
-        cfgOut << "FLASHWRITE = " << main->lineEditFlashWriteCmd->text() << " " << endl;
-        cfgOut << "ERASESUFFIX = " << main->lineEditEraseSuffix->text() << " " << endl;
-        cfgOut << "RAMWRITE = " << main->lineEditRamWriteCmd->text() << " " << endl;
-        cfgOut << "RESET = " << main->lineEditResetCmd->text() << " " << endl;
-        cfgOut << "HALT = " << main->lineEditHaltCmd->text() << " " << endl;
-        cfgOut << "RESUME = " << main->lineEditResumeCmd->text() << " " << endl;
-        cfgOut << "POLL = " << main->lineEditPollCmd->text() << " " << endl;
-        cfgOut << "SOFTRESET = " << main->lineEditSoftResetCmd->text() << " " << endl;
-        main->textEditOcdTerminal->append("GUI: GUI-Config saved as " + cfgFile.fileName());
-    }
-}
-
-
-
-// private Funktions:
-QString MainWidget::stripCR(const QString &msg)
-{
-    QString nmsg(msg);
-    nmsg.remove('\r');
-    //nmsg.remove('\n\r\n\r');
-    nmsg.remove(QRegExp("\033\\[[0-9;]*[A-Za-z]")); // Also remove terminal control codes
-    return nmsg.isEmpty() ? NULL : nmsg;
-}
-
-void MainWidget::removeEmptyLines()
-{
-
-}
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define SAM7_VERSION "0.3.3"
+
+#include "mainwidget.h"
+#include "ui_mainwidget.h"
+#include "outputrenderer.h"
+#include "ocdtransport.h"
+#include "gdbremote.h"
+#include "targetflow.h"
+#include "dump.h"
+#include "loadstats.h"
+#include "ocdsupervisor.h"
+#include "ocdlog.h"
+#include "profile.h"
+#include <QStringList>
+#include <QFileDialog>
+#include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QByteArray>
+#include <QRect>
+
+#include <iostream>
+using namespace std;
+
+
+MainWidget::MainWidget(QWidget *parent) : QWidget(parent), main(new Ui::MainWidget), loadPercent(0)
+{
+    main->setupUi(this);
+    showProfile(Profile());	// the defaults, shared with the batch mode
+
+    setGeometry(QRect(100,100,800,480));
+    setWindowTitle(QString("SAM7 openOCD GUI v") + SAM7_VERSION);
+
+    supervisor = new OcdSupervisor(this);
+    ocdLog = new OcdLog(this);
+    telnetTransport = new TelnetTransport("> ", this);	// prompt delimits the response of each command
+    tclTransport = new TclRpcTransport(this);
+    transport = telnetTransport;
+    gdb = new GdbRemote(this);
+    flow = new TargetFlow(gdb, this);
+    flow->setTransport(transport);
+    dump = new MemoryDump(gdb, this);
+    history = new LoadHistory(QDir::homePath() + HISTORY_FILE_NAME);
+    history->load();
+    telnetOutput = new OutputRenderer(main->textEditOutput, 20, this);
+    ocdOutput = new OutputRenderer(main->textEditOcdTerminal, 20, this);
+
+// control buttons
+    connect(main->pushButtonOocdConnect, SIGNAL(clicked()), this, SLOT(connectToServer()));
+    connect(main->comboBoxTransport, SIGNAL(currentIndexChanged(int)), this, SLOT(selectTransport(int)));
+    connect(telnetTransport, SIGNAL(output(QByteArray)), this, SLOT(telnetMessage(QByteArray)));
+    connect(tclTransport, SIGNAL(output(QByteArray)), this, SLOT(telnetMessage(QByteArray)));
+    connect(telnetTransport, SIGNAL(connected()), this, SLOT(telnetConnected()));
+    connect(tclTransport, SIGNAL(connected()), this, SLOT(telnetConnected()));
+    connect(telnetTransport, SIGNAL(error(QString)), this, SLOT(telnetConnectionError()));
+    connect(tclTransport, SIGNAL(error(QString)), this, SLOT(telnetConnectionError()));
+    connect(gdb, SIGNAL(connected()), this, SLOT(gdbConnected()));
+    connect(gdb, SIGNAL(error(QString)), this, SLOT(gdbError(QString)));
+    connect(gdb, SIGNAL(output(QString)), this, SLOT(gdbOutput(QString)));
+    connect(gdb, SIGNAL(memoryWritten(quint32,qint64)), this, SLOT(gdbWritten(quint32,qint64)));
+    connect(gdb, SIGNAL(cancelled(quint32,qint64)), this, SLOT(gdbWritten(quint32,qint64)));	// partly written
+    connect(flow, SIGNAL(message(QString)), this, SLOT(flowMessage(QString)));
+    connect(flow, SIGNAL(commandFinished(OcdReply*)), this, SLOT(flowCommand(OcdReply*)));
+    connect(flow, SIGNAL(progress(qint64,qint64)), this, SLOT(flowProgress(qint64,qint64)));
+    connect(flow, SIGNAL(loaded(LoadRecord)), this, SLOT(flowLoaded(LoadRecord)));
+    connect(telnetTransport, SIGNAL(receiveBufferHigh(int,int)), this, SLOT(telnetBufferHigh(int,int)));
+    connect(telnetTransport, SIGNAL(receiveBufferLow(int)), this, SLOT(telnetBufferLow(int)));
+
+    connect(main->pushButtonOocdReset, SIGNAL(clicked()), this, SLOT(resetOocd()));
+    connect(main->pushButtonOocdAbort, SIGNAL(clicked()), this, SLOT(abortCommands()));
+    connect(main->lineEditInput, SIGNAL(returnPressed()), this, SLOT(telnetData()));
+
+// ram
+    connect(main->pushButtonRamFile, SIGNAL(clicked()), this, SLOT(ramFileSelect()));
+    connect(main->pushButtonRamLoad, SIGNAL(clicked()), this, SLOT(ramLoad()));
+
+// flash
+    connect(main->pushButtonFlashFile, SIGNAL(clicked()), this, SLOT(flashFileSelect()));
+    connect(main->pushButtonFlashLoad, SIGNAL(clicked()), this, SLOT(flashLoad()));
+    connect(main->stationView, SIGNAL(flashRequested()), this, SLOT(stationFlash()));
+
+// command buttons
+    connect(main->pushButtonSoftReset, SIGNAL(clicked()), this, SLOT(softReset()));
+    connect(main->pushButtonReset, SIGNAL(clicked()), this, SLOT(reset()));
+    connect(main->pushButtonResume, SIGNAL(clicked()), this, SLOT(resume()));
+    connect(main->pushButtonHalt, SIGNAL(clicked()), this, SLOT(halt()));
+    connect(main->pushButtonPoll, SIGNAL(clicked()), this, SLOT(poll()));
+    connect(main->pushButtonShowMem, SIGNAL(clicked()), this, SLOT(showMemory()));
+    connect(main->pushButtonEraseFlash, SIGNAL(clicked()), this, SLOT(eraseFlash()));
+    connect(main->pushButtonRemap, SIGNAL(clicked()), this, SLOT(remap()));
+    connect(main->pushButtonPeriphReset, SIGNAL(clicked()), this, SLOT(peripheralReset()));
+    connect(main->pushButtonCpuReset, SIGNAL(clicked()), this, SLOT(cpuReset()));
+
+// memory tab
+    main->memoryView->setTransport(transport);
+    connect(main->comboBoxMemRegion, SIGNAL(activated(int)), this, SLOT(memoryRegion(int)));
+    connect(main->comboBoxMemWidth, SIGNAL(currentIndexChanged(int)), this, SLOT(memoryShow()));
+    connect(main->pushButtonMemShow, SIGNAL(clicked()), this, SLOT(memoryShow()));
+    connect(main->lineEditMemStart, SIGNAL(returnPressed()), this, SLOT(memoryShow()));
+    connect(main->lineEditMemLength, SIGNAL(returnPressed()), this, SLOT(memoryShow()));
+    connect(main->pushButtonMemRefresh, SIGNAL(clicked()), this, SLOT(memoryRefresh()));
+    connect(main->memoryView, SIGNAL(blockRead(quint32, int)), this, SLOT(memoryRead()));
+    connect(main->pushButtonMemDump, SIGNAL(clicked()), this, SLOT(memoryDump()));
+    connect(main->pushButtonMemDumpCancel, SIGNAL(clicked()), dump, SLOT(cancel()));
+    connect(dump, SIGNAL(progress(qint64, qint64, double)), this, SLOT(memoryDumpProgress(qint64, qint64, double)));
+    connect(dump, SIGNAL(finished(bool, QString)), this, SLOT(memoryDumpFinished(bool, QString)));
+
+// watch tab
+    main->watchView->setTransport(transport);
+    setWatches();
+
+// snapshots tab
+    main->snapshotView->setTransport(transport);
+    main->snapshotView->setDirectory(QDir::homePath() + SNAPSHOT_DIR_NAME);
+    main->snapshotView->setRange(main->lineEditRamAddress->text(), main->lineEditRamSize->text());
+    connect(main->snapshotView, SIGNAL(jumpRequested(quint32)), this, SLOT(snapshotJump(quint32)));
+
+// openocd tab
+    connect(main->pushButtonOcdConfigFile, SIGNAL(clicked()), this, SLOT(ocdConfigFileSelect()));
+    connect(main->pushButtonOcdConfigStart, SIGNAL(clicked()), this, SLOT(ocdConfigStart()));
+    connect(main->pushButtonOcdRestart, SIGNAL(clicked()), this, SLOT(ocdRestart()));
+    connect(main->checkBoxOcdRespawn, SIGNAL(toggled(bool)), this, SLOT(ocdOptions()));
+    connect(main->checkBoxOcdSpare, SIGNAL(toggled(bool)), this, SLOT(ocdOptions()));
+
+    connect(supervisor, SIGNAL(output(QByteArray)), ocdLog, SLOT(feed(QByteArray)));
+    connect(ocdLog, SIGNAL(lines(QStringList)), this, SLOT(openOcdLines(QStringList)));
+    connect(ocdLog, SIGNAL(tagged(int, QString)), main->ocdErrorList, SLOT(addLine(int, QString)));
+    connect(supervisor, SIGNAL(ready(quint16, quint16, quint16)), this, SLOT(openOcdReady(quint16, quint16, quint16)));
+    connect(supervisor, SIGNAL(stopped()), this, SLOT(openOcdStopped()));
+    connect(supervisor, SIGNAL(crashed(int)), this, SLOT(openOcdCrashed(int)));
+    connect(supervisor, SIGNAL(error(QString)), this, SLOT(openOcdError(QString)));
+
+    connect(main->pushButtonUndo, SIGNAL(clicked()), this, SLOT(editUndo()));
+    connect(main->pushButtonRedo, SIGNAL(clicked()), this, SLOT(editRedo()));
+    connect(main->pushButtonReload, SIGNAL(clicked()), this, SLOT(editReload()));
+    connect(main->pushButtonSave, SIGNAL(clicked()), this, SLOT(editSave()));
+
+// configuration tab
+    connect(main->pushButtonGuiConfigFile, SIGNAL(clicked()), this, SLOT(selectConfigFile()));
+    connect(main->pushButtonGuiConfigLoad, SIGNAL(clicked()), this, SLOT(loadConfiguration()));
+    connect(main->pushButtonGuiConfigSave, SIGNAL(clicked()), this, SLOT(saveConfiguration()));
+    connect(main->lineEditLogLines, SIGNAL(editingFinished()), this, SLOT(setLogLines()));
+
+    QFile dirFile(DIR_FILE_NAME);
+    if (dirFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        QTextStream dirin(&dirFile);
+        recentDir = dirin.readLine(256);
+    }
+    
+    QFile cfgFile(main->lineEditOcdConfig->text());
+    if (cfgFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        QTextStream cfgin(&cfgFile);
+        main->textEditOcdConfig->setText(cfgin.readAll());
+    }
+    setLogLines();
+    showHistory();
+}
+
+MainWidget::~MainWidget()
+{
+    QFile dirFile(DIR_FILE_NAME);
+    if (dirFile.open(QIODevice::Truncate | QIODevice::WriteOnly | QIODevice::Text))
+    {
+        QTextStream out(&dirFile);
+        out << recentDir;
+    }
+
+    delete history;
+    delete main;
+}
+
+
+
+// private Slots:
+
+// control buttons:
+void MainWidget::connectToServer()
+{
+    if (main->pushButtonOocdConnect->text() == "Connect")
+    {
+        transport->connectToHost(main->lineEditHost->text(), main->lineEditPort->text().toInt());
+    }
+    else
+    {
+        transport->close();
+        gdb->close();
+        telnetOutput->append("GUI: Connection closed");
+        main->pushButtonOocdConnect->setText("Connect");
+    }
+}
+
+void MainWidget::selectTransport(int index) // telnet or Tcl RPC, with their default ports
+{
+    if (transport->isConnected())
+    {
+        transport->close();
+        telnetOutput->append("GUI: Connection closed");
+        main->pushButtonOocdConnect->setText("Connect");
+    }
+
+    if (index == 1)
+    {
+        transport = tclTransport;
+        if (main->lineEditPort->text() == "4444")
+            main->lineEditPort->setText("6666");
+    }
+    else
+    {
+        transport = telnetTransport;
+        if (main->lineEditPort->text() == "6666")
+            main->lineEditPort->setText("4444");
+    }
+    flow->setTransport(transport);
+    main->memoryView->setTransport(transport);
+    main->watchView->setTransport(transport);
+    main->snapshotView->setTransport(transport);
+}
+
+void MainWidget::telnetConnected()
+{
+    telnetOutput->append("GUI: Connected to " + main->lineEditHost->text() + ":" + main->lineEditPort->text());
+    main->pushButtonOocdConnect->setText("Disconnect");
+}
+
+void MainWidget::telnetConnectionError()
+{
+    telnetOutput->append("GUI: Can not connect to " + main->lineEditHost->text() + ":" + main->lineEditPort->text());
+}
+
+void MainWidget::resetOocd()
+{
+    if (main->pushButtonOocdConnect->text() == "Disconnect")
+    {
+        transport->close();
+        transport->connectToHost(main->lineEditHost->text(), main->lineEditPort->text().toInt());
+        telnetOutput->append("GUI: Reset Connection");
+    }
+    else
+    {
+        telnetOutput->append("GUI: Not connected");
+    }
+}
+
+
+void MainWidget::abortCommands() // stop a runaway command and everything queued behind it
+{
+    int queued = flow->queued();
+    flow->abort();
+    telnetOutput->append(QString("GUI: Abort, %1 queued command(s) dropped").arg(queued));
+}
+
+void MainWidget::telnetMessage(const QByteArray &msg) // receive output
+{
+    showOutput(telnetOutput, telnetFilter, msg);
+}
+
+void MainWidget::telnetBufferHigh(int size, int capacity) // output arrives faster than we parse it
+{
+    telnetOutput->append(QString("GUI: Receive buffer at %1 of %2 bytes, throttling openOCD")
+                         .arg(size).arg(capacity));
+}
+
+void MainWidget::telnetBufferLow(int size)
+{
+    telnetOutput->append(QString("GUI: Receive buffer down to %1 bytes")
+                         .arg(size));
+}
+
+void MainWidget::telnetData() // send command
+{
+    if (transport == telnetTransport)
+    {
+        telnetTransport->sendData(main->lineEditInput->text());
+        memoryTouched(main->lineEditInput->text());
+    }
+    else
+        flow->run(QStringList(main->lineEditInput->text()));
+    main->lineEditInput->clear();
+}
+
+void MainWidget::flowMessage(const QString &text)
+{
+    telnetOutput->append("GUI: " + text);
+}
+
+void MainWidget::flowCommand(OcdReply *reply) // a command of the flows finished
+{
+    if (reply->isAborted())
+        telnetOutput->append("GUI: '" + reply->command() + "' aborted");
+    else
+        telnetOutput->append(QString("GUI: '%1' took %2 ms").arg(reply->command())
+                             .arg(reply->latency() / 1000.0, 0, 'f', 1));
+    memoryTouched(reply->command());
+}
+
+void MainWidget::flowProgress(qint64 done, qint64 total)
+{
+    int percent = total ? int(done * 100 / total) : 100;
+    if (percent / 25 > loadPercent / 25)
+        telnetOutput->append(QString("GUI: %1% (%2 of %3 bytes)").arg(percent).arg(done).arg(total));
+    loadPercent = percent;
+}
+
+void MainWidget::flowLoaded(const LoadRecord &record) // phase timing of the load, compared with the previous runs
+{
+    LoadRecord loadRun = record;
+    loadRun.target = historyTarget(record.target);
+    QList<LoadRecord> previous = history->recent(loadRun.target, 10);
+    history->add(loadRun);
+    if (!history->save())
+        telnetOutput->append("GUI: Can not write the load history");
+
+    telnetOutput->append(QString("GUI: halt %1 ms, erase %2 ms, write %3 ms, verify %4 ms - %5 bytes at %6 KiB/s%7%8")
+                         .arg(loadRun.haltMs).arg(loadRun.eraseMs).arg(loadRun.writeMs).arg(loadRun.verifyMs)
+                         .arg(loadRun.bytes).arg(loadRun.rate(), 0, 'f', 1)
+                         .arg(loadRun.erasedSectors ? QString(", %1 sector(s) erased").arg(loadRun.erasedSectors) : QString())
+                         .arg(loadRun.ok ? QString() : QString(", failed")));
+
+    double average = 0;
+    int runs = 0;
+    for (int i = 0; i < previous.size(); i++)
+    {
+        if (previous.at(i).ok && previous.at(i).rate() > 0)
+        {
+            average += previous.at(i).rate();
+            runs++;
+        }
+    }
+    if (runs && loadRun.ok && loadRun.rate() < 0.8 * average / runs)
+        telnetOutput->append(QString("GUI: Throughput %1% below the average of the last %2 run(s)")
+                             .arg(int(100 - 100 * loadRun.rate() * runs / average)).arg(runs));
+    showHistory();
+}
+
+void MainWidget::gdbConnected()
+{
+    telnetOutput->append(QString("GUI: GDB connected to port %1, packet size %2 bytes")
+                         .arg(main->lineEditGdbPort->text()).arg(gdb->packetSize()));
+}
+
+void MainWidget::gdbError(const QString &message)
+{
+    telnetOutput->append("GUI: " + message);
+}
+
+void MainWidget::gdbOutput(const QString &text) // of monitor commands
+{
+    showOutput(telnetOutput, telnetFilter, text.toLocal8Bit());
+}
+
+void MainWidget::gdbWritten(quint32 address, qint64 length)
+{
+    main->memoryView->invalidate(address, quint32(length));
+}
+
+
+void MainWidget::ramFileSelect()
+{
+    QFileDialog fDlg(this, "Select RAM Image", recentDir, "*.bin *.BIN *.elf *.ELF");
+
+    if(fDlg.exec())
+    {
+        main->lineEditRam->setText(fDlg.selectedFiles().at(0));
+        recentDir = fDlg.directory().absolutePath();
+    }
+}
+
+void MainWidget::ramLoad() // download image to RAM
+{
+    flow->setProfile(currentProfile());
+    flow->setGdbPort(main->lineEditHost->text(), main->lineEditGdbPort->text().toUShort());	// binary download if set
+    loadPercent = 0;
+    if (!flow->load(TargetFlow::Ram, main->lineEditRam->text()))
+        telnetOutput->append("GUI: " + flow->errorString());
+}
+
+void MainWidget::flashFileSelect()
+{
+    QFileDialog fDlg(this, "Select FLASH Image", recentDir, "*.bin *.BIN *.elf *.ELF");
+
+    if(fDlg.exec())
+    {
+        main->lineEditFlash->setText(fDlg.selectedFiles().at(0));
+        recentDir = fDlg.directory().absolutePath();
+    }
+}
+
+void MainWidget::flashLoad() // download image to FLASH
+{
+    flow->setProfile(currentProfile());
+    flow->setErase(main->checkBoxErase->isChecked());
+    flow->setDelta(main->checkBoxDelta->isChecked());
+    loadPercent = 0;
+    if (!flow->load(TargetFlow::Flash, main->lineEditFlash->text()))
+        telnetOutput->append("GUI: " + flow->errorString());
+}
+
+void MainWidget::stationFlash() // the FLASH image on every board of the station
+{
+    QStringList commands;
+    QList<qint64> sizes;
+    QStringList files;
+    flow->setProfile(currentProfile());
+    flow->setErase(main->checkBoxErase->isChecked());
+    if (flow->loadCommands(main->lineEditFlash->text(), &commands, &sizes, &files))
+        main->stationView->flash(commands, sizes, files);	// owns the slices from now on
+    else
+        telnetOutput->append("GUI: " + flow->errorString());
+}
+
+
+
+// command buttons:
+void MainWidget::softReset()
+{
+    runStep("softreset");
+}
+
+void MainWidget::reset()
+{
+    runStep("reset");
+}
+
+void MainWidget::halt()
+{
+    runStep("halt");
+}
+
+void MainWidget::resume()
+{
+    runStep("resume");
+}
+
+void MainWidget::poll()
+{
+    runStep("poll");
+}
+
+void MainWidget::eraseFlash()
+{
+    runStep("erase");
+}
+
+//
+void MainWidget::showMemory() // sram in the memory tab
+{
+    main->comboBoxMemRegion->setCurrentIndex(0);
+    memoryRegion(0);
+    main->tabWidget->setCurrentWidget(main->tabMemory);
+}
+
+void MainWidget::remap()
+{
+    runStep("remap");
+}
+
+void MainWidget::peripheralReset()
+{
+    runStep("resetperiph");
+}
+
+void MainWidget::cpuReset()
+{
+    runStep("resetcpu");
+}
+
+
+
+// memory tab
+void MainWidget::memoryRegion(int index) // ram, flash or base from the config
+{
+    if (index == 1)
+    {
+        main->lineEditMemStart->setText(main->lineEditFlashAddress->text());
+        main->lineEditMemLength->setText(main->lineEditFlashSize->text());
+    }
+    else if (index == 2)
+    {
+        main->lineEditMemStart->setText(main->lineEditBaseAddress->text());
+        main->lineEditMemLength->setText(main->lineEditRamSize->text());	// mapped sram after remap
+    }
+    else
+    {
+        main->lineEditMemStart->setText(main->lineEditRamAddress->text());
+        main->lineEditMemLength->setText(main->lineEditRamSize->text());
+    }
+    memoryShow();
+}
+
+void MainWidget::memoryShow()
+{
+    bool startOk, lengthOk;
+    quint32 start = main->lineEditMemStart->text().toUInt(&startOk, 0);
+    quint32 length = main->lineEditMemLength->text().toUInt(&lengthOk, 0);
+    if (!startOk || !lengthOk || length == 0)
+    {
+        telnetOutput->append("GUI: Invalid memory range " + main->lineEditMemStart->text()
+                             + " " + main->lineEditMemLength->text());
+        return;
+    }
+    main->memoryView->setWordMode(main->comboBoxMemWidth->currentIndex() == 0);
+    if (start != main->memoryView->rangeStart() || length != main->memoryView->rangeLength())
+        main->memoryView->setRange(start, length);
+}
+
+void MainWidget::memoryRefresh()
+{
+    main->memoryView->invalidate();
+}
+
+void MainWidget::memoryRead()
+{
+    main->labelMemReads->setText(QString("%1 block read(s)").arg(main->memoryView->reads()));
+}
+
+void MainWidget::memoryDump() // the range of the memory tab to a file, over the fastest link there is
+{
+    bool startOk, lengthOk;
+    quint32 start = main->lineEditMemStart->text().toUInt(&startOk, 0);
+    quint32 length = main->lineEditMemLength->text().toUInt(&lengthOk, 0);
+    if (!startOk || !lengthOk || length == 0)
+    {
+        telnetOutput->append("GUI: Invalid memory range " + main->lineEditMemStart->text()
+                             + " " + main->lineEditMemLength->text());
+        return;
+    }
+    if (dump->isRunning())
+    {
+        telnetOutput->append("GUI: Dump already running");
+        return;
+    }
+
+    QFileDialog fDlg(this, "Save Memory Dump", recentDir, "*.bin *.BIN");
+    fDlg.setAcceptMode(QFileDialog::AcceptSave);
+    if (!fDlg.exec())
+        return;
+    QString fileName = fDlg.selectedFiles().at(0);
+    recentDir = fDlg.directory().absolutePath();
+
+    MemoryDump::Method method = MemoryDump::Text;
+    QString host = main->lineEditHost->text();
+    if (gdb->isConnected())
+        method = MemoryDump::Gdb;
+    else if (host == "localhost" || host == "127.0.0.1")
+        method = MemoryDump::DumpImage;	// openOCD can write the file where we read it
+    static const char *const methods[] = { "GDB", "dump_image", "mdw" };
+
+    quint32 partStart, partLength, partDone;
+    if (MemoryDump::partial(fileName, &partStart, &partLength, &partDone) && partStart == start && partLength == length)
+        telnetOutput->append(QString("GUI: Resuming the dump to %1 at %2 of %3 bytes").arg(fileName).arg(partDone).arg(length));
+    dump->setTransport(transport);
+    if (!dump->start(fileName, start, length, method))
+    {
+        telnetOutput->append("GUI: " + dump->errorString());
+        return;
+    }
+    telnetOutput->append(QString("GUI: Dumping %1 bytes at 0x%2 via %3").arg(length).arg(start, 8, 16, QChar('0')).arg(methods[method]));
+    main->pushButtonMemDumpCancel->setEnabled(true);
+}
+
+void MainWidget::memoryDumpProgress(qint64 done, qint64 total, double rate)
+{
+    main->labelMemDump->setText(QString("%1% (%2 of %3 bytes), %4 KiB/s")
+                                .arg(done * 100 / qMax<qint64>(total, 1)).arg(done).arg(total).arg(rate, 0, 'f', 1));
+}
+
+void MainWidget::memoryDumpFinished(bool ok, const QString &message)
+{
+    Q_UNUSED(ok);
+    main->pushButtonMemDumpCancel->setEnabled(false);
+    main->labelMemDump->setText(message);
+    telnetOutput->append("GUI: " + message);
+}
+
+void MainWidget::snapshotJump(quint32 address) // a changed run of a snapshot diff, as it is now
+{
+    main->memoryView->setWordMode(main->comboBoxMemWidth->currentIndex() == 0);
+    main->memoryView->jumpTo(address);
+    main->lineEditMemStart->setText(QString("0x%1").arg(main->memoryView->rangeStart(), 8, 16, QChar('0')));
+    main->lineEditMemLength->setText(QString("0x%1").arg(main->memoryView->rangeLength(), 8, 16, QChar('0')));
+    main->tabWidget->setCurrentWidget(main->tabMemory);
+}
+
+
+
+// openocd tab
+void MainWidget::ocdConfigFileSelect()
+{
+    QFileDialog fDlg(this, "Select OpenOCD Configuration", recentDir, "*.cfg *.conf *.config *.oocd *.open *.openocd");
+
+    if(fDlg.exec())
+    {
+        main->lineEditOcdConfig->setText(fDlg.selectedFiles().at(0));
+        recentDir = fDlg.directory().absolutePath();
+    }
+    editReload();
+}
+
+void MainWidget::ocdConfigStart() // start OpenOCD with Config
+{
+    if (main->pushButtonOcdConfigStart->text() == "Start")
+    {
+        ocdOptions();
+        ocdLog->reset();
+        supervisor->start(main->lineEditOcdConfig->text());
+        ocdOutput->append("GUI: OpenOCD started");
+        main->pushButtonOcdConfigStart->setText("Stop");
+    }
+    else
+    {
+        supervisor->stop();	// returns at once, openOCD is killed if it hangs
+        ocdOutput->append("GUI: OpenOCD stopping");
+        main->pushButtonOcdConfigStart->setText("Start");
+    }
+}
+
+void MainWidget::ocdRestart()
+{
+    ocdOptions();
+    supervisor->restart(main->lineEditOcdConfig->text());
+    ocdOutput->append("GUI: OpenOCD restarting");
+    main->pushButtonOcdConfigStart->setText("Stop");
+}
+
+void MainWidget::ocdOptions()
+{
+    supervisor->setRespawn(main->checkBoxOcdRespawn->isChecked());
+    supervisor->setWarmSpare(main->checkBoxOcdSpare->isChecked());
+}
+
+void MainWidget::openOcdLines(const QStringList &lines) // complete lines of the server output
+{
+    ocdOutput->append(lines.join("\n"));
+}
+
+void MainWidget::openOcdReady(quint16 telnetPort, quint16 tclPort, quint16 gdbPort) // connect as soon as openOCD listens
+{
+    quint16 port = (transport == tclTransport) ? tclPort : telnetPort;
+    ocdOutput->append(QString("GUI: OpenOCD ready on port %1").arg(port));
+    main->lineEditHost->setText("localhost");
+    main->lineEditPort->setText(QString::number(port));
+    if (!main->lineEditGdbPort->text().isEmpty())
+        main->lineEditGdbPort->setText(QString::number(gdbPort));
+    transport->close();
+    gdb->close();
+    transport->connectToHost("localhost", port);
+}
+
+void MainWidget::openOcdStopped()
+{
+    ocdLog->flush();
+    ocdOutput->append("GUI: OpenOCD stopped");
+    main->pushButtonOcdConfigStart->setText("Start");
+}
+
+void MainWidget::openOcdCrashed(int exitCode)
+{
+    ocdLog->flush();
+    ocdOutput->append(QString("GUI: OpenOCD exited with code %1%2").arg(exitCode)
+                      .arg(main->checkBoxOcdRespawn->isChecked() ? ", respawning" : ""));
+    if (!main->checkBoxOcdRespawn->isChecked())
+        main->pushButtonOcdConfigStart->setText("Start");
+}
+
+void MainWidget::openOcdError(const QString &message)
+{
+    ocdOutput->append("GUI: " + message);
+}
+
+void MainWidget::editUndo()
+{
+    main->textEditOcdConfig->undo();
+}
+
+void MainWidget::editRedo()
+{
+    main->textEditOcdConfig->redo();
+}
+
+void MainWidget::editReload()
+{
+    QFile cfgFile(main->lineEditOcdConfig->text());
+    if (cfgFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        QTextStream cfgin(&cfgFile);
+        main->textEditOcdConfig->setText(cfgin.readAll());
+        ocdOutput->append("GUI: OpenOCD-Config loaded");
+    }
+}
+
+void MainWidget::editSave()
+{
+    QFile cfgFile(main->lineEditOcdConfig->text());
+    if (cfgFile.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        QTextStream cfgout(&cfgFile);
+        cfgout << main->textEditOcdConfig->toPlainText();
+        ocdOutput->append("GUI: OpenOCD-Config saved");
+    }
+}
+
+
+
+// configuration tab
+void MainWidget::selectConfigFile()
+{
+    QFileDialog fDlg(this, "Select GUI Configuration", recentDir, "*.cfg *.conf *.config");
+
+    if(fDlg.exec())
+    {
+        main->lineEditGuiConfig->setText(fDlg.selectedFiles().at(0));
+        recentDir = fDlg.directory().absolutePath();
+    }
+}
+
+void MainWidget::loadConfiguration()
+{
+    Profile profile;
+    if (profile.load(main->lineEditGuiConfig->text()))
+    {
+        loadedProfile = profile;
+        showProfile(profile);
+        setLogLines();
+        setWatches();
+        main->snapshotView->setRange(main->lineEditRamAddress->text(), main->lineEditRamSize->text());
+        ocdOutput->append("GUI: GUI-Config loaded");
+    }
+}
+
+void MainWidget::saveConfiguration()
+{
+    QFile cfgFile(main->lineEditGuiConfig->text());
+    if (cfgFile.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        QTextStream cfgOut(&cfgFile);
+        cfgOut << "BASE = " << main->lineEditBaseAddress->text() << " " << endl;
+        cfgOut << "FLASH = " << main->lineEditFlashAddress->text() << " "
+                     << main->lineEditFlashSize->text() << endl;
+        cfgOut << "RAM = " << main->lineEditRamAddress->text() << " "
+                   << main->lineEditRamSize->text() << endl;
+        cfgOut << "REMAP = " << main->lineEditRemapAddress->text() << " "
+                     << main->lineEditRemapValue->text() << endl;
+        cfgOut << "RESETCPU = " << main->lineEditCpuResetAddress->text() << " "
+                    << main->lineEditCpuResetValue->text() << endl;
+        cfgOut << "RESETPERIPH = " << main->lineEditPeriphResetAddress->text() << " "
+                       << main->lineEditPeriphResetValue->text() << endl;
+        cfgOut << "FLASHPROBE = " << main->lineEditFlashProbeCmd->text() << " " << endl;
+        cfgOut << "FLASHINFO = " << main->lineEditFlashInfoCmd->text() << " " << endl;
+        cfgOut << "FLASHERASE = " << main->lineEditFlashEraseCmd->text() << " " << endl;
+        cfgOut << "FLASHUNLOCK = " << main->lineEditFlashUnlockCmd->text() << " " << endl;
+        cfgOut << "FLASHWRITE = " << main->lineEditFlashWriteCmd->text() << " " << endl;
+        cfgOut << "FLASHVERIFY = " << loadedProfile.value("FLASHVERIFY") << " " << endl;
+        cfgOut << "ERASESUFFIX = " << main->lineEditEraseSuffix->text() << " " << endl;
+        cfgOut << "RAMWRITE = " << main->lineEditRamWriteCmd->text() << " " << endl;
+        cfgOut << "RESET = " << main->lineEditResetCmd->text() << " " << endl;
+        cfgOut << "HALT = " << main->lineEditHaltCmd->text() << " " << endl;
+        cfgOut << "RESUME = " << main->lineEditResumeCmd->text() << " " << endl;
+        cfgOut << "POLL = " << main->lineEditPollCmd->text() << " " << endl;
+        cfgOut << "SOFTRESET = " << main->lineEditSoftResetCmd->text() << " " << endl;
+        cfgOut << "LOGLINES = " << main->lineEditLogLines->text() << " " << endl;
+        cfgOut << "FLASHSECTOR = " << main->lineEditFlashSector->text() << " " << endl;
+        ocdOutput->append("GUI: GUI-Config saved as " + cfgFile.fileName());
+    }
+}
+
+void MainWidget::setLogLines() // retention of the output views
+{
+    int lines = main->lineEditLogLines->text().toInt();
+    if (lines > 0)
+    {
+        main->textEditOutput->setMaxLines(lines);
+        main->textEditOcdTerminal->setMaxLines(lines);
+    }
+}
+
+
+
+// private Funktions:
+void MainWidget::setWatches() // the registers of the command buttons
+{
+    bool ok;
+    quint32 address = main->lineEditRemapAddress->text().toUInt(&ok, 0);
+    if (ok)
+        main->watchView->addWatch("REMAP", address);
+    address = main->lineEditCpuResetAddress->text().toUInt(&ok, 0);
+    if (ok)
+        main->watchView->addWatch("RESETCPU", address);
+    address = main->lineEditPeriphResetAddress->text().toUInt(&ok, 0);
+    if (ok)
+        main->watchView->addWatch("RESETPERIPH", address);
+}
+
+void MainWidget::showProfile(const Profile &profile) // into the settings tab
+{
+    setFromProfile(main->lineEditBaseAddress, profile, "BASE", 0);
+    setFromProfile(main->lineEditFlashAddress, profile, "FLASH", 0);
+    setFromProfile(main->lineEditFlashSize, profile, "FLASH", 1);
+    setFromProfile(main->lineEditRamAddress, profile, "RAM", 0);
+    setFromProfile(main->lineEditRamSize, profile, "RAM", 1);
+    setFromProfile(main->lineEditRemapAddress, profile, "REMAP", 0);
+    setFromProfile(main->lineEditRemapValue, profile, "REMAP", 1);
+    setFromProfile(main->lineEditCpuResetAddress, profile, "RESETCPU", 0);
+    setFromProfile(main->lineEditCpuResetValue, profile, "RESETCPU", 1);
+    setFromProfile(main->lineEditPeriphResetAddress, profile, "RESETPERIPH", 0);
+    setFromProfile(main->lineEditPeriphResetValue, profile, "RESETPERIPH", 1);
+    setFromProfile(main->lineEditFlashProbeCmd, profile, "FLASHPROBE");
+    setFromProfile(main->lineEditFlashInfoCmd, profile, "FLASHINFO");
+    setFromProfile(main->lineEditFlashEraseCmd, profile, "FLASHERASE");
+    setFromProfile(main->lineEditFlashUnlockCmd, profile, "FLASHUNLOCK");
+    setFromProfile(main->lineEditFlashWriteCmd, profile, "FLASHWRITE");
+    setFromProfile(main->lineEditEraseSuffix, profile, "ERASESUFFIX");
+    setFromProfile(main->lineEditRamWriteCmd, profile, "RAMWRITE");
+    setFromProfile(main->lineEditResetCmd, profile, "RESET");
+    setFromProfile(main->lineEditHaltCmd, profile, "HALT");
+    setFromProfile(main->lineEditResumeCmd, profile, "RESUME");
+    setFromProfile(main->lineEditPollCmd, profile, "POLL");
+    setFromProfile(main->lineEditSoftResetCmd, profile, "SOFTRESET");
+    setFromProfile(main->lineEditLogLines, profile, "LOGLINES", 0);
+    setFromProfile(main->lineEditFlashSector, profile, "FLASHSECTOR", 0);
+}
+
+void MainWidget::setFromProfile(QLineEdit *edit, const Profile &profile, const QString &key, int field) // keep the default if the key is missing
+{
+    QString value = (field < 0) ? profile.value(key) : profile.field(key, field);
+    if (!value.isEmpty())
+        edit->setText(value);
+}
+
+Profile MainWidget::currentProfile() const // the settings tab, as the flows use it
+{
+    Profile profile = loadedProfile;
+    profile.setValue("BASE", main->lineEditBaseAddress->text());
+    profile.setValue("FLASH", main->lineEditFlashAddress->text() + " " + main->lineEditFlashSize->text());
+    profile.setValue("RAM", main->lineEditRamAddress->text() + " " + main->lineEditRamSize->text());
+    profile.setValue("REMAP", main->lineEditRemapAddress->text() + " " + main->lineEditRemapValue->text());
+    profile.setValue("RESETCPU", main->lineEditCpuResetAddress->text() + " " + main->lineEditCpuResetValue->text());
+    profile.setValue("RESETPERIPH", main->lineEditPeriphResetAddress->text() + " " + main->lineEditPeriphResetValue->text());
+    profile.setValue("FLASHPROBE", main->lineEditFlashProbeCmd->text());
+    profile.setValue("FLASHINFO", main->lineEditFlashInfoCmd->text());
+    profile.setValue("FLASHERASE", main->lineEditFlashEraseCmd->text());
+    profile.setValue("FLASHUNLOCK", main->lineEditFlashUnlockCmd->text());
+    profile.setValue("FLASHWRITE", main->lineEditFlashWriteCmd->text());
+    profile.setValue("ERASESUFFIX", main->lineEditEraseSuffix->text());
+    profile.setValue("RAMWRITE", main->lineEditRamWriteCmd->text());
+    profile.setValue("RESET", main->lineEditResetCmd->text());
+    profile.setValue("HALT", main->lineEditHaltCmd->text());
+    profile.setValue("RESUME", main->lineEditResumeCmd->text());
+    profile.setValue("POLL", main->lineEditPollCmd->text());
+    profile.setValue("SOFTRESET", main->lineEditSoftResetCmd->text());
+    profile.setValue("FLASHSECTOR", main->lineEditFlashSector->text());
+    return profile;
+}
+
+void MainWidget::memoryTouched(const QString &command) // drop what a command may have changed from the memory view
+{
+    QStringList words = command.simplified().split(' ', QString::SkipEmptyParts);
+    if (words.isEmpty())
+        return;
+    QString verb = words.at(0);
+    if (verb == "flash" && words.size() > 1)
+        verb += " " + words.at(1);
+    bool ok, countOk;
+
+    if (verb == "mww" || verb == "mwh" || verb == "mwb")
+    {
+        quint32 address = words.value(1).toUInt(&ok, 0);
+        quint32 count = words.value(3, "1").toUInt(&countOk, 0);
+        quint32 width = (verb == "mww") ? 4 : (verb == "mwh") ? 2 : 1;
+        if (ok && countOk)
+            main->memoryView->invalidate(address, width * count);
+        else
+            main->memoryView->invalidate();
+    }
+    else if (verb == "load_image" || verb == "flash write_image")
+    {
+        if (words.at(0) == "flash")
+            words.removeFirst();
+        words.removeAll("erase");
+        words.removeAll("unlock");
+        quint32 address = words.value(2, "0").toUInt(&ok, 0);	// after the verb and the file
+        qint64 size = QFileInfo(words.value(1)).size();
+        if (ok && size > 0 && words.value(3, "bin") == "bin")
+            main->memoryView->invalidate(address, quint32(size));
+        else
+            main->memoryView->invalidate();
+    }
+    else if (verb == "flash erase_address")
+    {
+        quint32 address = words.value(2).toUInt(&ok, 0);
+        quint32 length = words.value(3).toUInt(&countOk, 0);
+        if (ok && countOk)
+            main->memoryView->invalidate(address, length);
+        else
+            main->memoryView->invalidate();
+    }
+    else if (verb == "resume" || verb == "step" || verb == "reset" || verb == "soft_reset_halt"
+             || verb == "flash erase_sector" || verb == "flash fillw" || verb == "flash fillb")
+    {
+        main->memoryView->invalidate();		// the target ran or whole sectors changed
+    }
+}
+
+void MainWidget::showOutput(OutputRenderer *output, AnsiFilter &filter, const QByteArray &data)
+{
+    QString text = filter.toUnicode(data); // without CR and terminal control codes
+    if (!text.isEmpty())
+        output->append(text);
+}
+
+void MainWidget::removeEmptyLines()
+{
+
+}
+
+void MainWidget::runStep(const QString &step) // a command button, with the commands of the settings tab
+{
+    flow->setProfile(currentProfile());
+    flow->runStep(step);
+}
+
+void MainWidget::showHistory() // sparkline of the recent FLASH loads
+{
+    QString target = historyTarget("FLASH");
+    QList<LoadRecord> runs = history->recent(target, 30);
+    QList<double> rates;
+    QString tip = target + ", KiB/s:";
+    for (int i = 0; i < runs.size(); i++)
+    {
+        if (!runs.at(i).ok)
+            continue;
+        rates << runs.at(i).rate();
+        if (i >= runs.size() - 5)
+            tip += "\n" + runs.at(i).when.toString("yyyy-MM-dd hh:mm") + "  "
+                   + QString::number(runs.at(i).rate(), 'f', 1) + "  " + QFileInfo(runs.at(i).image).fileName();
+    }
+    main->sparklineFlash->setValues(rates);
+    main->sparklineFlash->setToolTip(tip);
+}
+
+QString MainWidget::historyTarget(const QString &memory) const // runs are kept per openOCD config
+{
+    return QFileInfo(main->lineEditOcdConfig->text()).fileName() + " " + memory;
+}
@@ -1,93 +1,155 @@
-/*
-Graphical frontend for the Open On-Chip Debugger
-Copyright (C) 2013 Sven Sperner
-
-This program is free software: you can redistribute it and/or modify
-it under the terms of the GNU General Public License as published by
-the Free Software Foundation, either version 3 of the License, or
-(at your option) any later version.
-
-This program is distributed in the hope that it will be useful,
-but WITHOUT ANY WARRANTY; without even the implied warranty of
-MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-GNU General Public License for more details.
-
-You should have received a copy of the GNU General Public License
-along with this program.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
-#ifndef MAINWIDGET_H
-#define MAINWIDGET_H
-
-#include <QProcess>
-//#include <QtTelnet>
-#include "QtTelnet/qttelnet.h"
-#include <QtGui/QWidget>
-#include <QFile>
-
-#define DIR_FILE_NAME "/tmp/oocdqt-recentdir.dat"
-
-namespace Ui
-{
-    class MainWidget;
-}
-
-class MainWidget : public QWidget
-{
-    Q_OBJECT
-
-public:
-    MainWidget(QWidget *parent = 0);
-    ~MainWidget();
-
-private:
-    QString stripCR(const QString &msg);
-    void removeEmptyLines();
-
-
-private slots:
-// control buttons:
-    void connectToServer();
-    void telnetConnected();
-    void telnetConnectionError();
-    void resetOocd();
-    void telnetMessage(const QString &msg);
-    void telnetData();
-    void ramFileSelect();
-    void ramLoad();
-    void flashFileSelect();
-    void flashLoad();
-// command buttons:
-    void softReset();
-    void reset();
-    void halt();
-    void resume();
-    void poll();
-    void eraseFlash();
-    void showMemory();
-    void remap();
-    void peripheralReset();
-    void cpuReset();
-// openocd tab:
-    void ocdConfigFileSelect();
-    void ocdConfigStart();
-    void openOcdMessage();
-    void openOcdStdout();
-    void openOcdStderr();
-    void editUndo();
-    void editRedo();
-    void editReload();
-    void editSave();
-// config tab
-    void selectConfigFile();
-    void loadConfiguration();
-    void saveConfiguration();
-
-private:
-    Ui::MainWidget *main;
-    QProcess *openOCD;
-    QtTelnet *telnet;
-    QString recentDir;
-};
-
-#endif // MAINWIDGET_H
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAINWIDGET_H
+#define MAINWIDGET_H
+
+//#include <QtTelnet>
+#include "ansifilter.h"
+#include <QtGui/QWidget>
+#include <QStringList>
+#include <QFile>
+#include "loadstats.h"
+#include "profile.h"
+
+#define DIR_FILE_NAME "/tmp/oocdqt-recentdir.dat"
+#define HISTORY_FILE_NAME "/.oocdqt-history.dat"	// in the home directory
+#define SNAPSHOT_DIR_NAME "/.oocdqt-snapshots"	// in the home directory
+
+class OutputRenderer;
+class OcdTransport;
+class TelnetTransport;
+class OcdReply;
+class GdbRemote;
+class TargetFlow;
+class OcdSupervisor;
+class OcdLog;
+class MemoryDump;
+class QLineEdit;
+
+namespace Ui
+{
+    class MainWidget;
+}
+
+class MainWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    MainWidget(QWidget *parent = 0);
+    ~MainWidget();
+
+private:
+    void setWatches();
+    void showProfile(const Profile &profile);
+    void setFromProfile(QLineEdit *edit, const Profile &profile, const QString &key, int field = -1);
+    Profile currentProfile() const;
+    void showOutput(OutputRenderer *output, AnsiFilter &filter, const QByteArray &data);
+    void removeEmptyLines();
+    void runStep(const QString &step);
+    void showHistory();
+    QString historyTarget(const QString &memory) const;
+    void memoryTouched(const QString &command);
+
+
+private slots:
+// control buttons:
+    void connectToServer();
+    void selectTransport(int index);
+    void telnetConnected();
+    void telnetConnectionError();
+    void resetOocd();
+    void abortCommands();
+    void telnetMessage(const QByteArray &msg);
+    void telnetBufferHigh(int size, int capacity);
+    void telnetBufferLow(int size);
+    void telnetData();
+    void flowMessage(const QString &text);
+    void flowCommand(OcdReply *reply);
+    void flowProgress(qint64 done, qint64 total);
+    void flowLoaded(const LoadRecord &record);
+    void gdbConnected();
+    void gdbError(const QString &message);
+    void gdbOutput(const QString &text);
+    void gdbWritten(quint32 address, qint64 length);
+    void ramFileSelect();
+    void ramLoad();
+    void flashFileSelect();
+    void flashLoad();
+    void stationFlash();
+// command buttons:
+    void softReset();
+    void reset();
+    void halt();
+    void resume();
+    void poll();
+    void eraseFlash();
+    void showMemory();
+    void remap();
+    void peripheralReset();
+    void cpuReset();
+// memory tab:
+    void memoryRegion(int index);
+    void memoryShow();
+    void memoryRefresh();
+    void memoryRead();
+    void memoryDump();
+    void memoryDumpProgress(qint64 done, qint64 total, double rate);
+    void memoryDumpFinished(bool ok, const QString &message);
+    void snapshotJump(quint32 address);
+// openocd tab:
+    void ocdConfigFileSelect();
+    void ocdConfigStart();
+    void ocdRestart();
+    void ocdOptions();
+    void openOcdLines(const QStringList &lines);
+    void openOcdReady(quint16 telnetPort, quint16 tclPort, quint16 gdbPort);
+    void openOcdStopped();
+    void openOcdCrashed(int exitCode);
+    void openOcdError(const QString &message);
+    void editUndo();
+    void editRedo();
+    void editReload();
+    void editSave();
+// config tab
+    void selectConfigFile();
+    void loadConfiguration();
+    void saveConfiguration();
+    void setLogLines();
+
+private:
+    Ui::MainWidget *main;
+    OcdSupervisor *supervisor;
+    OcdLog *ocdLog;
+    OcdTransport *transport;
+    TelnetTransport *telnetTransport;
+    OcdTransport *tclTransport;
+    GdbRemote *gdb;
+    TargetFlow *flow;
+    MemoryDump *dump;
+    int loadPercent;
+    LoadHistory *history;
+    Profile loadedProfile;	// keys the settings tab does not show
+    OutputRenderer *telnetOutput;
+    OutputRenderer *ocdOutput;
+    AnsiFilter telnetFilter;
+    QString recentDir;
+};
+
+#endif // MAINWIDGET_H
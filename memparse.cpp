@@ -0,0 +1,259 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "memparse.h"
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+// value of one hex digit, -1 if c is none
+static inline int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+// the digits hex characters at text as a number, false if one is no hex digit
+static inline bool hexValue(const char *text, int digits, quint32 *value)
+{
+    quint32 v = 0;
+    for (int i = 0; i < digits; ++i)
+    {
+        int d = hexDigit(text[i]);
+        if (d < 0)
+            return false;
+        v = (v << 4) | d;
+    }
+    *value = v;
+    return true;
+}
+
+static inline bool isSeparator(const char *p, const char *end)
+{
+    return p == end || *p == ' ' || *p == '\r' || *p == '\t';
+}
+
+static inline void store(void *values, int index, quint32 value, int width)
+{
+    if (width == 4)
+    {
+        quint32 v = value;
+        memcpy(static_cast<char *>(values) + 4 * index, &v, 4);
+    }
+    else if (width == 2)
+    {
+        quint16 v = quint16(value);
+        memcpy(static_cast<char *>(values) + 2 * index, &v, 2);
+    }
+    else
+    {
+        static_cast<quint8 *>(values)[index] = quint8(value);
+    }
+}
+
+#ifdef __SSE2__
+// the two words "xxxxxxxx yyyyyyyy" at text, false if a character is no hex digit
+static inline bool hexWordPair(const char *text, void *values)
+{
+    __m128i c = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(text)),
+                                   _mm_loadl_epi64(reinterpret_cast<const __m128i *>(text + 9)));
+    __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+    if (_mm_movemask_epi8(_mm_or_si128(digit, alpha)) != 0xffff)
+        return false;
+
+    __m128i nibbles = _mm_add_epi8(_mm_and_si128(c, _mm_set1_epi8(0x0f)), _mm_and_si128(alpha, _mm_set1_epi8(9)));
+    // the first character of a pair is the high nibble of the byte
+    __m128i bytes = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0xf0)), _mm_srli_epi16(nibbles, 8));
+    bytes = _mm_packus_epi16(bytes, bytes);
+    // the text has the most significant byte first, reverse each word
+    bytes = _mm_shufflelo_epi16(bytes, _MM_SHUFFLE(2, 3, 0, 1));
+    bytes = _mm_or_si128(_mm_slli_epi16(bytes, 8), _mm_srli_epi16(bytes, 8));
+    _mm_storel_epi64(static_cast<__m128i *>(values), bytes);
+    return true;
+}
+#endif
+
+
+MemoryParser::MemoryParser(quint32 address, int width) : address(address), width(width == 1 || width == 2 ? width : 4),
+    vectorised(true)
+{
+}
+
+int MemoryParser::parseDump(const char *text, int size, quint32 *values, int count)
+{
+    if (width != 4)
+    {
+        fail("Words asked for from a dump of width " + QString::number(width));
+        return 0;
+    }
+    return dumpValues(text, size, values, count, 4);
+}
+
+int MemoryParser::parseDump(const char *text, int size, quint16 *values, int count)
+{
+    if (width != 2)
+    {
+        fail("Halfwords asked for from a dump of width " + QString::number(width));
+        return 0;
+    }
+    return dumpValues(text, size, values, count, 2);
+}
+
+int MemoryParser::parseDump(const char *text, int size, quint8 *values, int count)
+{
+    if (width != 1)
+    {
+        fail("Bytes asked for from a dump of width " + QString::number(width));
+        return 0;
+    }
+    return dumpValues(text, size, values, count, 1);
+}
+
+int MemoryParser::parseList(const char *text, int size, quint32 *values, int count)
+{
+    return listValues(text, size, values, count, 4);
+}
+
+int MemoryParser::parseList(const char *text, int size, quint16 *values, int count)
+{
+    return listValues(text, size, values, count, 2);
+}
+
+int MemoryParser::parseList(const char *text, int size, quint8 *values, int count)
+{
+    return listValues(text, size, values, count, 1);
+}
+
+QByteArray MemoryParser::dump(const QString &text, quint32 address, int width, int bytes) // target bytes in little endian order, empty unless all of them are there
+{
+    QByteArray latin = text.toLatin1();
+    MemoryParser parser(address, width);
+    QByteArray data(bytes, 0);
+    int count = bytes / parser.width;
+    if (parser.dumpValues(latin.constData(), latin.size(), data.data(), count, parser.width) < count)
+        return QByteArray();
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    char *swap = data.data();
+    for (int i = 0; i + parser.width <= bytes; i += parser.width)
+        for (int j = 0; j < parser.width / 2; j++)
+            qSwap(swap[i + j], swap[i + parser.width - 1 - j]);
+#endif
+    return data;
+}
+
+
+
+// private Funktions:
+int MemoryParser::dumpValues(const char *text, int size, void *values, int count, int width) // "0x00200000: deadbeef ..." lines
+{
+    const char *end = text + size;
+    const char *line = text;
+    const int digits = 2 * width;
+    int n = 0;
+
+    while (line < end && n < count && !hasError())
+    {
+        const char *eol = static_cast<const char *>(memchr(line, '\n', end - line));
+        if (!eol)
+            eol = end;
+        const char *p = line;
+        line = eol + 1;
+        while (p < eol && (*p == ' ' || *p == '\t'))
+            ++p;
+
+        quint32 lineAddress;
+        if (eol - p < 11 || p[0] != '0' || p[1] != 'x' || p[10] != ':' || !hexValue(p + 2, 8, &lineAddress))
+            continue;		// no dump line
+        if (lineAddress != address)
+        {
+            fail(QString("Dump line at 0x%1 where 0x%2 was expected")
+                 .arg(lineAddress, 8, 16, QChar('0')).arg(address, 8, 16, QChar('0')));
+            break;
+        }
+        p += 11;
+
+        while (n < count && eol - p > digits && *p == ' ')
+        {
+            ++p;
+#ifdef __SSE2__
+            if (vectorised && width == 4 && count - n >= 2 && eol - p >= 17 && p[8] == ' ' && isSeparator(p + 17, eol)
+                && hexWordPair(p, static_cast<char *>(values) + 4 * n))
+            {
+                n += 2;
+                p += 17;
+                address += 8;
+                continue;
+            }
+#endif
+            quint32 value;
+            if (!isSeparator(p + digits, eol) || !hexValue(p, digits, &value))
+                break;		// the rest of the line is no value
+            store(values, n++, value, width);
+            p += digits;
+            address += width;
+        }
+    }
+    return n;
+}
+
+int MemoryParser::listValues(const char *text, int size, void *values, int count, int width) // "0xde 0xad ..." or "{de ad}"
+{
+    const char *end = text + size;
+    const char *p = text;
+    int n = 0;
+
+    while (p < end && n < count && !hasError())
+    {
+        if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == '{' || *p == '}')
+        {
+            ++p;
+            continue;
+        }
+        const char *token = p;
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' && *p != '{' && *p != '}')
+            ++p;
+        const char *digits = token;
+        if (p - token > 2 && token[0] == '0' && (token[1] == 'x' || token[1] == 'X'))
+            digits += 2;
+
+        quint32 value;
+        if (p - digits > 2 * width || !hexValue(digits, int(p - digits), &value))
+        {
+            fail("Invalid value '" + QString::fromLatin1(token, int(p - token)) + "' in list");
+            break;
+        }
+        store(values, n++, value, width);
+        address += width;
+    }
+    return n;
+}
+
+bool MemoryParser::fail(const QString &text)
+{
+    message = text;
+    return false;
+}
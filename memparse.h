@@ -0,0 +1,61 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMPARSE_H
+#define MEMPARSE_H
+
+#include <QByteArray>
+#include <QString>
+
+// Turns the memory display of openOCD into binary: the lines printed by
+// mdw, mdh and mdb ("0x00200000: deadbeef 00000000 ...") and Tcl lists of
+// hex values as returned by read_memory. The address of every dump line
+// has to follow on from the previous one, other lines (the echoed command,
+// the prompt) are skipped. Parsing can go on over several calls, e.g. one
+// per reply of a chunked read.
+class MemoryParser
+{
+public:
+    MemoryParser(quint32 address, int width);	// width of a value in bytes: 1, 2 or 4
+
+    int parseDump(const char *text, int size, quint32 *values, int count);
+    int parseDump(const char *text, int size, quint16 *values, int count);
+    int parseDump(const char *text, int size, quint8 *values, int count);
+    int parseList(const char *text, int size, quint32 *values, int count);
+    int parseList(const char *text, int size, quint16 *values, int count);
+    int parseList(const char *text, int size, quint8 *values, int count);
+
+    void setVectorised(bool on) { vectorised = on; }	// SSE2 builds only, for comparisons
+    quint32 nextAddress() const { return address; }
+    bool hasError() const { return !message.isEmpty(); }
+    QString errorString() const { return message; }
+
+    static QByteArray dump(const QString &text, quint32 address, int width, int bytes);
+
+private:
+    int dumpValues(const char *text, int size, void *values, int count, int width);
+    int listValues(const char *text, int size, void *values, int count, int width);
+    bool fail(const QString &text);
+
+    quint32 address;		// of the next value expected
+    int width;
+    bool vectorised;		// decode word pairs with SSE2
+    QString message;
+};
+
+#endif // MEMPARSE_H
@@ -0,0 +1,273 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "memview.h"
+#include "ocdtransport.h"
+#include "memparse.h"
+#include <QPainter>
+#include <QScrollBar>
+#include <QKeyEvent>
+#include <QPaintEvent>
+
+
+BlockCache::BlockCache(int maxBlocks) : limit(qMax(maxBlocks, 1))
+{
+}
+
+const QByteArray *BlockCache::find(quint32 block)
+{
+    QHash<quint32, Entry>::iterator i = blocks.find(block);
+    if (i == blocks.end())
+        return 0;
+    order.erase(i->age);
+    i->age = order.insert(order.end(), block);
+    return &i->data;
+}
+
+void BlockCache::insert(quint32 block, const QByteArray &data)
+{
+    QHash<quint32, Entry>::iterator i = blocks.find(block);
+    if (i != blocks.end())
+        order.erase(i->age);
+    else if (blocks.size() >= limit)
+        blocks.remove(order.takeFirst());
+
+    Entry entry;
+    entry.data = data;
+    entry.age = order.insert(order.end(), block);
+    blocks.insert(block, entry);
+}
+
+void BlockCache::invalidate(quint32 start, quint32 length)
+{
+    if (!length)
+        return;
+    quint32 last = start + (length - 1);	// inclusive, so the end of the address space works
+    if (last < start)
+        last = 0xffffffff;
+    for (quint32 block = blockOf(start); ; block += BlockSize)
+    {
+        QHash<quint32, Entry>::iterator i = blocks.find(block);
+        if (i != blocks.end())
+        {
+            order.erase(i->age);
+            blocks.erase(i);
+        }
+        if (last - block < BlockSize)
+            break;
+    }
+}
+
+void BlockCache::clear()
+{
+    blocks.clear();
+    order.clear();
+}
+
+
+
+MemoryView::MemoryView(QWidget *parent) : QAbstractScrollArea(parent), start(0), length(0), words(true),
+                                          highlight(0xffffffff), fetched(0)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    QFont mono("Monospace");
+    mono.setStyleHint(QFont::TypeWriter);
+    setFont(mono);
+}
+
+void MemoryView::setTransport(OcdTransport *transport)
+{
+    if (transport == this->transport)
+        return;
+    this->transport = transport;
+    invalidate();
+}
+
+void MemoryView::setRange(quint32 start, quint32 length)
+{
+    this->start = start & ~quint32(RowBytes - 1);
+    this->length = length + (start - this->start);
+    highlight = 0xffffffff;
+    verticalScrollBar()->setValue(0);
+    updateScrollBars();
+    viewport()->update();
+}
+
+void MemoryView::setWordMode(bool words)
+{
+    this->words = words;
+    viewport()->update();
+}
+
+void MemoryView::invalidate() // target ran, nothing read so far is valid
+{
+    cache.clear();
+    pending.clear();	// replies still in flight are ignored
+    viewport()->update();
+}
+
+void MemoryView::invalidate(quint32 start, quint32 length) // written by a command
+{
+    cache.invalidate(start, length);
+    drop(start, length);
+    viewport()->update();
+}
+
+void MemoryView::jumpTo(quint32 address)
+{
+    if (address < start || address - start >= length)
+        setRange(address, qMax<quint32>(length, BlockCache::BlockSize));
+    highlight = address & ~quint32(RowBytes - 1);
+    QScrollBar *s = verticalScrollBar();
+    s->setValue(int((highlight - start) / RowBytes) - s->pageStep() / 2);
+    viewport()->update();
+}
+
+
+
+// protected:
+void MemoryView::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    const QFontMetrics fm(font());
+    int lineHeight = fm.lineSpacing();
+    quint32 rows = (length + RowBytes - 1) / RowBytes;
+
+    quint32 first = verticalScrollBar()->value() + event->rect().top() / lineHeight;
+    quint32 last = qMin(rows, quint32(verticalScrollBar()->value() + event->rect().bottom() / lineHeight + 1));
+    for (quint32 row = first; row < last; ++row)
+    {
+        int y = int(row - verticalScrollBar()->value()) * lineHeight;
+        quint32 address = start + row * RowBytes;
+        if (address == highlight)
+        {
+            painter.fillRect(0, y, viewport()->width(), lineHeight, palette().color(QPalette::Highlight));
+            painter.setPen(palette().color(QPalette::HighlightedText));
+        }
+        else
+        {
+            painter.setPen(palette().color(QPalette::Text));
+        }
+        painter.drawText(2, y + fm.ascent(), rowText(address));
+    }
+}
+
+void MemoryView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void MemoryView::keyPressEvent(QKeyEvent *event)
+{
+    QScrollBar *s = verticalScrollBar();
+    if (event->key() == Qt::Key_Home)
+        s->setValue(0);
+    else if (event->key() == Qt::Key_End)
+        s->setValue(s->maximum());
+    else if (event->key() == Qt::Key_PageUp)
+        s->setValue(s->value() - s->pageStep());
+    else if (event->key() == Qt::Key_PageDown)
+        s->setValue(s->value() + s->pageStep());
+    else if (event->key() == Qt::Key_Up)
+        s->setValue(s->value() - 1);
+    else if (event->key() == Qt::Key_Down)
+        s->setValue(s->value() + 1);
+    else
+        QAbstractScrollArea::keyPressEvent(event);
+}
+
+
+
+// private Slots:
+void MemoryView::replyFinished()
+{
+    OcdReply *reply = qobject_cast<OcdReply *>(sender());
+    if (!reply)
+        return;
+    reply->deleteLater();
+    if (!pending.contains(reply))
+        return;		// invalidated while it was read
+    quint32 block = pending.take(reply);
+
+    QByteArray data;
+    if (!reply->isAborted())
+        data = MemoryParser::dump(reply->response(), block, 4, BlockCache::BlockSize);
+    cache.insert(block, data);	// unreadable blocks too, so they are not asked for again and again
+    emit blockRead(block, data.size());
+    viewport()->update();
+}
+
+
+
+// private Funktions:
+void MemoryView::updateScrollBars()
+{
+    int rows = viewport()->height() / QFontMetrics(font()).lineSpacing();
+    qint64 lines = (qint64(length) + RowBytes - 1) / RowBytes;
+
+    verticalScrollBar()->setPageStep(qMax(rows, 1));
+    verticalScrollBar()->setRange(0, int(qMax(lines - rows, qint64(0))));
+}
+
+void MemoryView::fetch(quint32 block)
+{
+    if (!transport || !transport->isConnected())
+        return;
+    if (!pending.keys(block).isEmpty())
+        return;
+    OcdReply *reply = transport->execute(QString("mdw 0x%1 %2").arg(block, 8, 16, QChar('0')).arg(BlockCache::BlockSize / 4));
+    pending.insert(reply, block);
+    connect(reply, SIGNAL(finished()), this, SLOT(replyFinished()));
+    fetched++;
+}
+
+void MemoryView::drop(quint32 start, quint32 length) // forget reads in flight for the range
+{
+    QHash<OcdReply *, quint32>::iterator i = pending.begin();
+    while (i != pending.end())
+    {
+        qint64 block = i.value();
+        if (block + BlockCache::BlockSize > start && block < qint64(start) + length)
+            i = pending.erase(i);
+        else
+            ++i;
+    }
+}
+
+QString MemoryView::rowText(quint32 address) // "0x00200000: deadbeef ..." and the characters, fetches the block if needed
+{
+    QString text = QString("0x%1: ").arg(address, 8, 16, QChar('0'));
+    quint32 block = BlockCache::blockOf(address);
+    const QByteArray *data = cache.find(block);
+    if (!data)
+        fetch(block);
+    const char *bytes = (data && !data->isEmpty()) ? data->constData() + (address - block) : 0;
+    const char *missing = (data ? "xx" : "..");	// unreadable, or not read yet
+
+    QString chars;
+    for (int i = 0; i < RowBytes; i += (words ? 4 : 1))
+    {
+        text += ' ';
+        for (int j = (words ? 3 : 0); j >= 0; j--)	// words are little endian
+            text += bytes ? QString("%1").arg(quint8(bytes[i + j]), 2, 16, QChar('0')) : QString(missing);
+    }
+    for (int i = 0; i < RowBytes; i++)
+        chars += (bytes && bytes[i] >= 0x20 && bytes[i] < 0x7f) ? QChar(bytes[i]) : QChar('.');
+    return text + "  " + chars;
+}
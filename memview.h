@@ -0,0 +1,110 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMVIEW_H
+#define MEMVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QByteArray>
+#include <QHash>
+#include <QLinkedList>
+#include <QPointer>
+
+class OcdTransport;
+class OcdReply;
+
+// Fixed-size blocks of target memory, the least recently used one is
+// dropped when more than maxBlocks are held.
+class BlockCache
+{
+public:
+    enum { BlockSize = 256 };
+
+    BlockCache(int maxBlocks = 256);
+
+    static quint32 blockOf(quint32 address) { return address & ~quint32(BlockSize - 1); }
+
+    const QByteArray *find(quint32 block);	// 0 if not cached, else marks it used
+    void insert(quint32 block, const QByteArray &data);
+    void invalidate(quint32 start, quint32 length);
+    void clear();
+    int count() const { return blocks.size(); }
+
+private:
+    struct Entry
+    {
+        QByteArray data;	// empty if the target could not be read
+        QLinkedList<quint32>::iterator age;
+    };
+
+    int limit;
+    QHash<quint32, Entry> blocks;
+    QLinkedList<quint32> order;	// least recently used first
+};
+
+// Hex view of a range of target memory. Blocks are read with "mdw" only
+// once they are scrolled into view and stay cached until the target runs
+// again or the range is written.
+class MemoryView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    MemoryView(QWidget *parent = 0);
+
+    void setTransport(OcdTransport *transport);
+    void setRange(quint32 start, quint32 length);
+    quint32 rangeStart() const { return start; }
+    quint32 rangeLength() const { return length; }
+    void setWordMode(bool words);
+    int reads() const { return fetched; }
+
+public slots:
+    void invalidate();
+    void invalidate(quint32 start, quint32 length);
+    void jumpTo(quint32 address);
+
+signals:
+    void blockRead(quint32 address, int bytes);
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void resizeEvent(QResizeEvent *event);
+    void keyPressEvent(QKeyEvent *event);
+
+private slots:
+    void replyFinished();
+
+private:
+    enum { RowBytes = 16 };
+
+    void updateScrollBars();
+    void fetch(quint32 block);
+    void drop(quint32 start, quint32 length);
+    QString rowText(quint32 address);
+
+    QPointer<OcdTransport> transport;
+    BlockCache cache;
+    QHash<OcdReply *, quint32> pending;	// block of every read in flight, dropped when invalidated
+    quint32 start, length;
+    bool words;
+    quint32 highlight;			// address of the last jump
+    int fetched;
+};
+
+#endif // MEMVIEW_H
@@ -0,0 +1,200 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ocdlog.h"
+#include <QComboBox>
+#include <QLineEdit>
+#include <QLabel>
+#include <QListWidget>
+#include <QPushButton>
+#include <QBoxLayout>
+
+static const int MaxLine = 64 * 1024;	// characters, longer lines are split
+static const int IdleFlush = 250;	// ms before an unterminated line is shown
+static const int MaxEntries = 2000;
+
+
+OcdLog::OcdLog(QObject *parent) : QObject(parent)
+{
+    idle.setSingleShot(true);
+    idle.setInterval(IdleFlush);
+    connect(&idle, SIGNAL(timeout()), this, SLOT(flush()));
+    reset();
+}
+
+OcdLog::Severity OcdLog::classify(const QString &line) // "Error: ", "Warn : ", "Info : ", "Debug: ", "User : "
+{
+    if (line.size() < 6 || line.at(5) != QLatin1Char(':'))
+        return Info;		// command output, banner
+    switch (line.at(0).unicode())
+    {
+    case 'E':
+        return line.startsWith(QLatin1String("Error")) ? Error : Info;
+    case 'W':
+        return line.startsWith(QLatin1String("Warn ")) ? Warn : Info;
+    case 'D':
+        return line.startsWith(QLatin1String("Debug")) ? Debug : Info;
+    default:
+        return Info;
+    }
+}
+
+QString OcdLog::severityName(int severity)
+{
+    static const char *const names[] = { "Debug", "Info", "Warn", "Error" };
+    return (severity >= Debug && severity <= Error) ? names[severity] : "";
+}
+
+void OcdLog::reset()
+{
+    filter.reset();
+    partial.clear();
+    idle.stop();
+    for (int i = Debug; i <= Error; i++)
+        counts[i] = 0;
+}
+
+void OcdLog::feed(const QByteArray &data) // a chunk of process output, cut anywhere
+{
+    QString text = filter.toUnicode(data);	// without CR and terminal control codes
+    if (text.isEmpty())
+        return;
+
+    QStringList complete = text.split('\n');
+    complete.first().prepend(partial);
+    partial = complete.takeLast();
+    if (partial.size() > MaxLine)
+    {
+        complete << partial;
+        partial.clear();
+    }
+    if (!complete.isEmpty())
+        emitLines(complete);
+    if (partial.isEmpty())
+        idle.stop();
+    else
+        idle.start();
+}
+
+void OcdLog::flush()
+{
+    idle.stop();
+    if (partial.isEmpty())
+        return;
+    QStringList last(partial);
+    partial.clear();
+    emitLines(last);
+}
+
+
+
+// private Funktions:
+void OcdLog::emitLines(const QStringList &complete)
+{
+    for (int i = 0; i < complete.size(); i++)
+    {
+        Severity severity = classify(complete.at(i));
+        counts[severity]++;
+        if (severity >= Warn)
+            emit tagged(severity, complete.at(i));
+    }
+    emit lines(complete);
+}
+
+
+
+OcdErrorList::OcdErrorList(QWidget *parent) : QWidget(parent), errors(0), warnings(0)
+{
+    severityBox = new QComboBox(this);
+    severityBox->addItem("Errors and warnings");
+    severityBox->addItem("Errors");
+    severityBox->addItem("Warnings");
+    filterEdit = new QLineEdit(this);
+    filterEdit->setToolTip("show only lines containing this text");
+    countLabel = new QLabel(this);
+    QPushButton *clearButton = new QPushButton("Clear", this);
+    list = new QListWidget(this);
+    list->setUniformItemSizes(true);
+
+    QHBoxLayout *bar = new QHBoxLayout;
+    bar->addWidget(severityBox);
+    bar->addWidget(filterEdit);
+    bar->addWidget(countLabel);
+    bar->addWidget(clearButton);
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(bar);
+    layout->addWidget(list);
+
+    connect(severityBox, SIGNAL(currentIndexChanged(int)), this, SLOT(applyFilter()));
+    connect(filterEdit, SIGNAL(textChanged(QString)), this, SLOT(applyFilter()));
+    connect(clearButton, SIGNAL(clicked()), this, SLOT(clear()));
+    updateCounts();
+}
+
+void OcdErrorList::addLine(int severity, const QString &line)
+{
+    if (severity == OcdLog::Error)
+        errors++;
+    else
+        warnings++;
+    QListWidgetItem *item = new QListWidgetItem(line);
+    item->setData(Qt::UserRole, severity);
+    if (severity == OcdLog::Error)
+        item->setForeground(Qt::red);
+    list->addItem(item);
+    item->setHidden(!matches(severity, line));
+    while (list->count() > MaxEntries)
+        delete list->takeItem(0);
+    updateCounts();
+}
+
+void OcdErrorList::clear()
+{
+    list->clear();
+    errors = warnings = 0;
+    updateCounts();
+}
+
+
+
+// private slots:
+void OcdErrorList::applyFilter()
+{
+    for (int i = 0; i < list->count(); i++)
+    {
+        QListWidgetItem *item = list->item(i);
+        item->setHidden(!matches(item->data(Qt::UserRole).toInt(), item->text()));
+    }
+}
+
+
+
+// private Funktions:
+bool OcdErrorList::matches(int severity, const QString &line) const
+{
+    if ((severityBox->currentIndex() == 1 && severity != OcdLog::Error) ||
+        (severityBox->currentIndex() == 2 && severity != OcdLog::Warn))
+        return false;
+    return filterEdit->text().isEmpty() || line.contains(filterEdit->text(), Qt::CaseInsensitive);
+}
+
+void OcdErrorList::updateCounts()
+{
+    countLabel->setText(QString("%1 error(s), %2 warning(s)").arg(errors).arg(warnings));
+}
@@ -0,0 +1,94 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OCDLOG_H
+#define OCDLOG_H
+
+#include <QWidget>
+#include <QStringList>
+#include <QTimer>
+#include "ansifilter.h"
+
+class QComboBox;
+class QLineEdit;
+class QLabel;
+class QListWidget;
+
+// Output pipeline of the openOCD server: one reader for the process output
+// that assembles complete lines across chunks, tags each line by openOCD's
+// log prefix and hands the lines on in one batch per chunk.
+class OcdLog : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Severity { Debug, Info, Warn, Error };
+
+    OcdLog(QObject *parent = 0);
+
+    static Severity classify(const QString &line);
+    static QString severityName(int severity);
+    qint64 count(Severity severity) const { return counts[severity]; }
+    void reset();
+
+public slots:
+    void feed(const QByteArray &data);
+    void flush();
+
+signals:
+    void lines(const QStringList &lines);		// every complete line
+    void tagged(int severity, const QString &line);	// warnings and errors only
+
+private:
+    void emitLines(const QStringList &complete);
+
+    AnsiFilter filter;
+    QString partial;	// the last line, not terminated yet
+    QTimer idle;		// hands out a partial line that stays alone
+    qint64 counts[Error + 1];
+};
+
+// Warnings and errors of openOCD, counted, filterable by severity and
+// text, holding the latest MaxEntries of them.
+class OcdErrorList : public QWidget
+{
+    Q_OBJECT
+
+public:
+    OcdErrorList(QWidget *parent = 0);
+
+public slots:
+    void addLine(int severity, const QString &line);
+    void clear();
+
+private slots:
+    void applyFilter();
+
+private:
+    bool matches(int severity, const QString &line) const;
+    void updateCounts();
+
+    QComboBox *severityBox;
+    QLineEdit *filterEdit;
+    QLabel *countLabel;
+    QListWidget *list;
+    int errors;
+    int warnings;
+};
+
+#endif // OCDLOG_H
@@ -0,0 +1,348 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ocdsupervisor.h"
+#include "ocdtransport.h"
+#include <QRegExp>
+#include <QStringList>
+#include <QTimer>
+
+static const int KillTimeout = 2000;	// ms after SIGTERM
+static const int QuickExit = 3000;	// ms, a server dying sooner counts towards giving up
+static const int MaxQuickExits = 3;
+
+
+OcdSupervisor::OcdSupervisor(QObject *parent)
+    : QObject(parent), program("/usr/bin/openocd"), active(0), spare(0),
+      respawn(false), warm(false), restarting(false), quickExits(0)
+{
+    rpc = new TclRpcTransport(this);
+    connect(rpc, SIGNAL(connected()), this, SLOT(spareConnected()));
+    connect(rpc, SIGNAL(error(QString)), this, SLOT(spareFailed()));
+}
+
+OcdSupervisor::~OcdSupervisor()
+{
+    QList<Instance *> all = dying;
+    if (active)
+        all << active;
+    if (spare)
+        all << spare;
+    for (int i = 0; i < all.size(); i++)
+    {
+        all.at(i)->process->disconnect(this);
+        all.at(i)->process->kill();	// the QProcess destructor reaps it
+        delete all.at(i);
+    }
+}
+
+void OcdSupervisor::setWarmSpare(bool on)
+{
+    warm = on;
+    if (warm && active && !spare)
+        startSpare();
+    else if (!warm && spare)
+    {
+        terminate(spare);
+        spare = 0;
+    }
+}
+
+void OcdSupervisor::start(const QString &configFile)
+{
+    if (active)
+        return;
+    quickExits = 0;
+    if (spare && spare->config != configFile)
+    {
+        terminate(spare);
+        spare = 0;
+    }
+    config = configFile;
+    if (spare && spare->listening)
+        promote();
+    else
+        active = launch(config, false);
+    if (warm && !spare)
+        startSpare();
+}
+
+void OcdSupervisor::restart(const QString &configFile) // swap to the spare once the running server has released the adapter
+{
+    if (!active)
+    {
+        start(configFile);
+        return;
+    }
+    config = configFile;
+    if (spare && spare->config != config)
+    {
+        terminate(spare);	// parsed the config of another target
+        spare = 0;
+    }
+    restarting = true;
+    terminate(active);
+    active = 0;
+}
+
+void OcdSupervisor::stop()
+{
+    restarting = false;
+    rpc->close();
+    if (spare)
+        terminate(spare);
+    spare = 0;
+    if (active)
+        terminate(active);
+    else
+        emit stopped();
+    active = 0;
+}
+
+
+
+// private slots:
+void OcdSupervisor::processOutput()
+{
+    Instance *instance = instanceOf(sender());
+    if (!instance)
+        return;
+    QByteArray data = instance->process->readAll();
+    if (instance == active)
+        emit output(data);
+    scan(instance, data);
+}
+
+void OcdSupervisor::processFinished(int exitCode, QProcess::ExitStatus status)
+{
+    Instance *instance = instanceOf(sender());
+    if (!instance)
+        return;
+    bool quick = instance->started.elapsed() < QuickExit;
+    bool wasDying = dying.removeAll(instance);
+    bool wasSpare = (instance == spare);
+    instance->process->deleteLater();
+    delete instance;
+
+    if (wasDying)
+    {
+        if (restarting && !active)	// the adapter is free now
+        {
+            restarting = false;
+            if (spare && spare->listening)
+                promote();
+            else
+                active = launch(config, false);
+            if (warm && !spare)
+                startSpare();
+        }
+        else if (!active && !restarting)
+            emit stopped();
+        return;
+    }
+    if (wasSpare)
+    {
+        spare = 0;
+        emit error(QString("openOCD spare exited with code %1").arg(exitCode));
+        return;
+    }
+
+    active = 0;			// the server went away by itself
+    rpc->close();
+    if (status == QProcess::NormalExit && exitCode == 0)
+    {
+        emit stopped();
+        return;
+    }
+    emit crashed(exitCode);
+    if (!respawn)
+        return;
+    if (quick && ++quickExits > MaxQuickExits)
+    {
+        emit error("openOCD keeps exiting right after the start, not respawning");
+        return;
+    }
+    if (!quick)
+        quickExits = 0;
+    if (spare && spare->listening)
+        promote();
+    else
+        active = launch(config, false);
+    if (warm && !spare)
+        startSpare();
+}
+
+void OcdSupervisor::processError(QProcess::ProcessError failure) // finished() does not follow a failed start
+{
+    Instance *instance = instanceOf(sender());
+    if (!instance || failure != QProcess::FailedToStart)
+        return;
+    emit error("Can not start " + program);
+    dying.removeAll(instance);
+    if (instance == spare)
+        spare = 0;
+    if (instance == active)
+    {
+        active = 0;
+        emit stopped();
+    }
+    instance->process->deleteLater();
+    delete instance;
+}
+
+void OcdSupervisor::spareConnected()
+{
+    OcdReply *reply = rpc->execute("init");
+    connect(reply, SIGNAL(finished()), this, SLOT(spareInitialised()));
+}
+
+void OcdSupervisor::spareInitialised()
+{
+    OcdReply *reply = qobject_cast<OcdReply *>(sender());
+    if (!reply)
+        return;
+    reply->deleteLater();
+    rpc->close();
+    if (!active)
+        return;
+    if (reply->failed())
+    {
+        emit error("openOCD spare failed to init: " + reply->response().trimmed());
+        terminate(active);	// fall back to a cold start
+        active = 0;
+        restarting = true;
+        return;
+    }
+    active->spare = false;
+    emit ready(active->telnetPort, active->tclPort, active->gdbPort);
+}
+
+void OcdSupervisor::spareFailed()
+{
+    if (!active || !active->spare)
+        return;
+    emit error("Can not reach the openOCD spare");
+    terminate(active);
+    active = 0;
+    restarting = true;
+}
+
+
+
+// private Funktions:
+OcdSupervisor::Instance *OcdSupervisor::launch(const QString &configFile, bool asSpare)
+{
+    Instance *instance = new Instance;
+    instance->slot = 0;	// the set of ports nobody else holds
+    while (slotTaken(instance->slot))
+        instance->slot++;
+    instance->telnetPort = 4444 + 10 * instance->slot;
+    instance->tclPort = 6666 + 10 * instance->slot;
+    instance->gdbPort = 3333 + 10 * instance->slot;
+    instance->config = configFile;
+    instance->listening = false;
+    instance->spare = asSpare;
+    instance->stopping = false;
+
+    QStringList arguments;
+    arguments << "-f" << configFile
+              << "-c" << QString("telnet_port %1; tcl_port %2; gdb_port %3")
+                         .arg(instance->telnetPort).arg(instance->tclPort).arg(instance->gdbPort);
+    if (asSpare)
+        arguments << "-c" << "noinit";	// parse the config, keep the adapter closed
+
+    instance->process = new QProcess(this);
+    instance->process->setProcessChannelMode(QProcess::MergedChannels);
+    connect(instance->process, SIGNAL(readyRead()), this, SLOT(processOutput()));
+    connect(instance->process, SIGNAL(finished(int, QProcess::ExitStatus)),
+            this, SLOT(processFinished(int, QProcess::ExitStatus)));
+    connect(instance->process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(processError(QProcess::ProcessError)));
+    instance->started.start();
+    instance->process->start(program, arguments);
+    return instance;
+}
+
+bool OcdSupervisor::slotTaken(int slot) const
+{
+    if ((active && active->slot == slot) || (spare && spare->slot == slot))
+        return true;
+    for (int i = 0; i < dying.size(); i++)
+        if (dying.at(i)->slot == slot)
+            return true;
+    return false;
+}
+
+void OcdSupervisor::terminate(Instance *instance) // without waiting, kill it if it does not react
+{
+    instance->stopping = true;
+    instance->process->terminate();
+    QTimer::singleShot(KillTimeout, instance->process, SLOT(kill()));
+    dying << instance;
+}
+
+void OcdSupervisor::promote() // the spare becomes the active server
+{
+    active = spare;
+    spare = 0;
+    rpc->connectToHost("localhost", active->tclPort);
+}
+
+void OcdSupervisor::startSpare()
+{
+    spare = launch(config, true);
+}
+
+OcdSupervisor::Instance *OcdSupervisor::instanceOf(QObject *process) const
+{
+    if (active && active->process == process)
+        return active;
+    if (spare && spare->process == process)
+        return spare;
+    for (int i = 0; i < dying.size(); i++)
+        if (dying.at(i)->process == process)
+            return dying.at(i);
+    return 0;
+}
+
+void OcdSupervisor::scan(Instance *instance, const QByteArray &data) // look for the listening servers
+{
+    static QRegExp listening("Listening on port (\\d+) for (telnet|tcl|gdb) connections");
+    instance->line += data;
+    int end;
+    while ((end = instance->line.indexOf('\n')) != -1)
+    {
+        QString line = QString::fromLocal8Bit(instance->line.constData(), end);
+        instance->line.remove(0, end + 1);
+        if (listening.indexIn(line) == -1)
+            continue;
+        quint16 port = listening.cap(1).toUShort();
+        if (listening.cap(2) == "gdb")
+            instance->gdbPort = port;
+        else if (listening.cap(2) == "tcl")
+            instance->tclPort = port;
+        else
+        {
+            instance->telnetPort = port;
+            instance->listening = true;
+            if (instance == active && !instance->spare)
+                emit ready(instance->telnetPort, instance->tclPort, instance->gdbPort);
+        }
+    }
+    if (instance->line.size() > 4096)
+        instance->line.clear();	// no newline in sight, not a status line
+}
@@ -0,0 +1,106 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OCDSUPERVISOR_H
+#define OCDSUPERVISOR_H
+
+#include <QObject>
+#include <QProcess>
+#include <QByteArray>
+#include <QString>
+#include <QElapsedTimer>
+#include <QList>
+
+class TclRpcTransport;
+
+// Runs the openOCD server for the GUI. Readiness is taken from openOCD's
+// "Listening on port N for telnet connections", a crashed server can be
+// respawned, and a warm spare can be kept: a second instance that has
+// parsed the same config with "noinit" on its own ports, so the adapter
+// stays free until the spare is promoted by sending it "init". Stopping
+// never waits on the event loop, a server that ignores SIGTERM is
+// killed after a timeout.
+class OcdSupervisor : public QObject
+{
+    Q_OBJECT
+
+public:
+    OcdSupervisor(QObject *parent = 0);
+    ~OcdSupervisor();
+
+    void setProgram(const QString &path) { program = path; }
+    void setRespawn(bool on) { respawn = on; }
+    void setWarmSpare(bool on);
+
+    void start(const QString &config);
+    void restart(const QString &config);
+    void stop();
+    bool isRunning() const { return active != 0; }
+
+signals:
+    void output(const QByteArray &data);	// of the active server
+    void ready(quint16 telnetPort, quint16 tclPort, quint16 gdbPort);
+    void stopped();
+    void crashed(int exitCode);
+    void error(const QString &message);
+
+private slots:
+    void processOutput();
+    void processFinished(int exitCode, QProcess::ExitStatus status);
+    void processError(QProcess::ProcessError failure);
+    void spareConnected();
+    void spareInitialised();
+    void spareFailed();
+
+private:
+    struct Instance
+    {
+        QProcess *process;
+        QString config;
+        int slot;		// selects the set of ports
+        quint16 telnetPort;
+        quint16 tclPort;
+        quint16 gdbPort;
+        bool listening;
+        bool spare;		// started with noinit
+        bool stopping;
+        QByteArray line;	// incomplete last line
+        QElapsedTimer started;
+    };
+
+    Instance *launch(const QString &config, bool spare);
+    void terminate(Instance *instance);
+    void promote();
+    void startSpare();
+    bool slotTaken(int slot) const;
+    Instance *instanceOf(QObject *process) const;
+    void scan(Instance *instance, const QByteArray &data);
+
+    QString program;
+    Instance *active;
+    Instance *spare;
+    QList<Instance *> dying;	// stopped, waiting for the process to exit
+    TclRpcTransport *rpc;	// sends "init" to a promoted spare
+    QString config;
+    bool respawn;
+    bool warm;
+    bool restarting;	// promote the spare when the active server is gone
+    int quickExits;
+};
+
+#endif // OCDSUPERVISOR_H
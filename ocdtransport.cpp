@@ -0,0 +1,479 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ocdtransport.h"
+#include "QtTelnet/qttelnet.h"
+#include <QTcpSocket>
+#include <QMetaObject>
+#include <QRegExp>
+
+#define TCL_TERMINATOR '\x1a'
+
+static const int TclResultLimit = 16 * 1024 * 1024;	// bytes, mdw of a whole RAM is far less
+
+
+OcdReply::OcdReply(const QString &command, QObject *parent) : QObject(parent),
+    cmd(command), done(false), aborted(false), usecs(-1)
+{
+}
+
+void OcdReply::start() // command written
+{
+    timer.start();
+}
+
+void OcdReply::finish(const QString &response, bool abort, qint64 latency)
+{
+    if (done)
+        return;
+    if (latency < 0 && timer.isValid())
+        latency = timer.nsecsElapsed() / 1000;
+
+    resp = response;
+    aborted = abort;
+    usecs = latency;
+    done = true;
+    emit finished();
+}
+
+void OcdReply::abort()
+{
+    finish(QString(), true);
+}
+
+QString OcdReply::errorLine(const QString &response) // the first "Error: ..." line openOCD reported, else null
+{
+    QRegExp error("(^|\\n)\\s*[Ee]rror[^\\n]*");
+    if (error.indexIn(response) == -1)
+        return QString();
+    return error.cap(0).trimmed();
+}
+
+
+
+QList<OcdReply *> OcdTransport::execute(const QStringList &commands)
+{
+    QList<OcdReply *> replies;
+    for (int i = 0; i < commands.size(); i++)
+        replies << execute(commands.at(i));
+    return replies;
+}
+
+OcdReply *OcdTransport::abortedReply(const QString &command) // not connected
+{
+    OcdReply *reply = new OcdReply(command, this);
+    QMetaObject::invokeMethod(reply, "abort", Qt::QueuedConnection);
+    return reply;
+}
+
+
+
+TelnetWorker::TelnetWorker(QObject *receiver) : QObject(0), space(EventSlots - 1), wake(0), stopping(0),
+    receiver(receiver), telnet(0)
+{
+}
+
+void TelnetWorker::setup(const QString &prompt) // on the network thread
+{
+    this->prompt = prompt;
+    telnet = new QtTelnet(this);
+    telnet->setPromptString(prompt);
+    connect(telnet->socket(), SIGNAL(connected()), this, SLOT(telnetConnected()));
+    connect(telnet, SIGNAL(loggedOut()), this, SLOT(telnetClosed()));
+    connect(telnet, SIGNAL(connectionError(QAbstractSocket::SocketError)), this, SLOT(telnetError()));
+    connect(telnet, SIGNAL(rawMessage(QByteArray)), this, SLOT(telnetOutput(QByteArray)));
+    connect(telnet, SIGNAL(receiveBufferHigh()), this, SLOT(telnetBufferHigh()));
+    connect(telnet, SIGNAL(receiveBufferLow()), this, SLOT(telnetBufferLow()));
+}
+
+void TelnetWorker::shutdown()
+{
+    delete telnet;
+    telnet = 0;
+}
+
+void TelnetWorker::connectToHost(const QString &host, int port)
+{
+    telnet->connectToHost(host, port);
+}
+
+void TelnetWorker::close()
+{
+    telnet->close();
+}
+
+void TelnetWorker::sendData(const QString &data)
+{
+    telnet->sendData(data);
+}
+
+void TelnetWorker::execute(int id, const QString &command)
+{
+    QtTelnetReply *reply = telnet->execute(command);
+    ids.insert(reply, id);
+    connect(reply, SIGNAL(finished()), this, SLOT(replyFinished()));
+}
+
+void TelnetWorker::executeBatch(int firstId, const QStringList &commands) // one write for all
+{
+    QList<QtTelnetReply *> replies = telnet->execute(commands);
+    for (int i = 0; i < replies.size(); i++)
+    {
+        ids.insert(replies.at(i), firstId + i);
+        connect(replies.at(i), SIGNAL(finished()), this, SLOT(replyFinished()));
+    }
+}
+
+void TelnetWorker::abort() // interrupt openOCD, drop pending replies and their output
+{
+    telnet->abort();
+}
+
+void TelnetWorker::telnetConnected()
+{
+    post(TelnetEvent(TelnetEvent::Connected));
+}
+
+void TelnetWorker::telnetClosed()
+{
+    post(TelnetEvent(TelnetEvent::Disconnected));
+}
+
+void TelnetWorker::telnetError()
+{
+    TelnetEvent event(TelnetEvent::Error);
+    event.text = telnet->socket()->errorString();
+    post(event);
+}
+
+void TelnetWorker::telnetOutput(const QByteArray &data) // between commands only, a reply carries its own
+{
+    if (telnet->pendingReplies() > 0)
+        return;
+    between += data;
+    int end = between.lastIndexOf('\n') + 1;
+    if (between.endsWith(prompt.toLocal8Bit()))
+        end = between.size();
+    if (end == 0)
+        return;
+    TelnetEvent event(TelnetEvent::Output);
+    event.data = between.left(end);
+    between.remove(0, end);
+    post(event);
+}
+
+void TelnetWorker::telnetBufferHigh()
+{
+    TelnetEvent event(TelnetEvent::BufferHigh);
+    event.size = telnet->receiveBufferSize();
+    event.capacity = telnet->receiveBufferCapacity();
+    post(event);
+}
+
+void TelnetWorker::telnetBufferLow()
+{
+    TelnetEvent event(TelnetEvent::BufferLow);
+    event.size = telnet->receiveBufferSize();
+    event.capacity = telnet->receiveBufferCapacity();
+    post(event);
+}
+
+void TelnetWorker::replyFinished()
+{
+    QtTelnetReply *reply = qobject_cast<QtTelnetReply *>(sender());
+    TelnetEvent event(TelnetEvent::Finished);
+    event.id = ids.take(reply);
+    event.text = reply->response();
+    event.latency = reply->latency();
+    event.aborted = reply->isAborted();
+    reply->deleteLater();
+    post(event);
+}
+
+void TelnetWorker::post(const TelnetEvent &event)
+{
+    // A full queue means the GUI is behind. Sleep until it frees a slot
+    // instead of dropping events; meanwhile nothing is read, the receive
+    // buffers fill up and TCP flow control throttles openOCD.
+    while (!space.tryAcquire(1, 50))
+    {
+        if (stopping.fetchAndAddAcquire(0))
+            return;
+    }
+    events.push(event);
+    if (wake.fetchAndStoreOrdered(1) == 0)
+        QMetaObject::invokeMethod(receiver, "drain", Qt::QueuedConnection);
+}
+
+
+
+TelnetTransport::TelnetTransport(const QString &prompt, QObject *parent) : OcdTransport(parent),
+    prompt(prompt.toLocal8Bit()), lastId(0), open(false)
+{
+    worker = new TelnetWorker(this);
+    worker->moveToThread(&thread);
+    thread.start();
+    QMetaObject::invokeMethod(worker, "setup", Qt::QueuedConnection, Q_ARG(QString, prompt));
+}
+
+TelnetTransport::~TelnetTransport()
+{
+    worker->stopping.fetchAndStoreOrdered(1);
+    QMetaObject::invokeMethod(worker, "shutdown", Qt::BlockingQueuedConnection);
+    thread.quit();
+    thread.wait();
+    delete worker;
+}
+
+void TelnetTransport::connectToHost(const QString &host, quint16 port)
+{
+    QMetaObject::invokeMethod(worker, "connectToHost", Qt::QueuedConnection,
+                              Q_ARG(QString, host), Q_ARG(int, port));
+}
+
+void TelnetTransport::close()
+{
+    QMetaObject::invokeMethod(worker, "close", Qt::QueuedConnection);
+}
+
+bool TelnetTransport::isConnected() const
+{
+    return open;
+}
+
+OcdReply *TelnetTransport::execute(const QString &command)
+{
+    OcdReply *reply = new OcdReply(command, this);
+    pending.insert(++lastId, reply);
+    QMetaObject::invokeMethod(worker, "execute", Qt::QueuedConnection,
+                              Q_ARG(int, lastId), Q_ARG(QString, command));
+    return reply;
+}
+
+QList<OcdReply *> TelnetTransport::execute(const QStringList &commands) // one write for all
+{
+    QList<OcdReply *> replies;
+    int firstId = lastId + 1;
+    for (int i = 0; i < commands.size(); i++)
+    {
+        replies << new OcdReply(commands.at(i), this);
+        pending.insert(++lastId, replies.last());
+    }
+    QMetaObject::invokeMethod(worker, "executeBatch", Qt::QueuedConnection,
+                              Q_ARG(int, firstId), Q_ARG(QStringList, commands));
+    return replies;
+}
+
+void TelnetTransport::abort()
+{
+    QMetaObject::invokeMethod(worker, "abort", Qt::QueuedConnection);
+}
+
+void TelnetTransport::sendData(const QString &data) // typed by the user, no reply
+{
+    QMetaObject::invokeMethod(worker, "sendData", Qt::QueuedConnection, Q_ARG(QString, data));
+}
+
+void TelnetTransport::drain() // everything the network thread posted so far
+{
+    worker->wake.fetchAndStoreOrdered(0);
+
+    TelnetEvent event;
+    while (worker->events.pop(&event))
+    {
+        worker->space.release();
+        switch (event.type)
+        {
+        case TelnetEvent::Connected:
+            open = true;
+            emit connected();
+            break;
+        case TelnetEvent::Disconnected:
+            if (open)
+            {
+                open = false;
+                emit disconnected();
+            }
+            break;
+        case TelnetEvent::Error:
+            emit error(event.text);
+            break;
+        case TelnetEvent::Output:
+            emit output(event.data);
+            break;
+        case TelnetEvent::Finished:
+        {
+            QPointer<OcdReply> reply = pending.take(event.id);
+            if (!event.aborted)
+                emit output(event.text.toLocal8Bit() + prompt);	// the echo, the response and its prompt
+            if (reply)
+                reply->finish(event.text, event.aborted, event.latency);
+            break;
+        }
+        case TelnetEvent::BufferHigh:
+            emit receiveBufferHigh(event.size, event.capacity);
+            break;
+        case TelnetEvent::BufferLow:
+            emit receiveBufferLow(event.size);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+
+
+TclRpcTransport::TclRpcTransport(QObject *parent) : OcdTransport(parent), skip(0), limit(TclResultLimit),
+    dropping(false)
+{
+    socket = new QTcpSocket(this);
+    connect(socket, SIGNAL(connected()), this, SLOT(socketConnected()));
+    connect(socket, SIGNAL(disconnected()), this, SLOT(socketDisconnected()));
+    connect(socket, SIGNAL(readyRead()), this, SLOT(socketReadyRead()));
+    connect(socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(socketError()));
+}
+
+void TclRpcTransport::connectToHost(const QString &host, quint16 port)
+{
+    if (socket->state() != QAbstractSocket::UnconnectedState)
+        return;
+    received.clear();
+    dropping = false;
+    socket->connectToHost(host, port);
+}
+
+void TclRpcTransport::close()
+{
+    socket->abort();
+    abortAll();
+}
+
+bool TclRpcTransport::isConnected() const
+{
+    return socket->state() == QAbstractSocket::ConnectedState;
+}
+
+OcdReply *TclRpcTransport::execute(const QString &command)
+{
+    return execute(QStringList(command)).first();
+}
+
+QList<OcdReply *> TclRpcTransport::execute(const QStringList &commands) // one write for all
+{
+    QList<OcdReply *> batch;
+    if (!isConnected())
+    {
+        for (int i = 0; i < commands.size(); i++)
+            batch << abortedReply(commands.at(i));
+        return batch;
+    }
+
+    QByteArray data;
+    for (int i = 0; i < commands.size(); i++)
+    {
+        data += commands.at(i).toLocal8Bit();
+        data += TCL_TERMINATOR;
+        batch << new OcdReply(commands.at(i), this);
+        batch.last()->start();
+        replies.enqueue(batch.last());
+    }
+    socket->write(data);
+    return batch;
+}
+
+void TclRpcTransport::socketConnected()
+{
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    emit connected();
+}
+
+void TclRpcTransport::socketReadyRead() // results come back in the order of the commands
+{
+    int start = 0;
+    int end = received.size();	// what is left from before has no terminator
+    received += socket->readAll();
+
+    while ((end = received.indexOf(TCL_TERMINATOR, end)) != -1)
+    {
+        QByteArray result = received.mid(start, end - start);
+        start = ++end;
+
+        if (dropping)
+        {
+            dropping = false;	// its reply failed already
+            continue;
+        }
+        if (skip > 0)
+        {
+            skip--;		// of an aborted command
+            continue;
+        }
+        emit output(result.endsWith('\n') ? result : result + '\n');
+        if (replies.isEmpty())
+            continue;	// not asked for
+        QPointer<OcdReply> reply = replies.dequeue();
+        if (reply)
+            reply->finish(QString::fromLocal8Bit(result), false);
+    }
+    received.remove(0, start);	// once per read, not per result
+
+    if (received.size() > limit && !dropping)
+    {
+        dropping = true;
+        if (skip > 0)
+            skip--;
+        else if (!replies.isEmpty())
+        {
+            QPointer<OcdReply> reply = replies.dequeue();
+            if (reply)
+                reply->finish(QString("Error: result over %1 bytes dropped").arg(limit), false);
+        }
+    }
+    if (dropping)
+        received.clear();
+}
+
+void TclRpcTransport::abort() // no interrupt over Tcl RPC, just stop waiting
+{
+    int pending = replies.size();
+    abortAll();
+    skip += pending;
+}
+
+void TclRpcTransport::socketDisconnected()
+{
+    abortAll();
+    emit disconnected();
+}
+
+void TclRpcTransport::socketError()
+{
+    emit error(socket->errorString());
+}
+
+void TclRpcTransport::abortAll()
+{
+    skip = 0;
+    while (!replies.isEmpty())
+    {
+        QPointer<OcdReply> reply = replies.dequeue();
+        if (reply)
+            reply->finish(QString(), true);
+    }
+}
@@ -0,0 +1,231 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OCDTRANSPORT_H
+#define OCDTRANSPORT_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QQueue>
+#include <QHash>
+#include <QPointer>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QSemaphore>
+#include "spscqueue.h"
+
+class QTcpSocket;
+class QtTelnet;
+class QtTelnetReply;
+
+// Result of one command sent through an OcdTransport. Owned by the
+// transport, delete it with deleteLater() after finished().
+class OcdReply : public QObject
+{
+    Q_OBJECT
+
+public:
+    OcdReply(const QString &command, QObject *parent = 0);
+
+    QString command() const { return cmd; }
+    QString response() const { return resp; }
+    bool isFinished() const { return done; }
+    bool isAborted() const { return aborted; }
+    bool failed() const { return aborted || !errorLine(resp).isNull(); }
+    qint64 latency() const { return usecs; }	// microseconds, -1 if never sent
+
+    static QString errorLine(const QString &response);
+
+public slots:
+    void start();
+    void finish(const QString &response, bool abort, qint64 latency = -1);
+    void abort();
+
+signals:
+    void finished();
+
+private:
+    QString cmd;
+    QString resp;
+    bool done;
+    bool aborted;
+    QElapsedTimer timer;
+    qint64 usecs;
+};
+
+// A way of running commands on the openOCD server.
+class OcdTransport : public QObject
+{
+    Q_OBJECT
+
+public:
+    OcdTransport(QObject *parent = 0) : QObject(parent) {}
+
+    virtual void connectToHost(const QString &host, quint16 port) = 0;
+    virtual void close() = 0;
+    virtual bool isConnected() const = 0;
+    virtual OcdReply *execute(const QString &command) = 0;
+    virtual QList<OcdReply *> execute(const QStringList &commands);
+    virtual void abort() = 0;	// give up on everything pending
+
+signals:
+    void connected();
+    void disconnected();
+    void error(const QString &message);
+    void output(const QByteArray &data);	// as received, for the log
+
+protected:
+    OcdReply *abortedReply(const QString &command);
+};
+
+// Something that happened on the network thread, for the GUI thread.
+struct TelnetEvent
+{
+    enum Type { None, Connected, Disconnected, Error, Output, Finished, BufferHigh, BufferLow };
+
+    TelnetEvent(Type type = None) : type(type), id(0), aborted(false), latency(-1), size(0), capacity(0) {}
+
+    Type type;
+    int id;		// of the reply
+    bool aborted;
+    qint64 latency;
+    int size;		// receive buffer
+    int capacity;
+    QByteArray data;	// output between commands, whole lines
+    QString text;	// response or error message
+};
+
+// Owns the QtTelnet on the network thread and posts its events to the
+// GUI thread through a lock-free queue. Output of a command goes over as
+// the response of its Finished event, only output between commands is
+// posted on its own, in whole lines.
+class TelnetWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    TelnetWorker(QObject *receiver);
+
+    enum { EventSlots = 1024 };
+
+    SpscQueue<TelnetEvent, EventSlots> events;
+    QSemaphore space;		// free slots of events, released by the receiver
+    QAtomicInt wake;		// a drain() of the receiver is pending
+    QAtomicInt stopping;
+
+public slots:
+    void setup(const QString &prompt);
+    void shutdown();
+    void connectToHost(const QString &host, int port);
+    void close();
+    void sendData(const QString &data);
+    void execute(int id, const QString &command);
+    void executeBatch(int firstId, const QStringList &commands);
+    void abort();
+
+private slots:
+    void telnetConnected();
+    void telnetClosed();
+    void telnetError();
+    void telnetOutput(const QByteArray &data);
+    void telnetBufferHigh();
+    void telnetBufferLow();
+    void replyFinished();
+
+private:
+    void post(const TelnetEvent &event);
+
+    QObject *receiver;
+    QtTelnet *telnet;
+    QHash<QtTelnetReply *, int> ids;
+    QString prompt;
+    QByteArray between;	// output between commands, not a whole line yet
+};
+
+// Commands over the telnet port (4444), responses cut at the "> " prompt.
+// Socket, telnet parser and prompt matching run on a thread of their own,
+// so a busy GUI does not hold up the conversation with openOCD.
+class TelnetTransport : public OcdTransport
+{
+    Q_OBJECT
+
+public:
+    TelnetTransport(const QString &prompt = "> ", QObject *parent = 0);
+    ~TelnetTransport();
+
+    void connectToHost(const QString &host, quint16 port);
+    void close();
+    bool isConnected() const;
+    OcdReply *execute(const QString &command);
+    QList<OcdReply *> execute(const QStringList &commands);
+    void abort();
+    void sendData(const QString &data);
+
+signals:
+    void receiveBufferHigh(int size, int capacity);
+    void receiveBufferLow(int size);
+
+private slots:
+    void drain();
+
+private:
+    QThread thread;
+    TelnetWorker *worker;
+    QHash<int, QPointer<OcdReply> > pending;
+    QByteArray prompt;
+    int lastId;
+    bool open;
+};
+
+// Commands over the Tcl RPC port (6666): every command and every result
+// is terminated by 0x1a, without echo, prompt or terminal control codes.
+class TclRpcTransport : public OcdTransport
+{
+    Q_OBJECT
+
+public:
+    TclRpcTransport(QObject *parent = 0);
+
+    void connectToHost(const QString &host, quint16 port);
+    void close();
+    bool isConnected() const;
+    OcdReply *execute(const QString &command);
+    QList<OcdReply *> execute(const QStringList &commands);
+    void abort();
+    void setResultLimit(int bytes) { limit = bytes; }	// a longer result is dropped, its reply fails
+
+private slots:
+    void socketConnected();
+    void socketReadyRead();
+    void socketDisconnected();
+    void socketError();
+
+private:
+    void abortAll();
+
+    QTcpSocket *socket;
+    QQueue<QPointer<OcdReply> > replies;
+    QByteArray received;	// no terminator in it after a read
+    int skip;		// results of aborted commands still to come
+    int limit;
+    bool dropping;		// the rest of a result over the limit
+};
+
+#endif // OCDTRANSPORT_H
@@ -0,0 +1,52 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "outputrenderer.h"
+#include "logview.h"
+
+
+OutputRenderer::OutputRenderer(LogView *view, int maxFps, QObject *parent) : QObject(parent), view(view)
+{
+    setMaxFps(maxFps);
+    timer.setSingleShot(true);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(flush()));
+    lastFlush.start();
+}
+
+void OutputRenderer::setMaxFps(int fps)
+{
+    interval = 1000 / qMax(fps, 1);
+}
+
+void OutputRenderer::append(const QString &text) // one or more lines, like QTextEdit::append
+{
+    pending << text;
+    if (!timer.isActive())
+        timer.start(qMax(0, interval - int(lastFlush.elapsed())));
+}
+
+void OutputRenderer::flush()
+{
+    timer.stop();
+    if (pending.isEmpty())
+        return;
+
+    view->appendLines(pending);
+    pending.clear();
+    lastFlush.restart();
+}
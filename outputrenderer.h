@@ -0,0 +1,52 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OUTPUTRENDERER_H
+#define OUTPUTRENDERER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <QElapsedTimer>
+
+class LogView;
+
+// Collects text for a LogView and hands it over in one batch per frame,
+// at most maxFps times a second.
+class OutputRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    OutputRenderer(LogView *view, int maxFps = 20, QObject *parent = 0);
+
+    void setMaxFps(int fps);
+
+public slots:
+    void append(const QString &text);
+    void flush();
+
+private:
+    LogView *view;
+    QStringList pending;
+    QTimer timer;
+    QElapsedTimer lastFlush;
+    int interval;
+};
+
+#endif // OUTPUTRENDERER_H
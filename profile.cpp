@@ -0,0 +1,98 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "profile.h"
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+
+// for keys the profile does not set, those of the AT91SAM7 the GUI was made for
+static const char *const defaults[][2] = {
+    { "BASE", "0x00000000" },
+    { "FLASH", "0x00100000 0x00040000" },
+    { "RAM", "0x00200000 0x00010000" },
+    { "REMAP", "0xffffff00 0x00000001" },
+    { "RESETCPU", "0xfffffd00 0xa5000001" },
+    { "RESETPERIPH", "0xfffffd00 0xa5000004" },
+    { "FLASHPROBE", "flash probe 0" },
+    { "FLASHINFO", "flash info 0" },
+    { "FLASHERASE", "flash erase_address 0x100000 0x10000" },
+    { "FLASHUNLOCK", "flash protect 0 0 15 off" },
+    { "FLASHWRITE", "flash write_image" },
+    { "FLASHVERIFY", "verify_image" },
+    { "ERASESUFFIX", "erase" },
+    { "RAMWRITE", "load_image" },
+    { "RESET", "reset" },
+    { "HALT", "halt" },
+    { "RESUME", "resume" },
+    { "POLL", "poll" },
+    { "SOFTRESET", "soft_reset_halt" },
+    { "LOGLINES", "50000" },
+    { "FLASHSECTOR", "0x4000" }
+};
+
+
+bool Profile::load(const QString &fileName)
+{
+    QFile cfgFile(fileName);
+    if (!cfgFile.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+    values.clear();
+    QTextStream cfgIn(&cfgFile);
+    while (!cfgIn.atEnd())
+    {
+        QString buffer = cfgIn.readLine();
+        if (buffer.startsWith('#'))
+            continue;		// skip comments
+        int equal = buffer.indexOf(" = ");
+        if (equal <= 0)
+            continue;
+        values.insert(buffer.left(equal).trimmed(), buffer.mid(equal + 3).trimmed());
+    }
+    return true;
+}
+
+QString Profile::value(const QString &key, const QString &fallback) const // the whole value, e.g. a command
+{
+    if (values.contains(key))
+        return values.value(key);
+    QString builtIn = defaultValue(key);
+    return builtIn.isNull() ? fallback : builtIn;
+}
+
+QString Profile::field(const QString &key, int index, const QString &fallback) const // one word of the value
+{
+    QStringList fields = value(key).split(' ', QString::SkipEmptyParts);
+    return index < fields.size() ? fields.at(index) : fallback;
+}
+
+QString Profile::defaultValue(const QString &key) // null for keys without a default
+{
+    for (unsigned i = 0; i < sizeof(defaults) / sizeof(defaults[0]); i++)
+        if (key == defaults[i][0])
+            return defaults[i][1];
+    return QString();
+}
+
+bool Profile::range(const QString &key, quint32 *start, quint32 *length) const // "address size", like FLASH and RAM
+{
+    bool startOk, lengthOk;
+    *start = field(key, 0).toUInt(&startOk, 0);
+    *length = field(key, 1).toUInt(&lengthOk, 0);
+    return startOk && lengthOk && *length > 0;
+}
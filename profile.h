@@ -0,0 +1,45 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <QMap>
+#include <QString>
+
+// Target profile as stored in openocd-qtgui.conf: one "KEY = value" per
+// line, lines starting with '#' are comments. Shared by the GUI and the
+// batch mode, as are the defaults for keys the file does not set.
+class Profile
+{
+public:
+    bool load(const QString &fileName);
+
+    bool contains(const QString &key) const { return values.contains(key); }	// set by the file
+    void setValue(const QString &key, const QString &value) { values.insert(key, value); }
+    QString value(const QString &key, const QString &fallback = QString()) const;
+    QString field(const QString &key, int index, const QString &fallback = QString()) const;
+    bool range(const QString &key, quint32 *start, quint32 *length) const;
+
+    static QString defaultValue(const QString &key);
+
+private:
+    QMap<QString, QString> values;
+};
+
+#endif // PROFILE_H
@@ -0,0 +1,427 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snapshot.h"
+#include "memparse.h"
+#include "ocdtransport.h"
+#include <QFile>
+#include <QDir>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QLineEdit>
+#include <QLabel>
+#include <QPushButton>
+#include <QBoxLayout>
+#include <QStringList>
+#include <QRegExp>
+#include <QtAlgorithms>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static const quint32 SnapshotMagic = 0x4f4f534e;	// "OOSN"
+static const quint16 SnapshotVersion = 1;
+static const int MaxShownRuns = 1000;
+
+
+#ifdef __SSE2__
+static inline __m128i equalWords(const char *a, const char *b, int i)
+{
+    return _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)),
+                           _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+}
+#endif
+
+// offset of the first word at or after from that differs, size if none
+static int firstDifference(const char *a, const char *b, int from, int size)
+{
+    int i = from;
+#ifdef __SSE2__
+    for (; i + 64 <= size; i += 64)	// skip equal memory a cache line at a time
+    {
+        __m128i equal = _mm_and_si128(_mm_and_si128(equalWords(a, b, i), equalWords(a, b, i + 16)),
+                                      _mm_and_si128(equalWords(a, b, i + 32), equalWords(a, b, i + 48)));
+        if (_mm_movemask_epi8(equal) != 0xffff)
+            break;
+    }
+    for (; i + 16 <= size; i += 16)
+    {
+        int differ = _mm_movemask_epi8(equalWords(a, b, i)) ^ 0xffff;	// four bits per word
+        if (differ)
+        {
+            while (!(differ & 0xf))
+            {
+                differ >>= 4;
+                i += 4;
+            }
+            return i;
+        }
+    }
+#endif
+    for (; i + 4 <= size; i += 4)
+        if (memcmp(a + i, b + i, 4))
+            return i;
+    return size;
+}
+
+static bool olderFirst(const Snapshot &a, const Snapshot &b)
+{
+    return a.when < b.when;
+}
+
+
+Snapshot::Snapshot() : address(0), size(0)
+{
+}
+
+bool Snapshot::save(const QString &fileName) const
+{
+    QFile out(fileName);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    QDataStream stream(&out);
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream << SnapshotMagic << SnapshotVersion << name << address << size << when << qCompress(data);
+    return stream.status() == QDataStream::Ok;
+}
+
+bool Snapshot::load(const QString &fileName, bool withData) // the header only, unless withData
+{
+    QFile in(fileName);
+    if (!in.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream stream(&in);
+    stream.setVersion(QDataStream::Qt_4_6);
+    quint32 magic;
+    quint16 version;
+    stream >> magic >> version;
+    if (magic != SnapshotMagic || version != SnapshotVersion)
+        return false;
+    stream >> name >> address >> size >> when;
+    file = fileName;
+    data.clear();
+    if (withData)
+    {
+        QByteArray packed;
+        stream >> packed;
+        data = qUncompress(packed);
+        if (quint32(data.size()) != size)
+            return false;
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+QList<Snapshot::Run> Snapshot::diff(const Snapshot &before, const Snapshot &after, int maxRuns) // over the range both cover
+{
+    QList<Run> runs;
+    qint64 first = qMax(before.address, after.address);
+    qint64 end = qMin(qint64(before.address) + before.data.size(), qint64(after.address) + after.data.size());
+    if (end <= first)
+        return runs;
+
+    const char *a = before.data.constData() + (first - before.address);
+    const char *b = after.data.constData() + (first - after.address);
+    int size = int(end - first) & ~3;
+    int i = 0;
+    while (runs.size() < maxRuns)
+    {
+        i = firstDifference(a, b, i, size);
+        if (i >= size)
+            break;
+        int j = i + 4;
+        while (j + 4 <= size && memcmp(a + j, b + j, 4))
+            j += 4;
+        Run run = { quint32(first + i), (j - i) / 4 };
+        runs << run;
+        i = j;
+    }
+    return runs;
+}
+
+
+
+SnapshotView::SnapshotView(QWidget *parent) : QWidget(parent), captureFailed(false)
+{
+    name = new QLineEdit(this);
+    name->setToolTip("name of the next snapshot, the time if empty");
+    start = new QLineEdit("0x00200000", this);
+    start->setToolTip("first address");
+    length = new QLineEdit("0x00010000", this);
+    length->setToolTip("bytes to capture");
+    buttonCapture = new QPushButton("Capture", this);
+    buttonRemove = new QPushButton("Remove", this);
+    buttonDiff = new QPushButton("Diff", this);
+    buttonDiff->setToolTip("compare the two selected snapshots, the older one first");
+
+    list = new QTableWidget(0, 3, this);
+    list->setHorizontalHeaderLabels(QStringList() << "Name" << "Range" << "Taken");
+    list->setSelectionBehavior(QAbstractItemView::SelectRows);
+    list->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    list->horizontalHeader()->setStretchLastSection(true);
+    changes = new QTableWidget(0, 4, this);
+    changes->setHorizontalHeaderLabels(QStringList() << "Address" << "Words" << "Before" << "After");
+    changes->setSelectionBehavior(QAbstractItemView::SelectRows);
+    changes->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    changes->horizontalHeader()->setStretchLastSection(true);
+    changes->setToolTip("double click to show the address in the memory tab");
+    status = new QLabel(this);
+
+    QHBoxLayout *buttons = new QHBoxLayout;
+    buttons->addWidget(new QLabel("Name:", this));
+    buttons->addWidget(name);
+    buttons->addWidget(start);
+    buttons->addWidget(length);
+    buttons->addWidget(buttonCapture);
+    buttons->addWidget(buttonRemove);
+    buttons->addWidget(buttonDiff);
+    QHBoxLayout *tables = new QHBoxLayout;
+    tables->addWidget(list);
+    tables->addWidget(changes);
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(buttons);
+    layout->addLayout(tables);
+    layout->addWidget(status);
+
+    connect(buttonCapture, SIGNAL(clicked()), this, SLOT(capture()));
+    connect(buttonRemove, SIGNAL(clicked()), this, SLOT(removeSnapshot()));
+    connect(buttonDiff, SIGNAL(clicked()), this, SLOT(diffSelected()));
+    connect(changes, SIGNAL(cellDoubleClicked(int, int)), this, SLOT(runActivated(int)));
+}
+
+void SnapshotView::setTransport(OcdTransport *transport)
+{
+    this->transport = transport;
+}
+
+void SnapshotView::setDirectory(const QString &path) // list the snapshots stored there
+{
+    directory = path;
+    QDir().mkpath(path);
+    QDir dir(path);
+
+    snapshots.clear();
+    list->setRowCount(0);
+    QStringList files = dir.entryList(QStringList("*.snap"), QDir::Files);
+    QList<Snapshot> found;
+    for (int i = 0; i < files.size(); i++)
+    {
+        Snapshot snapshot;
+        if (snapshot.load(dir.filePath(files.at(i)), false))
+            found << snapshot;
+    }
+    qSort(found.begin(), found.end(), olderFirst);
+    for (int i = 0; i < found.size(); i++)
+        addRow(found.at(i));
+    status->setText(QString("%1 snapshot(s) in %2").arg(snapshots.size()).arg(path));
+}
+
+void SnapshotView::setRange(const QString &start, const QString &length)
+{
+    this->start->setText(start);
+    this->length->setText(length);
+}
+
+
+
+// private Slots:
+void SnapshotView::capture() // read the range in chunks, all sent in one go
+{
+    if (!chunks.isEmpty())
+    {
+        status->setText("Capture already running");
+        return;
+    }
+    if (!transport || !transport->isConnected())
+    {
+        status->setText("Not connected");
+        return;
+    }
+    bool startOk, lengthOk;
+    quint32 address = start->text().toUInt(&startOk, 0);
+    quint32 bytes = length->text().toUInt(&lengthOk, 0) & ~3u;
+    if (!startOk || !lengthOk || bytes == 0 || (address & 3))
+    {
+        status->setText("Invalid range " + start->text() + " " + length->text());
+        return;
+    }
+
+    taking = Snapshot();
+    taking.name = name->text().trimmed();
+    taking.when = QDateTime::currentDateTime();
+    if (taking.name.isEmpty())
+        taking.name = taking.when.toString("yyyy-MM-dd hh:mm:ss");
+    taking.address = address;
+    taking.size = bytes;
+    taking.data = QByteArray(int(bytes), 0);
+    taking.file = directory + "/" + QString(taking.name).replace(QRegExp("[^A-Za-z0-9_.-]"), "_")
+                  + taking.when.toString("-yyyyMMdd-hhmmsszzz") + ".snap";
+    captureFailed = false;
+
+    QStringList commands;
+    QList<quint32> offsets;
+    for (quint32 offset = 0; offset < bytes; offset += 4 * ChunkWords)
+    {
+        commands << QString("mdw 0x%1 %2").arg(address + offset, 8, 16, QChar('0'))
+                    .arg(qMin<quint32>(ChunkWords, (bytes - offset) / 4));
+        offsets << offset;
+    }
+    QList<OcdReply *> replies = transport->execute(commands);
+    for (int i = 0; i < replies.size(); i++)
+    {
+        chunks.insert(replies.at(i), offsets.at(i));
+        connect(replies.at(i), SIGNAL(finished()), this, SLOT(chunkRead()));
+    }
+    buttonCapture->setEnabled(false);
+    status->setText(QString("Capturing %1 bytes at 0x%2").arg(bytes).arg(address, 8, 16, QChar('0')));
+}
+
+void SnapshotView::removeSnapshot()
+{
+    int row = list->currentRow();
+    if (row < 0 || row >= snapshots.size())
+        return;
+    QFile::remove(snapshots.at(row).file);
+    snapshots.removeAt(row);
+    list->removeRow(row);
+}
+
+void SnapshotView::diffSelected()
+{
+    QList<int> rows;
+    QList<QTableWidgetItem *> selected = list->selectedItems();
+    for (int i = 0; i < selected.size(); i++)
+        if (!rows.contains(selected.at(i)->row()))
+            rows << selected.at(i)->row();
+    if (rows.size() != 2)
+    {
+        status->setText("Select two snapshots to compare");
+        return;
+    }
+    qSort(rows);	// the table is sorted by time
+    for (int i = 0; i < 2; i++)
+    {
+        Snapshot &snapshot = snapshots[rows.at(i)];
+        if (snapshot.data.isEmpty() && !snapshot.load(snapshot.file))
+        {
+            status->setText("Can not read " + snapshot.file);
+            return;
+        }
+    }
+
+    const Snapshot &before = snapshots.at(rows.at(0));
+    const Snapshot &after = snapshots.at(rows.at(1));
+    QElapsedTimer timer;
+    timer.start();
+    runs = Snapshot::diff(before, after);
+    qint64 usecs = timer.nsecsElapsed() / 1000;
+
+    int words = 0;
+    changes->setRowCount(qMin(runs.size(), MaxShownRuns));
+    for (int i = 0; i < runs.size(); i++)
+    {
+        words += runs.at(i).words;
+        if (i >= MaxShownRuns)
+            continue;
+        quint32 address = runs.at(i).address;
+        quint32 old, now;
+        memcpy(&old, before.data.constData() + (address - before.address), 4);
+        memcpy(&now, after.data.constData() + (address - after.address), 4);
+        changes->setItem(i, 0, new QTableWidgetItem(QString("0x%1").arg(address, 8, 16, QChar('0'))));
+        changes->setItem(i, 1, new QTableWidgetItem(QString::number(runs.at(i).words)));
+        changes->setItem(i, 2, new QTableWidgetItem(QString("0x%1").arg(old, 8, 16, QChar('0'))));
+        changes->setItem(i, 3, new QTableWidgetItem(QString("0x%1").arg(now, 8, 16, QChar('0'))));
+    }
+    status->setText(QString("'%1' to '%2': %3 changed word(s) in %4 run(s)%5, %6 KiB compared in %7 ms")
+                    .arg(before.name).arg(after.name).arg(words).arg(runs.size())
+                    .arg(runs.size() > MaxShownRuns ? QString(", first %1 shown").arg(MaxShownRuns) : QString())
+                    .arg(qMin(before.size, after.size) / 1024).arg(usecs / 1000.0, 0, 'f', 2));
+}
+
+void SnapshotView::chunkRead()
+{
+    OcdReply *reply = qobject_cast<OcdReply *>(sender());
+    if (!reply)
+        return;
+    reply->deleteLater();
+    if (!chunks.contains(reply))
+        return;
+    quint32 offset = chunks.take(reply);
+
+    int bytes = int(qMin<quint32>(4 * ChunkWords, taking.size - offset));
+    QByteArray data;
+    if (!reply->isAborted())
+        data = MemoryParser::dump(reply->response(), taking.address + offset, 4, bytes);
+    if (data.isEmpty())
+    {
+        if (!captureFailed)
+            status->setText(QString("Can not read 0x%1").arg(taking.address + offset, 8, 16, QChar('0')));
+        captureFailed = true;
+    }
+    else
+    {
+        memcpy(taking.data.data() + offset, data.constData(), bytes);
+    }
+    if (chunks.isEmpty())
+        finishCapture();
+}
+
+void SnapshotView::runActivated(int row)
+{
+    if (row >= 0 && row < runs.size())
+        emit jumpRequested(runs.at(row).address);
+}
+
+
+
+// private Funktions:
+void SnapshotView::addRow(const Snapshot &snapshot)
+{
+    int row = list->rowCount();
+    snapshots << snapshot;
+    list->insertRow(row);
+    list->setItem(row, 0, new QTableWidgetItem(snapshot.name));
+    list->setItem(row, 1, new QTableWidgetItem(QString("0x%1 +0x%2").arg(snapshot.address, 8, 16, QChar('0'))
+                                               .arg(snapshot.size, 0, 16)));
+    list->setItem(row, 2, new QTableWidgetItem(snapshot.when.toString("yyyy-MM-dd hh:mm:ss")));
+    list->item(row, 0)->setToolTip(snapshot.file);
+}
+
+void SnapshotView::finishCapture()
+{
+    buttonCapture->setEnabled(true);
+    if (captureFailed)
+    {
+        taking = Snapshot();
+        return;
+    }
+    if (!taking.save(taking.file))
+    {
+        status->setText("Can not write " + taking.file);
+        taking = Snapshot();
+        return;
+    }
+    addRow(taking);
+    status->setText(QString("Captured '%1', %2 bytes, %3 bytes on disk").arg(taking.name).arg(taking.size)
+                    .arg(QFile(taking.file).size()));
+    taking = Snapshot();
+    name->clear();
+}
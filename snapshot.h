@@ -0,0 +1,110 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <QWidget>
+#include <QDateTime>
+#include <QByteArray>
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QPointer>
+
+class OcdTransport;
+class OcdReply;
+class QTableWidget;
+class QLineEdit;
+class QLabel;
+class QPushButton;
+
+// Contents of a range of target memory at one point in time. On disk a
+// small header is followed by the compressed data, so a mostly empty SRAM
+// costs next to nothing.
+struct Snapshot
+{
+    struct Run		// neighbouring words that differ
+    {
+        quint32 address;
+        int words;
+    };
+
+    Snapshot();
+
+    bool save(const QString &fileName) const;
+    bool load(const QString &fileName, bool withData = true);
+    static QList<Run> diff(const Snapshot &before, const Snapshot &after, int maxRuns = 100000);
+
+    QString name;
+    quint32 address;
+    quint32 size;
+    QDateTime when;
+    QByteArray data;		// empty until loaded
+    QString file;
+};
+
+// Snapshots tab: capture named snapshots of a range, diff two of them and
+// jump to the changed words in the memory view.
+class SnapshotView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    SnapshotView(QWidget *parent = 0);
+
+    void setTransport(OcdTransport *transport);
+    void setDirectory(const QString &path);
+    void setRange(const QString &start, const QString &length);
+
+signals:
+    void jumpRequested(quint32 address);
+
+private slots:
+    void capture();
+    void removeSnapshot();
+    void diffSelected();
+    void chunkRead();
+    void runActivated(int row);
+
+private:
+    enum { ChunkWords = 1024 };	// per mdw
+
+    void addRow(const Snapshot &snapshot);
+    void finishCapture();
+
+    QString directory;
+    QList<Snapshot> snapshots;	// headers only, as in the table
+    QPointer<OcdTransport> transport;
+    Snapshot taking;		// capture in progress
+    QHash<OcdReply *, quint32> chunks;	// offset of every read in flight
+    bool captureFailed;
+    QList<Snapshot::Run> runs;
+
+    QLineEdit *name;
+    QLineEdit *start;
+    QLineEdit *length;
+    QTableWidget *list;
+    QTableWidget *changes;
+    QLabel *status;
+    QPushButton *buttonCapture;
+    QPushButton *buttonRemove;
+    QPushButton *buttonDiff;
+};
+
+#endif // SNAPSHOT_H
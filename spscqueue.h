@@ -0,0 +1,67 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QAtomicInt>
+
+// Fixed size ring for handing items from exactly one producer thread to
+// exactly one consumer thread without locks. Size must be a power of two,
+// one slot stays free to tell a full ring from an empty one.
+template <typename T, int Size>
+class SpscQueue
+{
+    typedef char SizeMustBePowerOfTwo[(Size & (Size - 1)) == 0 ? 1 : -1];
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    bool push(const T &value)	// producer only, false if full
+    {
+        int t = tail.fetchAndAddRelaxed(0);
+        int next = (t + 1) & (Size - 1);
+        if (next == head.fetchAndAddAcquire(0))
+            return false;
+        items[t] = value;
+        tail.fetchAndStoreRelease(next);
+        return true;
+    }
+
+    bool pop(T *value)		// consumer only, false if empty
+    {
+        int h = head.fetchAndAddRelaxed(0);
+        if (h == tail.fetchAndAddAcquire(0))
+            return false;
+        *value = items[h];
+        items[h] = T();		// don't keep shared data alive in the ring
+        head.fetchAndStoreRelease((h + 1) & (Size - 1));
+        return true;
+    }
+
+private:
+    SpscQueue(const SpscQueue &);
+    SpscQueue &operator=(const SpscQueue &);
+
+    T items[Size];
+    QAtomicInt head;		// written by the consumer
+    char padding[64];		// keep the indices on separate cache lines
+    QAtomicInt tail;		// written by the producer
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,470 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "station.h"
+#include "ocdtransport.h"
+#include <QTimer>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QProgressBar>
+#include <QSpinBox>
+#include <QLabel>
+#include <QPushButton>
+#include <QBoxLayout>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QFile>
+
+static const quint16 FirstPort = 5000;	// ten ports for each target
+static const int ConnectRetries = 40;		// of 250 ms while openOCD comes up
+static const int KillTimeout = 2000;		// ms after SIGTERM
+
+
+StationTarget::StationTarget(const QString &config, quint16 firstPort, QObject *parent)
+    : QObject(parent), configFile(config), port(firstPort), program("/usr/bin/openocd"), retries(0), command(0),
+      bytesDone(0), bytesTotal(0), lastElapsed(0), current(Stopped)
+{
+    process = new QProcess(this);
+    process->setProcessChannelMode(QProcess::MergedChannels);
+    transport = new TclRpcTransport(this);
+    retry = new QTimer(this);
+    retry->setSingleShot(true);
+    retry->setInterval(250);
+    killTimer = new QTimer(this);
+    killTimer->setSingleShot(true);
+    killTimer->setInterval(KillTimeout);
+
+    connect(process, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(processFinished()));
+    connect(process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(processFinished()));
+    connect(process, SIGNAL(readyRead()), this, SLOT(processOutput()));
+    connect(retry, SIGNAL(timeout()), this, SLOT(connectTransport()));
+    connect(killTimer, SIGNAL(timeout()), process, SLOT(kill()));
+    connect(transport, SIGNAL(connected()), this, SLOT(transportConnected()));
+    connect(transport, SIGNAL(error(QString)), this, SLOT(transportError(QString)));
+}
+
+StationTarget::~StationTarget()
+{
+    process->disconnect(this);
+    transport->close();
+    if (process->state() != QProcess::NotRunning)
+        process->kill();	// the QProcess destructor reaps it
+}
+
+void StationTarget::start() // openOCD on the adapter of this target, with its own ports
+{
+    if (process->state() != QProcess::NotRunning)
+        return;
+    QStringList arguments;
+    arguments << "-f" << configFile
+              << "-c" << QString("telnet_port %1; gdb_port %2; tcl_port %3")
+                         .arg(telnetPort()).arg(gdbPort()).arg(tclPort());
+    retries = 0;
+    setState(Starting, "starting openOCD");
+    process->start(program, arguments);
+    retry->start();
+}
+
+void StationTarget::stop() // without waiting, Stopped once openOCD has exited
+{
+    if (current == Busy)
+        fail("stopped");
+    retry->stop();
+    transport->close();		// fails a running job
+    if (process->state() == QProcess::NotRunning)
+    {
+        setState(Stopped, "stopped");
+        return;
+    }
+    if (current == Stopping)
+        return;
+    setState(Stopping, "stopping openOCD");
+    process->terminate();
+    killTimer->start();		// kill it if it does not react
+}
+
+bool StationTarget::isReady() const
+{
+    return (current == Idle || current == Passed || current == Failed) && transport->isConnected();
+}
+
+void StationTarget::queue()
+{
+    setState(Queued, "waiting");
+}
+
+void StationTarget::run(const QStringList &list, const QList<qint64> &lengths)
+{
+    commands = list;
+    sizes = lengths;
+    bytesDone = 0;
+    bytesTotal = 0;
+    for (int i = 0; i < sizes.size(); i++)
+        bytesTotal += sizes.at(i);
+    timer.start();
+    setState(Busy, "flashing");
+    next();
+}
+
+qint64 StationTarget::elapsed() const
+{
+    return current == Busy ? timer.elapsed() : lastElapsed;
+}
+
+
+
+// private slots:
+void StationTarget::processFinished()
+{
+    if (process->state() != QProcess::NotRunning)
+        return;
+    killTimer->stop();
+    if (current == Stopping)
+        setState(Stopped, "stopped");
+    if (current == Stopped)
+        return;
+    retry->stop();
+    transport->close();
+    fail("openOCD exited: " + lastMessage);
+    setState(Stopped, lastMessage);
+}
+
+void StationTarget::processOutput() // keep the last line for the status column
+{
+    QStringList lines = QString::fromLocal8Bit(process->readAll()).split('\n', QString::SkipEmptyParts);
+    for (int i = lines.size() - 1; i >= 0; i--)
+    {
+        QString line = lines.at(i).trimmed();
+        if (!line.isEmpty())
+        {
+            lastMessage = line;
+            break;
+        }
+    }
+}
+
+void StationTarget::connectTransport()
+{
+    if (process->state() == QProcess::Running)
+        transport->connectToHost("localhost", tclPort());
+    else
+        retry->start();
+}
+
+void StationTarget::transportConnected()
+{
+    setState(Idle, "ready");
+}
+
+void StationTarget::transportError(const QString &text)
+{
+    if (current == Starting && ++retries < ConnectRetries)
+        retry->start();
+    else
+        fail(text);
+}
+
+void StationTarget::commandFinished()
+{
+    OcdReply *reply = qobject_cast<OcdReply *>(sender());
+    if (!reply || reply != command)
+        return;
+    command = 0;
+    reply->deleteLater();
+
+    if (reply->isAborted())
+    {
+        fail("'" + reply->command() + "' aborted");
+        return;
+    }
+    if (reply->failed())
+    {
+        fail(OcdReply::errorLine(reply->response()));
+        return;
+    }
+    if (!sizes.isEmpty())
+        bytesDone += sizes.takeFirst();
+    if (commands.isEmpty())
+    {
+        lastElapsed = timer.elapsed();
+        setState(Passed, QString("%1 bytes").arg(bytesTotal));
+        emit finished(true);
+        return;
+    }
+    emit changed();
+    next();
+}
+
+
+
+// private Funktions:
+void StationTarget::next()
+{
+    command = transport->execute(commands.takeFirst());
+    connect(command, SIGNAL(finished()), this, SLOT(commandFinished()));
+}
+
+void StationTarget::setState(State state, const QString &text)
+{
+    current = state;
+    if (!text.isEmpty())
+        lastMessage = text;
+    emit changed();
+}
+
+void StationTarget::fail(const QString &text)
+{
+    if (current != Busy)
+    {
+        if (current != Stopped && current != Stopping)
+            setState(Failed, text);
+        return;
+    }
+    lastElapsed = timer.elapsed();
+    commands.clear();
+    sizes.clear();
+    command = 0;
+    setState(Failed, text);
+    emit finished(false);
+}
+
+
+
+StationView::StationView(QWidget *parent) : QWidget(parent), running(0), passed(0), failed(0), bytes(0)
+{
+    table = new QTableWidget(0, 5, this);
+    table->setHorizontalHeaderLabels(QStringList() << "Adapter config" << "Ports" << "State" << "Progress" << "Time");
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->horizontalHeader()->setStretchLastSection(true);
+
+    buttonAdd = new QPushButton("Add...", this);
+    buttonRemove = new QPushButton("Remove", this);
+    buttonStart = new QPushButton("Start", this);
+    buttonStop = new QPushButton("Stop", this);
+    buttonFlash = new QPushButton("Flash all", this);
+    buttonFlash->setToolTip("load the FLASH image into every ready target");
+    parallel = new QSpinBox(this);
+    parallel->setRange(1, 32);
+    parallel->setValue(4);
+    parallel->setToolTip("targets flashed at the same time");
+    summary = new QLabel(this);
+
+    QHBoxLayout *buttons = new QHBoxLayout;
+    buttons->addWidget(buttonAdd);
+    buttons->addWidget(buttonRemove);
+    buttons->addWidget(buttonStart);
+    buttons->addWidget(buttonStop);
+    buttons->addStretch();
+    buttons->addWidget(new QLabel("Parallel:", this));
+    buttons->addWidget(parallel);
+    buttons->addWidget(buttonFlash);
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(buttons);
+    layout->addWidget(table);
+    layout->addWidget(summary);
+
+    connect(buttonAdd, SIGNAL(clicked()), this, SLOT(addTarget()));
+    connect(buttonRemove, SIGNAL(clicked()), this, SLOT(removeTarget()));
+    connect(buttonStart, SIGNAL(clicked()), this, SLOT(startAll()));
+    connect(buttonStop, SIGNAL(clicked()), this, SLOT(stopAll()));
+    connect(buttonFlash, SIGNAL(clicked()), this, SIGNAL(flashRequested()));
+    connect(parallel, SIGNAL(valueChanged(int)), this, SLOT(schedule()));
+    updateSummary();
+}
+
+StationView::~StationView()
+{
+    jobs.clear();
+    for (int i = 0; i < targets.size(); i++)
+        disconnect(targets.at(i), 0, this, 0);
+    qDeleteAll(targets);
+    removeFiles();
+}
+
+void StationView::flash(const QStringList &commands, const QList<qint64> &sizes, const QStringList &files) // one job per ready target
+{
+    if (running || !jobs.isEmpty())
+    {
+        summary->setText("Station busy, the previous jobs are still running");
+        for (int i = 0; i < files.size(); i++)
+            QFile::remove(files.at(i));
+        return;
+    }
+    removeFiles();
+    jobCommands = commands;
+    jobSizes = sizes;
+    jobFiles = files;
+    for (int i = 0; i < targets.size(); i++)
+    {
+        if (targets.at(i)->isReady())
+        {
+            targets.at(i)->queue();
+            jobs.enqueue(targets.at(i));
+        }
+    }
+    if (jobs.isEmpty())
+    {
+        summary->setText("No target ready, start the station first");
+        removeFiles();
+        return;
+    }
+    if (!clock.isValid())
+        clock.start();
+    schedule();
+}
+
+
+
+// private slots:
+void StationView::addTarget()
+{
+    QString config = QFileDialog::getOpenFileName(this, "Select Adapter Config", recentDir, "*.cfg");
+    if (config.isEmpty())
+        return;
+    recentDir = QFileInfo(config).absolutePath();
+
+    quint16 port = FirstPort;	// first block of ports no other target uses
+    for (int i = 0; i < targets.size(); i++)
+    {
+        if (targets.at(i)->telnetPort() == port)
+        {
+            port += 10;
+            i = -1;
+        }
+    }
+    StationTarget *target = new StationTarget(config, port, this);
+    connect(target, SIGNAL(changed()), this, SLOT(targetChanged()));
+    connect(target, SIGNAL(finished(bool)), this, SLOT(targetFinished(bool)));
+    targets << target;
+
+    int row = table->rowCount();
+    table->insertRow(row);
+    for (int column = 0; column < table->columnCount(); column++)
+        if (column != 3)
+            table->setItem(row, column, new QTableWidgetItem);
+    QProgressBar *bar = new QProgressBar(table);
+    bar->setRange(0, 100);
+    bar->setValue(0);
+    table->setCellWidget(row, 3, bar);
+    updateRow(row);
+}
+
+void StationView::removeTarget()
+{
+    int row = table->currentRow();
+    if (row < 0 || row >= targets.size())
+        return;
+    StationTarget *target = targets.takeAt(row);
+    jobs.removeAll(target);
+    target->stop();
+    target->deleteLater();
+    table->removeRow(row);
+}
+
+void StationView::startAll()
+{
+    for (int i = 0; i < targets.size(); i++)
+        targets.at(i)->start();
+}
+
+void StationView::stopAll()
+{
+    jobs.clear();
+    for (int i = 0; i < targets.size(); i++)
+        targets.at(i)->stop();
+    removeFiles();
+}
+
+void StationView::targetChanged()
+{
+    int row = targets.indexOf(qobject_cast<StationTarget *>(sender()));
+    if (row != -1)
+        updateRow(row);
+}
+
+void StationView::targetFinished(bool ok)
+{
+    StationTarget *target = qobject_cast<StationTarget *>(sender());
+    running--;
+    if (ok)
+    {
+        passed++;
+        if (target)
+            bytes += target->done();
+    }
+    else
+        failed++;
+    schedule();
+    if (!running && jobs.isEmpty())
+        removeFiles();
+    updateSummary();
+}
+
+void StationView::schedule()
+{
+    while (running < parallel->value() && !jobs.isEmpty())
+    {
+        StationTarget *target = jobs.dequeue();
+        if (target->state() != StationTarget::Queued || !target->isReady())
+            continue;		// stopped or lost while waiting
+        running++;
+        target->run(jobCommands, jobSizes);
+    }
+    updateSummary();
+}
+
+
+
+// private Funktions:
+void StationView::updateRow(int row)
+{
+    static const char *const states[] = { "Stopped", "Stopping", "Starting", "Idle", "Queued", "Busy", "Passed", "Failed" };
+    StationTarget *target = targets.at(row);
+
+    table->item(row, 0)->setText(QFileInfo(target->config()).fileName());
+    table->item(row, 0)->setToolTip(target->config());
+    table->item(row, 1)->setText(QString("%1/%2/%3").arg(target->telnetPort())
+                                 .arg(target->gdbPort()).arg(target->tclPort()));
+    table->item(row, 2)->setText(QString(states[target->state()]) + ": " + target->message());
+    table->item(row, 4)->setText(QString("%1 s").arg(target->elapsed() / 1000.0, 0, 'f', 1));
+    QProgressBar *bar = qobject_cast<QProgressBar *>(table->cellWidget(row, 3));
+    if (bar)
+        bar->setValue(target->total() ? int(target->done() * 100 / target->total()) : 0);
+}
+
+void StationView::updateSummary()
+{
+    if (!clock.isValid())
+    {
+        summary->setText(QString("%1 target(s)").arg(targets.size()));
+        return;
+    }
+    double seconds = qMax<qint64>(clock.elapsed(), 1) / 1000.0;
+    summary->setText(QString("Running %1, passed %2, failed %3 - %4 boards/h, %5 KiB/s")
+                     .arg(running).arg(passed).arg(failed)
+                     .arg(passed * 3600.0 / seconds, 0, 'f', 1)
+                     .arg(bytes / 1024.0 / seconds, 0, 'f', 1));
+}
+
+void StationView::removeFiles() // slices of the image the jobs were using
+{
+    for (int i = 0; i < jobFiles.size(); i++)
+        QFile::remove(jobFiles.at(i));
+    jobFiles.clear();
+}
@@ -0,0 +1,153 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STATION_H
+#define STATION_H
+
+#include <QWidget>
+#include <QProcess>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QList>
+#include <QQueue>
+
+class OcdTransport;
+class OcdReply;
+class QTimer;
+class QTableWidget;
+class QSpinBox;
+class QLabel;
+class QPushButton;
+
+// One position of the flashing station: an openOCD instance with its own
+// adapter config and ports, and the job currently running on its board.
+class StationTarget : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum State { Stopped, Stopping, Starting, Idle, Queued, Busy, Passed, Failed };
+
+    StationTarget(const QString &config, quint16 firstPort, QObject *parent = 0);
+    ~StationTarget();
+
+    void setProgram(const QString &path) { program = path; }
+    void start();
+    void stop();
+    bool isReady() const;
+    void queue();
+    void run(const QStringList &commands, const QList<qint64> &sizes);
+
+    State state() const { return current; }
+    QString config() const { return configFile; }
+    quint16 telnetPort() const { return port; }
+    quint16 gdbPort() const { return port + 1; }
+    quint16 tclPort() const { return port + 2; }
+    qint64 done() const { return bytesDone; }
+    qint64 total() const { return bytesTotal; }
+    qint64 elapsed() const;
+    QString message() const { return lastMessage; }
+
+signals:
+    void changed();
+    void finished(bool passed);
+
+private slots:
+    void processFinished();
+    void processOutput();
+    void connectTransport();
+    void transportConnected();
+    void transportError(const QString &text);
+    void commandFinished();
+
+private:
+    void next();
+    void setState(State state, const QString &text = QString());
+    void fail(const QString &text);
+
+    QString configFile;
+    quint16 port;
+    QString program;
+    QProcess *process;
+    OcdTransport *transport;
+    QTimer *retry;
+    QTimer *killTimer;
+    int retries;
+    OcdReply *command;
+    QStringList commands;
+    QList<qint64> sizes;
+    qint64 bytesDone;
+    qint64 bytesTotal;
+    QElapsedTimer timer;
+    qint64 lastElapsed;
+    State current;
+    QString lastMessage;
+};
+
+// Station tab: several targets flashed at once, at most "parallel" jobs
+// running at a time, with progress, pass/fail and the throughput.
+class StationView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    StationView(QWidget *parent = 0);
+    ~StationView();
+
+    void flash(const QStringList &commands, const QList<qint64> &sizes, const QStringList &files);
+
+signals:
+    void flashRequested();
+
+private slots:
+    void addTarget();
+    void removeTarget();
+    void startAll();
+    void stopAll();
+    void targetChanged();
+    void targetFinished(bool passed);
+    void schedule();
+
+private:
+    void updateRow(int row);
+    void updateSummary();
+    void removeFiles();
+
+    QList<StationTarget *> targets;
+    QQueue<StationTarget *> jobs;
+    QStringList jobCommands;
+    QList<qint64> jobSizes;
+    QStringList jobFiles;
+    int running;
+    int passed;
+    int failed;
+    qint64 bytes;
+    QElapsedTimer clock;		// since the first job of the session
+    QString recentDir;
+
+    QTableWidget *table;
+    QSpinBox *parallel;
+    QLabel *summary;
+    QPushButton *buttonAdd;
+    QPushButton *buttonRemove;
+    QPushButton *buttonStart;
+    QPushButton *buttonStop;
+    QPushButton *buttonFlash;
+};
+
+#endif // STATION_H
@@ -0,0 +1,575 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "targetflow.h"
+#include "ocdtransport.h"
+#include "gdbremote.h"
+#include "flashimage.h"
+#include <QFile>
+#include <QDir>
+#include <QDateTime>
+
+// steps of the command buttons and of the batch mode, with the profile key of their command
+static const char *const stepKeys[][2] = {
+    { "halt", "HALT" },
+    { "softreset", "SOFTRESET" },
+    { "reset", "RESET" },
+    { "resume", "RESUME" },
+    { "poll", "POLL" },
+    { "probe", "FLASHPROBE" },
+    { "info", "FLASHINFO" },
+    { "unlock", "FLASHUNLOCK" },
+    { "erase", "FLASHERASE" },
+    { "remap", "REMAP" },
+    { "resetcpu", "RESETCPU" },
+    { "resetperiph", "RESETPERIPH" }
+};
+
+static bool memoryRange(const Profile &profile, TargetFlow::Load what, quint32 *start, quint32 *length, QString *why)
+{
+    QString memory = (what == TargetFlow::Ram) ? "RAM" : "FLASH";
+    if (profile.range(memory, start, length))
+        return true;
+    *why = "Invalid " + memory + " range " + profile.value(memory);
+    return false;
+}
+
+
+TargetFlow::TargetFlow(GdbRemote *gdb, QObject *parent)
+    : QObject(parent), transport(0), gdb(gdb), gdbPort(0), eraseFirst(false), deltaMode(false), job(Flash),
+      loading(false), command(0), failed(false), transferDone(0), transferTotal(0), recording(false),
+      gdbLoading(false), deltaBase(0), deltaSector(0), deltaWritten(0), deltaVerifyMs(0),
+      deltaWriting(false), deltaFailed(false)
+{
+    image = new FlashImage;
+    connect(gdb, SIGNAL(connected()), this, SLOT(gdbConnected()));
+    connect(gdb, SIGNAL(error(QString)), this, SLOT(gdbError(QString)));
+    connect(gdb, SIGNAL(progress(qint64,qint64)), this, SLOT(gdbProgress(qint64,qint64)));
+    connect(gdb, SIGNAL(monitorFinished(QString)), this, SLOT(gdbHalted()));
+    connect(gdb, SIGNAL(memoryWritten(quint32,qint64)), this, SLOT(gdbWritten(quint32,qint64)));
+    connect(gdb, SIGNAL(cancelled(quint32,qint64)), this, SLOT(gdbCancelled(quint32,qint64)));
+}
+
+TargetFlow::~TargetFlow()
+{
+    removeSlices();
+    delete image;
+}
+
+void TargetFlow::setTransport(OcdTransport *transport)
+{
+    this->transport = transport;
+}
+
+void TargetFlow::setGdbPort(const QString &host, quint16 port)
+{
+    gdbHost = host;
+    gdbPort = port;
+}
+
+QStringList TargetFlow::stepCommands(const QString &step) const // the commands of a button, from the profile
+{
+    for (unsigned i = 0; i < sizeof(stepKeys) / sizeof(stepKeys[0]); i++)
+    {
+        if (step != stepKeys[i][0])
+            continue;
+        QString key = stepKeys[i][1];
+        if (key == "REMAP" || key == "RESETCPU" || key == "RESETPERIPH")	// address and value to write
+            return QStringList("mww " + settings.field(key, 0) + " " + settings.field(key, 1));
+        if (key == "FLASHERASE")
+            return QStringList(settings.value("SOFTRESET")) << settings.value(key);	// halted first
+        return QStringList(settings.value(key));
+    }
+    return QStringList();
+}
+
+bool TargetFlow::runStep(const QString &step)
+{
+    QStringList commands = stepCommands(step);
+    if (commands.isEmpty())
+        return fail("Unknown step " + step);
+    run(commands);
+    return true;
+}
+
+void TargetFlow::run(const QStringList &commands) // one after the other, stop on error
+{
+    if (!isBusy())
+        failed = false;
+    queue << commands;
+    if (!command)
+        next();
+}
+
+bool TargetFlow::load(Load what, const QString &fileName) // the image into RAM or FLASH, or verify it against FLASH
+{
+    if (loading)
+        return fail("A load is already running");
+    if (!openImage(what, fileName))
+        return false;
+    if (!isBusy())
+        failed = false;
+    job = what;
+    loadFile = image->fileName();
+
+    if (what == Ram && gdbPort)
+    {
+        loadOverGdb();
+        return true;
+    }
+    if (what == Flash && deltaMode)
+    {
+        if (image->format() == FlashImage::Binary)
+            return flashDelta(image->segments().first().address);
+        emit message("Delta flashing needs a binary image, writing all segments");
+    }
+
+    QString write = settings.value("FLASHVERIFY") + " ";
+    if (what == Ram)
+        write = settings.value("RAMWRITE") + " ";
+    else if (what == Flash)
+        write = settings.value("FLASHWRITE") + (eraseFirst ? " " + settings.value("ERASESUFFIX") + " " : " ");
+    QList<qint64> sizes;
+    QStringList files;
+    QStringList commands = image->transferCommands(write, &sizes, &files);
+    sliceFiles << files;
+    qint64 total = image->totalSize();
+    image->close();
+    if (commands.isEmpty())
+    {
+        if (!isBusy())
+            removeSlices();
+        return fail("Can not write an image slice to " + QDir::tempPath());
+    }
+    if (what != Verify)
+    {
+        commands.prepend(settings.value("SOFTRESET"));	// halted while it is written
+        sizes.prepend(0);
+        startRecord(total);
+    }
+    for (int i = 0; i < commands.size(); i++)
+        if (sizes.at(i))
+            transferSizes.insert(commands.at(i), sizes.at(i));
+    loading = true;
+    run(commands);
+    return true;
+}
+
+bool TargetFlow::loadCommands(const QString &fileName, QStringList *commands, QList<qint64> *sizes, QStringList *files) // a FLASH load for others to run, like the station
+{
+    if (!openImage(Flash, fileName))
+        return false;
+    *commands = image->transferCommands(settings.value("FLASHWRITE") + (eraseFirst ? " " + settings.value("ERASESUFFIX") + " " : " "),
+                                        sizes, files);
+    image->close();
+    if (commands->isEmpty())
+    {
+        for (int i = 0; i < files->size(); i++)
+            QFile::remove(files->at(i));
+        files->clear();
+        sizes->clear();
+        return fail("Can not write an image slice to " + QDir::tempPath());
+    }
+    commands->prepend(settings.value("SOFTRESET"));
+    sizes->prepend(0);
+    return true;
+}
+
+void TargetFlow::abort() // drop what is queued, the transport gives up on what was sent
+{
+    queue.clear();
+    if (transport)
+        transport->abort();
+    if (gdbLoading)
+        gdb->cancel();
+}
+
+bool TargetFlow::isBusy() const
+{
+    return command || !queue.isEmpty() || loading;
+}
+
+bool TargetFlow::checkImage(const Profile &profile, Load what, const QString &fileName, qint64 *bytes, QString *why) // before anything is sent
+{
+    quint32 start, length;
+    if (!memoryRange(profile, what, &start, &length, why))
+        return false;
+    FlashImage image;
+    if (!image.openIn(fileName, start, length))
+    {
+        *why = QString(what == Ram ? "RAM" : "FLASH") + ": " + image.errorString();
+        return false;
+    }
+    *bytes = image.totalSize();
+    return true;
+}
+
+
+
+// private slots:
+void TargetFlow::stepFinished() // openOCD answered, go on with the next command
+{
+    OcdReply *reply = qobject_cast<OcdReply *>(sender());
+    if (!reply || reply != command)
+        return;
+    command = 0;
+    reply->deleteLater();
+    emit commandFinished(reply);
+
+    if (!reply->isAborted())
+    {
+        if (recording)
+            loadRun.account(reply->command(), reply->response(), reply->latency());
+        if (transferSizes.contains(reply->command()))
+        {
+            transferDone += transferSizes.take(reply->command());
+            emit progress(transferDone, transferTotal);
+        }
+    }
+    if (reply->failed())
+    {
+        failed = true;
+        if (recording)
+            loadRun.ok = false;
+        deltaFailed = deltaWriting;
+        if (!queue.isEmpty())
+            emit message(QString("Skipping %1 remaining command(s)").arg(queue.size()));
+        queue.clear();
+    }
+
+    next();
+    if (command)
+        return;
+    if (deltaWriting)
+        deltaFinished();
+    else if (!loading)
+        emit finished(!failed);
+    else if (!gdbLoading && deltaChecks.isEmpty())
+        finishLoad(!failed);
+}
+
+void TargetFlow::deltaHalted() // the soft_reset_halt ahead of the sector checksums
+{
+    OcdReply *reply = qobject_cast<OcdReply *>(sender());
+    if (!reply)
+        return;
+    reply->deleteLater();
+    emit commandFinished(reply);
+    if (reply->failed())
+    {
+        emit message("'" + reply->command() + "' failed, target not halted");
+        deltaFailed = true;	// the checksums still run, nothing is written
+    }
+}
+
+void TargetFlow::deltaChecked() // on-target checksum of one sector arrived
+{
+    OcdReply *reply = qobject_cast<OcdReply *>(sender());
+    if (!reply || !deltaChecks.contains(reply))
+        return;
+    int sector = deltaChecks.take(reply);
+    reply->deleteLater();
+    emit commandFinished(reply);
+    QString response = reply->response();
+    deltaChanged[sector] = !response.contains("verified");
+    if (reply->isAborted())
+        deltaFailed = true;
+    else if (deltaChanged.at(sector) && !response.contains("mismatch") && !deltaFailed)
+    {
+        // neither verified nor a checksum mismatch: an error, no answer about the sector
+        emit message(QString("Checksum of sector %1 failed: %2").arg(sector).arg(response.trimmed()));
+        deltaFailed = true;
+    }
+    if (!deltaChecks.isEmpty())
+        return;
+
+    deltaVerifyMs = deltaTimer.elapsed();
+    if (deltaFailed)
+    {
+        emit message("Delta flash aborted");
+        deltaFinished();
+        return;
+    }
+
+    QStringList commands;	// coalesce neighbouring sectors into one write
+    QList<qint64> sizes;
+    int changed = 0;
+    deltaWritten = 0;
+    for (int i = 0; i < deltaChanged.size(); )
+    {
+        if (!deltaChanged.at(i))
+        {
+            i++;
+            continue;
+        }
+        int count = 1;
+        while (i + count < deltaChanged.size() && deltaChanged.at(i + count))
+            count++;
+        QString slice = writeSlice(deltaImage.mid(i * deltaSector, count * deltaSector), deltaBase + i * deltaSector);
+        if (slice.isEmpty())
+        {
+            emit message(lastError);
+            deltaFailed = true;
+            deltaFinished();
+            return;
+        }
+        commands << settings.value("FLASHWRITE") + " " + settings.value("ERASESUFFIX") + " "	// the sectors still hold the old image
+                    + slice + QString(" 0x%1 bin").arg(deltaBase + i * deltaSector, 8, 16, QChar('0'));
+        sizes << qMin(count * deltaSector, deltaImage.size() - i * deltaSector);
+        deltaWritten += sizes.last();
+        changed += count;
+        i += count;
+    }
+    emit message(QString("%1 of %2 sector(s) differ on target, checked in %3 ms")
+                 .arg(changed).arg(deltaChanged.size()).arg(deltaVerifyMs));
+    if (commands.isEmpty())
+    {
+        emit message(QString("Delta flash skipped all %1 bytes, image already on target")
+                     .arg(deltaImage.size()));
+        deltaFinished();
+        return;
+    }
+    transferDone = 0;
+    transferTotal = deltaWritten;
+    for (int i = 0; i < commands.size(); i++)
+        transferSizes.insert(commands.at(i), sizes.at(i));
+    deltaWriting = true;
+    startRecord(deltaWritten);
+    loadRun.verifyMs = deltaVerifyMs;
+    deltaTimer.start();
+    run(commands);
+}
+
+void TargetFlow::gdbConnected()
+{
+    if (gdbLoading)
+        gdbTimer.start();	// the download starts now, not with the connect
+}
+
+void TargetFlow::gdbError(const QString &text)
+{
+    Q_UNUSED(text);		// shown by the owner of the connection
+    if (!gdbLoading)
+        return;
+    gdbLoading = false;
+    gdb->close();
+    finishLoad(false);
+}
+
+void TargetFlow::gdbHalted() // the soft_reset_halt ahead of a download
+{
+    if (gdbLoading && recording)
+        loadRun.haltMs = gdbTimer.restart();
+}
+
+void TargetFlow::gdbProgress(qint64 done, qint64 total)
+{
+    if (gdbLoading)
+        emit progress(done, total);
+}
+
+void TargetFlow::gdbWritten(quint32 address, qint64 length)
+{
+    if (!gdbLoading)
+        return;
+    qint64 ms = qMax<qint64>(gdbTimer.elapsed(), 1);
+    emit message(QString("Wrote %1 bytes to 0x%2 via GDB in %3 ms (%4 KiB/s)")
+                 .arg(length).arg(address, 8, 16, QChar('0')).arg(ms)
+                 .arg(length * 1000.0 / 1024 / ms, 0, 'f', 1));
+    loadRun.bytes += length;
+    loadRun.writeMs = ms;
+    if (!gdb->isBusy())
+    {
+        gdbLoading = false;
+        gdb->close();
+        finishLoad(true);
+    }
+}
+
+void TargetFlow::gdbCancelled(quint32 address, qint64 written) // aborted, the image is not complete
+{
+    if (!gdbLoading)
+        return;
+    if (written)
+        emit message(QString("GDB load aborted after %1 more bytes at 0x%2")
+                     .arg(written).arg(address, 8, 16, QChar('0')));
+    else
+        emit message("GDB load aborted");
+    loadRun.bytes += written;
+    loadRun.writeMs = gdbTimer.isValid() ? gdbTimer.elapsed() : 0;
+    gdbLoading = false;
+    gdb->close();
+    finishLoad(false);
+}
+
+
+
+// private Funktions:
+bool TargetFlow::openImage(Load what, const QString &fileName) // parse the image and check it against the memory map
+{
+    quint32 start, length;
+    if (!memoryRange(settings, what, &start, &length, &lastError))
+        return false;
+    if (!image->openIn(fileName, start, length))
+        return fail(QString(what == Ram ? "RAM" : "FLASH") + ": " + image->errorString());
+
+    const QList<FlashImage::Segment> &segments = image->segments();
+    for (int i = 0; i < segments.size(); i++)
+        emit message(QString("Segment %1: %2 bytes at 0x%3")
+                     .arg(i).arg(segments.at(i).size).arg(segments.at(i).address, 8, 16, QChar('0')));
+    transferDone = 0;
+    transferTotal = image->totalSize();
+    transferSizes.clear();
+    return true;
+}
+
+void TargetFlow::loadOverGdb() // binary download of the opened image over the gdb port
+{
+    const QList<FlashImage::Segment> &segments = image->segments();
+    gdbLoading = true;
+    loading = true;
+    if (gdb->isConnected())
+        gdbTimer.start();
+    else			// timed from gdbConnected()
+        gdb->connectToHost(gdbHost, gdbPort);
+    startRecord(0);		// bytes are counted as they are written
+    gdb->monitor(settings.value("SOFTRESET"));
+    for (int i = 0; i < segments.size(); i++)
+        gdb->writeMemory(segments.at(i).address, image->data(segments.at(i)));
+    image->close();
+}
+
+bool TargetFlow::flashDelta(quint32 base) // program only sectors whose checksum differs on target
+{
+    image->close();
+    QFile file(loadFile);
+    if (!file.open(QIODevice::ReadOnly))
+        return fail("Can not read " + loadFile);
+    bool ok;
+    deltaSector = settings.value("FLASHSECTOR").toInt(&ok, 0);
+    if (!ok || deltaSector <= 0)
+        return fail("Invalid flash sector size " + settings.value("FLASHSECTOR"));
+    deltaImage = file.readAll();
+    deltaBase = base;
+    deltaFailed = false;
+    deltaChanged.fill(false, (deltaImage.size() + deltaSector - 1) / deltaSector);
+    if (deltaChanged.isEmpty())
+        return fail(loadFile + " is empty");
+
+    QStringList commands(settings.value("SOFTRESET"));	// the target computes a CRC per sector
+    for (int i = 0; i < deltaChanged.size(); i++)
+    {
+        QString slice = writeSlice(deltaImage.mid(i * deltaSector, deltaSector), base + i * deltaSector);
+        if (slice.isEmpty())
+        {
+            removeSlices();
+            deltaImage.clear();
+            return false;
+        }
+        commands << "verify_image_checksum " + slice + QString(" 0x%1 bin").arg(base + i * deltaSector, 8, 16, QChar('0'));
+    }
+    loading = true;
+    deltaTimer.start();
+    QList<OcdReply *> replies = transport->execute(commands);
+    connect(replies.at(0), SIGNAL(finished()), this, SLOT(deltaHalted()));
+    for (int i = 1; i < replies.size(); i++)
+    {
+        deltaChecks.insert(replies.at(i), i - 1);
+        connect(replies.at(i), SIGNAL(finished()), this, SLOT(deltaChecked()));
+    }
+    return true;
+}
+
+QString TargetFlow::writeSlice(const QByteArray &data, quint32 address)
+{
+    QString slice = FlashImage::writeSlice(data, address);
+    if (slice.isEmpty())
+        fail("Can not write an image slice to " + QDir::tempPath());
+    else
+        sliceFiles << slice;
+    return slice;
+}
+
+void TargetFlow::removeSlices()
+{
+    for (int i = 0; i < sliceFiles.size(); i++)
+        QFile::remove(sliceFiles.at(i));
+    sliceFiles.clear();
+}
+
+void TargetFlow::next()
+{
+    if (queue.isEmpty())
+        return;
+    command = transport->execute(queue.takeFirst());
+    connect(command, SIGNAL(finished()), this, SLOT(stepFinished()));
+}
+
+void TargetFlow::startRecord(qint64 bytes)
+{
+    loadRun = LoadRecord();
+    loadRun.when = QDateTime::currentDateTime();
+    loadRun.target = (job == Ram) ? "RAM" : "FLASH";
+    loadRun.image = loadFile;
+    loadRun.bytes = bytes;
+    recording = true;
+}
+
+void TargetFlow::finishLoad(bool ok)
+{
+    loading = false;
+    transferSizes.clear();
+    removeSlices();
+    if (!ok)
+        failed = true;
+    if (recording)
+    {
+        recording = false;
+        if (!ok)
+            loadRun.ok = false;
+        emit loaded(loadRun);
+    }
+    if (!isBusy())
+        emit finished(!failed);
+}
+
+void TargetFlow::deltaFinished()
+{
+    if (deltaWriting)
+    {
+        qint64 ms = qMax<qint64>(deltaTimer.elapsed(), 1);
+        qint64 skipped = deltaImage.size() - deltaWritten;
+        if (deltaFailed)
+            emit message(QString("Delta flash failed after %1 ms").arg(ms));
+        else	// estimate what writing the skipped bytes would have cost at the measured rate
+            emit message(QString("Delta flash wrote %1 of %2 bytes in %3 ms, skipped %4 bytes, about %5 ms saved")
+                         .arg(deltaWritten).arg(deltaImage.size()).arg(ms).arg(skipped)
+                         .arg(qMax<qint64>(ms * skipped / qMax<qint64>(deltaWritten, 1) - deltaVerifyMs, 0)));
+    }
+    bool ok = !deltaFailed;
+    deltaWriting = false;
+    deltaChecks.clear();
+    deltaImage.clear();
+    finishLoad(ok);
+}
+
+bool TargetFlow::fail(const QString &text)
+{
+    lastError = text;
+    return false;
+}
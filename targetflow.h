@@ -0,0 +1,135 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TARGETFLOW_H
+#define TARGETFLOW_H
+
+#include <QObject>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
+#include "profile.h"
+#include "loadstats.h"
+
+class OcdTransport;
+class OcdReply;
+class GdbRemote;
+class FlashImage;
+
+// The command flows behind the buttons of the GUI, shared with the batch
+// mode: the simple steps (halt, reset, erase, ...) and the image loads,
+// which halt the target, check the image against the memory map of the
+// profile and write or verify it segment by segment. FLASH loads can
+// write only the sectors that differ on target, RAM loads can go over the
+// gdb port. Commands run one after the other and the rest is dropped on
+// the first error. The caller shows the messages and the progress.
+class TargetFlow : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Load { Ram, Flash, Verify };
+
+    TargetFlow(GdbRemote *gdb, QObject *parent = 0);
+    ~TargetFlow();
+
+    void setTransport(OcdTransport *transport);
+    void setProfile(const Profile &profile) { settings = profile; }
+    void setGdbPort(const QString &host, quint16 port);	// 0: RAM loads go through the transport
+    void setErase(bool on) { eraseFirst = on; }
+    void setDelta(bool on) { deltaMode = on; }
+
+    QStringList stepCommands(const QString &step) const;
+    bool runStep(const QString &step);
+    void run(const QStringList &commands);
+    bool load(Load what, const QString &fileName);
+    bool loadCommands(const QString &fileName, QStringList *commands, QList<qint64> *sizes, QStringList *files);
+    void abort();
+
+    bool isBusy() const;
+    int queued() const { return queue.size(); }
+    QString errorString() const { return lastError; }
+    static bool checkImage(const Profile &profile, Load what, const QString &fileName, qint64 *bytes, QString *why);
+
+signals:
+    void message(const QString &text);
+    void commandFinished(OcdReply *reply);	// every command of the flows
+    void progress(qint64 done, qint64 total);	// bytes of the load
+    void loaded(const LoadRecord &record);	// a RAM or FLASH load ended, timed by phase
+    void finished(bool ok);			// nothing left to run
+
+private slots:
+    void stepFinished();
+    void deltaHalted();
+    void deltaChecked();
+    void gdbConnected();
+    void gdbError(const QString &text);
+    void gdbHalted();
+    void gdbProgress(qint64 done, qint64 total);
+    void gdbWritten(quint32 address, qint64 length);
+    void gdbCancelled(quint32 address, qint64 written);
+
+private:
+    bool openImage(Load what, const QString &fileName);
+    void loadOverGdb();
+    bool flashDelta(quint32 base);
+    QString writeSlice(const QByteArray &data, quint32 address);
+    void removeSlices();
+    void next();
+    void startRecord(qint64 bytes);
+    void finishLoad(bool ok);
+    void deltaFinished();
+    bool fail(const QString &text);
+
+    OcdTransport *transport;
+    GdbRemote *gdb;
+    QString gdbHost;
+    quint16 gdbPort;
+    Profile settings;
+    bool eraseFirst;
+    bool deltaMode;
+    FlashImage *image;
+    Load job;
+    QString loadFile;
+    bool loading;
+    OcdReply *command;
+    QStringList queue;
+    bool failed;			// a command of this run failed
+    QHash<QString, qint64> transferSizes;	// of the queued segment transfers
+    qint64 transferDone;
+    qint64 transferTotal;
+    QStringList sliceFiles;
+    LoadRecord loadRun;
+    bool recording;
+    bool gdbLoading;		// attached for a RAM download, detach when done
+    QElapsedTimer gdbTimer;
+    QByteArray deltaImage;	// delta flashing state
+    quint32 deltaBase;
+    int deltaSector;
+    QVector<bool> deltaChanged;
+    QHash<OcdReply *, int> deltaChecks;
+    qint64 deltaWritten;
+    qint64 deltaVerifyMs;
+    bool deltaWriting;
+    bool deltaFailed;
+    QElapsedTimer deltaTimer;
+    QString lastError;
+};
+
+#endif // TARGETFLOW_H
@@ -0,0 +1,9 @@
+TEMPLATE = app
+TARGET = tst_batch
+CONFIG += qtestlib
+QT += network
+DEPENDPATH += . ../shared ../.. ../../QtTelnet
+INCLUDEPATH += . ../shared ../.. ../../QtTelnet
+
+HEADERS += ../shared/mockocd.h ../../batch.h ../../targetflow.h ../../ocdtransport.h ../../ocdsupervisor.h ../../gdbremote.h ../../flashimage.h ../../profile.h ../../loadstats.h ../../spscqueue.h ../../QtTelnet/qttelnet.h
+SOURCES += tst_batch.cpp ../shared/mockocd.cpp ../../batch.cpp ../../targetflow.cpp ../../ocdtransport.cpp ../../ocdsupervisor.cpp ../../gdbremote.cpp ../../flashimage.cpp ../../profile.cpp ../../loadstats.cpp ../../QtTelnet/qttelnet.cpp
@@ -0,0 +1,236 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "batch.h"
+#include "mockocd.h"
+#include <QtTest/QtTest>
+#include <QTemporaryFile>
+#include <QProcess>
+
+static const quint32 FlashBase = 0x00100000;
+static const int ImageSize = 64 * 1024;
+static const int BatchMs = 20000;		// for a whole run
+
+
+// BatchRunner end to end: this binary is started with "--batch" (see
+// main()) against a mock openOCD on its Tcl RPC port, and the JSON lines
+// and exit code it leaves are checked along with the mock's memory.
+class tst_Batch : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void noSteps();
+    void imageTooLarge();
+    void noServer();
+    void flashVerifyReset();
+    void verifyMismatch();
+    void failingCommand();
+
+private:
+    int runBatch(const QStringList &arguments);
+    QList<QByteArray> events(const char *event) const;
+    static QByteArray field(const QByteArray &line, const char *key);
+
+    QTemporaryFile profile;
+    QTemporaryFile image;
+    QByteArray data;
+    MockOcd *mock;
+    QList<QByteArray> output;	// JSON lines of the last run
+};
+
+
+void tst_Batch::initTestCase()
+{
+    QVERIFY(profile.open());
+    profile.write("FLASH = 0x00100000 0x00040000\n"
+                  "SOFTRESET = soft_reset_halt\n"
+                  "RESET = reset run\n");
+    profile.flush();
+
+    for (int i = 0; i < ImageSize; i++)
+        data += char(i * 7 + (i >> 8));
+    QVERIFY(image.open());
+    QCOMPARE(int(image.write(data)), ImageSize);
+    image.flush();
+}
+
+void tst_Batch::init()
+{
+    mock = new MockOcd(MockOcd::TclRpc);
+    QVERIFY(mock->listen());
+    output.clear();
+}
+
+void tst_Batch::cleanup()
+{
+    delete mock;
+}
+
+void tst_Batch::noSteps()
+{
+    QCOMPARE(runBatch(QStringList()), int(BatchRunner::UsageError));
+    QCOMPARE(events("done").size(), 1);
+    QCOMPARE(field(events("done").first(), "ok"), QByteArray("false"));
+    QCOMPARE(mock->commands(), 0);
+}
+
+void tst_Batch::imageTooLarge() // refused before anything is sent
+{
+    QTemporaryFile large;
+    QVERIFY(large.open());
+    large.write(QByteArray(0x00040000 + 4, '\xff'));
+    large.flush();
+    QCOMPARE(runBatch(QStringList() << "halt" << "flash" << large.fileName()), int(BatchRunner::ImageInvalid));
+    QVERIFY(events("connected").isEmpty());
+    QCOMPARE(mock->commands(), 0);
+}
+
+void tst_Batch::noServer()
+{
+    quint16 port = mock->port();
+    delete mock;
+    mock = new MockOcd(MockOcd::TclRpc);	// not listening, the port is closed
+    QStringList arguments;
+    arguments << "--port" << QString::number(port) << "halt";
+    QCOMPARE(runBatch(arguments), int(BatchRunner::ConnectFailed));
+    QCOMPARE(events("done").size(), 1);
+}
+
+void tst_Batch::flashVerifyReset()
+{
+    QCOMPARE(runBatch(QStringList() << "flash" << image.fileName() << "verify" << image.fileName() << "reset"),
+             int(BatchRunner::Passed));
+    QCOMPARE(mock->bytes(FlashBase, ImageSize), data);
+
+    QList<QByteArray> commands = events("command");
+    QStringList sent;
+    for (int i = 0; i < commands.size(); i++)
+    {
+        QCOMPARE(field(commands.at(i), "ok"), QByteArray("true"));
+        sent << field(commands.at(i), "command");
+    }
+    QString address = QString(" 0x%1 bin").arg(FlashBase, 8, 16, QChar('0'));
+    QCOMPARE(sent, QStringList() << "\"soft_reset_halt\""
+                                 << "\"flash write_image " + image.fileName() + address + "\""
+                                 << "\"verify_image " + image.fileName() + address + "\""
+                                 << "\"reset run\"");
+
+    QCOMPARE(events("load").size(), 1);
+    QCOMPARE(field(events("load").first(), "bytes"), QByteArray::number(ImageSize));
+    QVERIFY(!events("progress").isEmpty());
+    QCOMPARE(field(events("progress").last(), "percent"), QByteArray("100"));
+    QCOMPARE(field(events("done").first(), "ok"), QByteArray("true"));
+}
+
+void tst_Batch::verifyMismatch()
+{
+    mock->setBytes(FlashBase, data);
+    mock->setBytes(FlashBase + 0x1234, QByteArray(1, '\0'));
+    QCOMPARE(runBatch(QStringList() << "verify" << image.fileName() << "reset"), int(BatchRunner::CommandFailed));
+    QCOMPARE(events("command").size(), 1);		// reset never sent
+    QCOMPARE(field(events("command").first(), "ok"), QByteArray("false"));
+    QCOMPARE(mock->commands(), 1);
+}
+
+void tst_Batch::failingCommand() // an error stops the step and the rest of the run
+{
+    QStringList arguments;
+    arguments << "cmd" << "load_image /nonexistent/image.bin 0x00200000" << "reset";
+    QCOMPARE(runBatch(arguments), int(BatchRunner::CommandFailed));
+    QCOMPARE(events("command").size(), 1);
+    QVERIFY(field(events("command").first(), "error").contains("couldn't open"));
+    QCOMPARE(field(events("done").first(), "code"), QByteArray("1"));
+    QCOMPARE(mock->commands(), 1);
+}
+
+
+
+// private Funktions:
+int tst_Batch::runBatch(const QStringList &arguments) // the mock keeps answering while waiting
+{
+    QProcess batch;
+    batch.start(QCoreApplication::applicationFilePath(), QStringList() << "--batch" << "--profile" << profile.fileName()
+                << "--host" << "127.0.0.1" << "--port" << QString::number(mock->port()) << arguments);
+    if (!batch.waitForStarted())
+        return -1;
+    QElapsedTimer clock;
+    clock.start();
+    while (batch.state() != QProcess::NotRunning && clock.elapsed() < BatchMs)
+        QTest::qWait(10);
+    if (batch.state() != QProcess::NotRunning)
+    {
+        batch.kill();
+        batch.waitForFinished();
+        return -1;
+    }
+    output = batch.readAllStandardOutput().split('\n');
+    return batch.exitCode();
+}
+
+QList<QByteArray> tst_Batch::events(const char *event) const
+{
+    QList<QByteArray> lines;
+    QByteArray start = QByteArray("{\"event\":\"") + event + "\"";
+    for (int i = 0; i < output.size(); i++)
+        if (output.at(i).startsWith(start))
+            lines << output.at(i);
+    return lines;
+}
+
+QByteArray tst_Batch::field(const QByteArray &line, const char *key) // the raw value, strings keep their quotes
+{
+    QByteArray name = QByteArray("\"") + key + "\":";
+    int start = line.indexOf(name);
+    if (start == -1)
+        return QByteArray();
+    start += name.size();
+    int end = start;
+    if (line.at(start) == '"')
+    {
+        for (end = start + 1; end < line.size() && line.at(end) != '"'; end++)
+            if (line.at(end) == '\\')
+                end++;
+        end++;
+    }
+    else
+    {
+        while (end < line.size() && line.at(end) != ',' && line.at(end) != '}')
+            end++;
+    }
+    return line.mid(start, end - start);
+}
+
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    if (app.arguments().contains("--batch"))	// started by a test in place of OpenOCD-QtGUI
+    {
+        BatchRunner runner(app.arguments());
+        QTimer::singleShot(0, &runner, SLOT(start()));
+        return app.exec();
+    }
+    tst_Batch test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_batch.moc"
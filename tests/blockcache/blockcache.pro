@@ -0,0 +1,9 @@
+TEMPLATE = app
+TARGET = tst_blockcache
+CONFIG += qtestlib
+QT += network
+DEPENDPATH += . ../.. ../../QtTelnet
+INCLUDEPATH += . ../.. ../../QtTelnet
+
+HEADERS += ../../memview.h ../../memparse.h ../../ocdtransport.h ../../spscqueue.h ../../QtTelnet/qttelnet.h
+SOURCES += tst_blockcache.cpp ../../memview.cpp ../../memparse.cpp ../../ocdtransport.cpp ../../QtTelnet/qttelnet.cpp
@@ -0,0 +1,183 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "memview.h"
+#include <QtTest/QtTest>
+
+
+// The block cache of the memory view: lookup, LRU eviction and the
+// invalidation of written or resumed ranges.
+class tst_BlockCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void insertFind();
+    void replace();
+    void failedRead();
+    void eviction();
+    void findRefreshes();
+    void minimumSize();
+    void invalidateRange();
+    void invalidateEmpty();
+    void invalidateBelowStart();
+    void endOfAddressSpace();
+    void clear();
+    void blockOf();
+
+private:
+    static QByteArray block(char fill) { return QByteArray(BlockCache::BlockSize, fill); }
+};
+
+
+void tst_BlockCache::insertFind()
+{
+    BlockCache cache;
+    cache.insert(0x100, block('a'));
+    QCOMPARE(cache.count(), 1);
+    QVERIFY(cache.find(0x100) != 0);
+    QCOMPARE(*cache.find(0x100), block('a'));
+    QVERIFY(cache.find(0x200) == 0);
+}
+
+void tst_BlockCache::replace()
+{
+    BlockCache cache;
+    cache.insert(0x100, block('a'));
+    cache.insert(0x100, block('b'));
+    QCOMPARE(cache.count(), 1);
+    QCOMPARE(*cache.find(0x100), block('b'));
+}
+
+void tst_BlockCache::failedRead()
+{
+    BlockCache cache;
+    cache.insert(0x100, QByteArray());	// cached as unreadable, not read again
+    QVERIFY(cache.find(0x100) != 0);
+    QVERIFY(cache.find(0x100)->isEmpty());
+}
+
+void tst_BlockCache::eviction()
+{
+    BlockCache cache(3);
+    cache.insert(0x000, block('0'));
+    cache.insert(0x100, block('1'));
+    cache.insert(0x200, block('2'));
+    cache.insert(0x300, block('3'));
+    QCOMPARE(cache.count(), 3);
+    QVERIFY(cache.find(0x000) == 0);
+    QVERIFY(cache.find(0x100) != 0);
+    QVERIFY(cache.find(0x300) != 0);
+}
+
+void tst_BlockCache::findRefreshes()
+{
+    BlockCache cache(3);
+    cache.insert(0x000, block('0'));
+    cache.insert(0x100, block('1'));
+    cache.insert(0x200, block('2'));
+    QVERIFY(cache.find(0x000) != 0);
+    cache.insert(0x100, block('1'));	// so is a new insert
+    cache.insert(0x300, block('3'));
+    QVERIFY(cache.find(0x200) == 0);
+    QVERIFY(cache.find(0x000) != 0);
+    QVERIFY(cache.find(0x100) != 0);
+    cache.insert(0x400, block('4'));
+    QVERIFY(cache.find(0x300) == 0);
+}
+
+void tst_BlockCache::minimumSize()
+{
+    BlockCache cache(0);
+    cache.insert(0x000, block('0'));
+    cache.insert(0x100, block('1'));
+    QCOMPARE(cache.count(), 1);
+    QVERIFY(cache.find(0x100) != 0);
+}
+
+void tst_BlockCache::invalidateRange()
+{
+    BlockCache cache;
+    for (quint32 address = 0; address <= 0x400; address += 0x100)
+        cache.insert(address, block('x'));
+    cache.invalidate(0x1f0, 0x20);		// the end of one block and the start of the next
+    QVERIFY(cache.find(0x100) == 0);
+    QVERIFY(cache.find(0x200) == 0);
+    cache.invalidate(0x3ff, 1);
+    QVERIFY(cache.find(0x300) == 0);
+    QCOMPARE(cache.count(), 2);
+    QVERIFY(cache.find(0x000) != 0);
+    QVERIFY(cache.find(0x400) != 0);
+}
+
+void tst_BlockCache::invalidateEmpty()
+{
+    BlockCache cache;
+    cache.insert(0x100, block('x'));
+    cache.invalidate(0x100, 0);
+    QCOMPARE(cache.count(), 1);
+}
+
+void tst_BlockCache::invalidateBelowStart()
+{
+    // a write into the middle of a block drops the whole block
+    BlockCache cache;
+    cache.insert(0x100, block('x'));
+    cache.insert(0x200, block('x'));
+    cache.invalidate(0x1fc, 4);
+    QVERIFY(cache.find(0x100) == 0);
+    QVERIFY(cache.find(0x200) != 0);
+}
+
+void tst_BlockCache::endOfAddressSpace()
+{
+    BlockCache cache;
+    cache.insert(0xffffff00, block('x'));
+    cache.insert(0x00000000, block('x'));
+    cache.invalidate(0xffffff00, 0x100);
+    QVERIFY(cache.find(0xffffff00) == 0);
+    QVERIFY(cache.find(0x00000000) != 0);
+
+    cache.insert(0xffffff00, block('x'));
+    cache.invalidate(0xfffffff0, 0x100);	// past the end, must not wrap to 0
+    QVERIFY(cache.find(0xffffff00) == 0);
+    QVERIFY(cache.find(0x00000000) != 0);
+}
+
+void tst_BlockCache::clear()
+{
+    BlockCache cache;
+    cache.insert(0x000, block('0'));
+    cache.insert(0x100, block('1'));
+    cache.clear();
+    QCOMPARE(cache.count(), 0);
+    QVERIFY(cache.find(0x000) == 0);
+    cache.insert(0x200, block('2'));	// the age list is cleared along
+    QCOMPARE(cache.count(), 1);
+}
+
+void tst_BlockCache::blockOf()
+{
+    QCOMPARE(BlockCache::blockOf(0x00000000), quint32(0x00000000));
+    QCOMPARE(BlockCache::blockOf(0x002000ff), quint32(0x00200000));
+    QCOMPARE(BlockCache::blockOf(0x00200100), quint32(0x00200100));
+    QCOMPARE(BlockCache::blockOf(0xffffffff), quint32(0xffffff00));
+}
+
+QTEST_APPLESS_MAIN(tst_BlockCache)
+#include "tst_blockcache.moc"
@@ -0,0 +1,9 @@
+TEMPLATE = app
+TARGET = tst_delta
+CONFIG += qtestlib
+QT += network
+DEPENDPATH += . ../shared ../.. ../../QtTelnet
+INCLUDEPATH += . ../shared ../.. ../../QtTelnet
+
+HEADERS += ../shared/mockocd.h ../../targetflow.h ../../ocdtransport.h ../../gdbremote.h ../../flashimage.h ../../profile.h ../../loadstats.h ../../spscqueue.h ../../QtTelnet/qttelnet.h
+SOURCES += tst_delta.cpp ../shared/mockocd.cpp ../../targetflow.cpp ../../ocdtransport.cpp ../../gdbremote.cpp ../../flashimage.cpp ../../profile.cpp ../../loadstats.cpp ../../QtTelnet/qttelnet.cpp
@@ -0,0 +1,252 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "targetflow.h"
+#include "ocdtransport.h"
+#include "gdbremote.h"
+#include "mockocd.h"
+#include <QtTest/QtTest>
+#include <QTemporaryFile>
+#include <QRegExp>
+
+static const quint32 FlashBase = 0x00100000;
+static const int Sector = 0x4000;
+static const int ImageSize = 3 * Sector + 0x3000;	// the last sector is not full
+static const qint64 WriteRate = 64 * 1024;	// bytes/s the mock flashes at
+
+
+// Keeps what a TargetFlow reports.
+class Recorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    Recorder() : done(false), ok(false) {}
+
+    QStringList messages;
+    QStringList commands;
+    QList<LoadRecord> records;
+    bool done;
+    bool ok;
+
+public slots:
+    void message(const QString &text) { messages << text; }
+    void command(OcdReply *reply) { commands << reply->command(); }
+    void loaded(const LoadRecord &record) { records << record; }
+    void finished(bool passed) { done = true; ok = passed; }
+};
+
+
+// Delta flashing of TargetFlow against a mock openOCD whose flash holds
+// an older image: the sector checksums with verify_image_checksum, the
+// sectors chosen and merged into writes, and the report of bytes skipped
+// and time saved.
+class tst_Delta : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void unchanged();
+    void oneSector();
+    void neighbours();
+    void lastSector();
+    void emptyFlash();
+    void badSectorSize();
+
+private:
+    bool flash(const QByteArray &onTarget);
+    QStringList writes() const;
+    QString report(const char *start) const;
+
+    MockOcd *mock;
+    TclRpcTransport *transport;
+    GdbRemote *gdb;
+    TargetFlow *flow;
+    Recorder *recorder;
+    QTemporaryFile *image;
+    QByteArray data;		// the new image
+};
+
+
+void tst_Delta::init()
+{
+    mock = new MockOcd(MockOcd::TclRpc);
+    QVERIFY(mock->listen());
+    mock->setWriteRate(WriteRate);
+    transport = new TclRpcTransport;
+    QSignalSpy connected(transport, SIGNAL(connected()));
+    transport->connectToHost("127.0.0.1", mock->port());
+    for (int i = 0; i < 200 && connected.isEmpty(); i++)
+        QTest::qWait(10);
+    QVERIFY(transport->isConnected());
+
+    gdb = new GdbRemote;
+    flow = new TargetFlow(gdb);
+    flow->setTransport(transport);
+    flow->setProfile(Profile());	// AT91SAM7 defaults, 16 KiB sectors
+    flow->setDelta(true);
+    recorder = new Recorder;
+    connect(flow, SIGNAL(message(QString)), recorder, SLOT(message(QString)));
+    connect(flow, SIGNAL(commandFinished(OcdReply*)), recorder, SLOT(command(OcdReply*)));
+    connect(flow, SIGNAL(loaded(LoadRecord)), recorder, SLOT(loaded(LoadRecord)));
+    connect(flow, SIGNAL(finished(bool)), recorder, SLOT(finished(bool)));
+
+    data.resize(ImageSize);
+    for (int i = 0; i < ImageSize; i++)
+        data[i] = char(i * 7 + i / 256);
+    image = new QTemporaryFile(QDir::tempPath() + "/tst_delta-XXXXXX.bin");
+    QVERIFY(image->open());
+    QCOMPARE(int(image->write(data)), ImageSize);
+    image->flush();
+}
+
+void tst_Delta::cleanup()
+{
+    delete flow;
+    delete recorder;
+    delete gdb;
+    delete transport;
+    delete mock;
+    delete image;
+}
+
+void tst_Delta::unchanged() // every checksum matches, nothing is written
+{
+    QVERIFY(flash(data));
+    const QStringList &sent = recorder->commands;
+    QCOMPARE(mock->writtenBytes(), qint64(0));
+    QCOMPARE(sent.size(), 1 + 4);		// halt and a checksum per sector
+    QCOMPARE(sent.first(), QString("soft_reset_halt"));
+    for (int i = 1; i < sent.size(); i++)
+    {
+        QVERIFY(sent.at(i).startsWith("verify_image_checksum "));
+        QVERIFY(sent.at(i).endsWith(QString(" 0x%1 bin").arg(FlashBase + (i - 1) * Sector, 8, 16, QChar('0'))));
+    }
+    QVERIFY(!report("0 of 4 sector(s) differ").isEmpty());
+    QVERIFY(!report("Delta flash skipped all").isEmpty());
+    QVERIFY(recorder->records.isEmpty());
+}
+
+void tst_Delta::oneSector() // written alone, the report tells what was skipped
+{
+    QByteArray old = data;
+    old[2 * Sector + 100] = ~old.at(2 * Sector + 100);
+    QVERIFY(flash(old));
+    QCOMPARE(mock->writtenBytes(), qint64(Sector));
+    QCOMPARE(writes(), QStringList() << QString("0x%1").arg(FlashBase + 2 * Sector, 8, 16, QChar('0')));
+    QVERIFY(mock->bytes(FlashBase, ImageSize) == data);
+    QVERIFY(!report("1 of 4 sector(s) differ").isEmpty());
+
+    QRegExp saved("Delta flash wrote (\\d+) of (\\d+) bytes in (\\d+) ms, skipped (\\d+) bytes, about (\\d+) ms saved");
+    QVERIFY2(saved.exactMatch(report("Delta flash wrote")), qPrintable(report("Delta flash")));
+    QCOMPARE(saved.cap(1).toInt(), Sector);
+    QCOMPARE(saved.cap(2).toInt(), ImageSize);
+    QCOMPARE(saved.cap(4).toInt(), ImageSize - Sector);
+    QVERIFY(saved.cap(3).toInt() >= Sector * 1000 / WriteRate);	// the mock's write time
+    QVERIFY(saved.cap(5).toInt() > 0);
+
+    QCOMPARE(recorder->records.size(), 1);
+    QCOMPARE(recorder->records.first().bytes, qint64(Sector));
+    QVERIFY(recorder->records.first().ok);
+}
+
+void tst_Delta::neighbours() // changed sectors next to each other go in one write
+{
+    QByteArray old = data;
+    old[Sector] = ~old.at(Sector);
+    old[3 * Sector - 1] = ~old.at(3 * Sector - 1);
+    QVERIFY(flash(old));
+    QCOMPARE(mock->writtenBytes(), qint64(2 * Sector));
+    QCOMPARE(writes(), QStringList() << QString("0x%1").arg(FlashBase + Sector, 8, 16, QChar('0')));
+    QVERIFY(mock->bytes(FlashBase, ImageSize) == data);
+    QVERIFY(!report("2 of 4 sector(s) differ").isEmpty());
+}
+
+void tst_Delta::lastSector() // only the bytes of the image, not a whole sector
+{
+    QByteArray old = data;
+    old[ImageSize - 1] = ~old.at(ImageSize - 1);
+    old[0] = ~old.at(0);
+    QVERIFY(flash(old));
+    QCOMPARE(mock->writtenBytes(), qint64(Sector + 0x3000));
+    QCOMPARE(writes().size(), 2);
+    QVERIFY(mock->bytes(FlashBase, ImageSize) == data);
+}
+
+void tst_Delta::emptyFlash() // everything differs, everything in one write
+{
+    QVERIFY(flash(QByteArray(ImageSize, '\xff')));
+    QCOMPARE(mock->writtenBytes(), qint64(ImageSize));
+    QCOMPARE(writes().size(), 1);
+    QVERIFY(!report("4 of 4 sector(s) differ").isEmpty());
+    QRegExp saved("Delta flash wrote \\d+ of \\d+ bytes in \\d+ ms, skipped 0 bytes, about 0 ms saved");
+    QVERIFY(saved.exactMatch(report("Delta flash wrote")));
+}
+
+void tst_Delta::badSectorSize()
+{
+    Profile profile;
+    profile.setValue("FLASHSECTOR", "none");
+    flow->setProfile(profile);
+    QVERIFY(!flow->load(TargetFlow::Flash, image->fileName()));
+    QVERIFY(flow->errorString().contains("Invalid flash sector size"));
+    QCOMPARE(mock->commands(), 0);
+}
+
+
+
+// private Funktions:
+bool tst_Delta::flash(const QByteArray &onTarget) // the image over what the target holds, true if it passed
+{
+    mock->setBytes(FlashBase, onTarget);
+    if (!flow->load(TargetFlow::Flash, image->fileName()))
+        return false;
+    for (int i = 0; i < 1000 && !recorder->done; i++)
+        QTest::qWait(10);
+    return recorder->done && recorder->ok;
+}
+
+QStringList tst_Delta::writes() const // addresses of the flash writes sent
+{
+    QStringList addresses;
+    const QStringList &sent = recorder->commands;
+    for (int i = 0; i < sent.size(); i++)
+        if (sent.at(i).startsWith("flash write_image erase "))
+            addresses << sent.at(i).section(' ', -2, -2);
+    return addresses;
+}
+
+QString tst_Delta::report(const char *start) const // the message that starts so
+{
+    for (int i = 0; i < recorder->messages.size(); i++)
+        if (recorder->messages.at(i).startsWith(start))
+            return recorder->messages.at(i);
+    return QString();
+}
+
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);	// sockets only, no display needed
+    tst_Delta test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_delta.moc"
@@ -0,0 +1,9 @@
+TEMPLATE = app
+TARGET = tst_flashimage
+CONFIG += qtestlib
+QT -= gui
+DEPENDPATH += . ../..
+INCLUDEPATH += . ../..
+
+HEADERS += ../../flashimage.h
+SOURCES += tst_flashimage.cpp ../../flashimage.cpp
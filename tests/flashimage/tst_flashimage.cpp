@@ -0,0 +1,361 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "flashimage.h"
+#include <QtTest/QtTest>
+#include <QTemporaryFile>
+#include <QDir>
+#include <QFile>
+
+static const quint32 FlashStart = 0x08000000;
+static const quint32 FlashSize = 0x00010000;
+static const int ElfHeader = 52;
+static const int Phdr = 32;
+
+
+// FlashImage on binaries and ELF32 files: segments, the memory map check,
+// and files that are short, truncated or garbage.
+class tst_FlashImage : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void cleanup();
+    void missing();
+    void empty();
+    void binary();
+    void binaryTooLarge();
+    void binaryAddressSpace();
+    void binaryNamedElf();
+    void garbageBinary();
+    void shortElf();
+    void elf64();
+    void byteOrder();
+    void noProgramHeaders();
+    void truncatedProgramHeaders();
+    void segmentBehindEnd();
+    void segmentWraps();
+    void nothingToLoad();
+    void elfSegments();
+    void elfBigEndian();
+    void elfOutsideRange();
+    void transferCommands();
+
+private:
+    struct Load
+    {
+        quint32 type;
+        quint32 address;
+        QByteArray data;
+    };
+
+    QString write(const QByteArray &data, const char *suffix = "bin");
+    static QByteArray elf(const QList<Load> &loads, bool big = false);
+    static Load load(quint32 address, const QByteArray &data, quint32 type = 1);
+    static void put(QByteArray &bytes, int at, quint32 value, int size, bool big);
+    static QByteArray pattern(int size, int seed);
+
+    QList<QTemporaryFile *> files;
+};
+
+
+void tst_FlashImage::cleanup()
+{
+    qDeleteAll(files);
+    files.clear();
+}
+
+void tst_FlashImage::missing()
+{
+    FlashImage image;
+    QVERIFY(!image.open(QDir::tempPath() + "/tst_flashimage-missing.bin", FlashStart));
+    QVERIFY(image.errorString().startsWith("Can not read"));
+    QCOMPARE(image.format(), FlashImage::Invalid);
+}
+
+void tst_FlashImage::empty()
+{
+    FlashImage image;
+    QVERIFY(!image.open(write(QByteArray()), FlashStart));
+    QVERIFY(image.errorString().endsWith("is empty"));
+}
+
+void tst_FlashImage::binary()
+{
+    const QByteArray data = pattern(1000, 1);
+    FlashImage image;
+    QVERIFY(image.openIn(write(data), FlashStart, FlashSize));
+    QCOMPARE(image.format(), FlashImage::Binary);
+    QCOMPARE(image.segments().size(), 1);
+    QCOMPARE(image.segments().at(0).address, FlashStart);
+    QCOMPARE(image.totalSize(), qint64(1000));
+    QVERIFY(image.data(image.segments().at(0)) == data);
+}
+
+void tst_FlashImage::binaryTooLarge() // one byte over the range
+{
+    FlashImage image;
+    QVERIFY(image.openIn(write(QByteArray(FlashSize, '\xff')), FlashStart, FlashSize));
+    QVERIFY(!image.openIn(write(QByteArray(FlashSize + 1, '\xff')), FlashStart, FlashSize));
+    QVERIFY(image.errorString().contains("does not fit"));
+    QCOMPARE(image.format(), FlashImage::Invalid);
+    QVERIFY(image.segments().isEmpty());
+}
+
+void tst_FlashImage::binaryAddressSpace()
+{
+    FlashImage image;
+    QVERIFY(image.open(write(QByteArray(0x100, 0)), 0xffffff00));
+    QVERIFY(!image.open(write(QByteArray(0x101, 0)), 0xffffff00));
+    QVERIFY(image.errorString().contains("address space"));
+}
+
+void tst_FlashImage::binaryNamedElf() // no magic, but the name says ELF
+{
+    FlashImage image;
+    QVERIFY(!image.open(write(pattern(100, 2), "elf"), FlashStart));
+    QVERIFY(image.errorString().contains("is not an ELF file"));
+}
+
+void tst_FlashImage::garbageBinary() // anything without the magic is a binary
+{
+    FlashImage image;
+    QVERIFY(image.open(write(QByteArray("\x7f" "EL")), FlashStart));
+    QCOMPARE(image.format(), FlashImage::Binary);
+    QCOMPARE(image.totalSize(), qint64(3));
+}
+
+void tst_FlashImage::shortElf()
+{
+    FlashImage image;
+    QVERIFY(!image.open(write(QByteArray("\x7f" "ELF"), "elf"), FlashStart));
+    QVERIFY(image.errorString().contains("not a 32 bit ELF"));
+    QByteArray header = elf(QList<Load>() << load(FlashStart, pattern(16, 3)));
+    QVERIFY(!image.open(write(header.left(ElfHeader - 1)), FlashStart));
+    QVERIFY(image.errorString().contains("not a 32 bit ELF"));
+}
+
+void tst_FlashImage::elf64()
+{
+    QByteArray file = elf(QList<Load>() << load(FlashStart, pattern(16, 3)));
+    file[4] = 2;			// ELFCLASS64
+    FlashImage image;
+    QVERIFY(!image.open(write(file), FlashStart));
+    QVERIFY(image.errorString().contains("not a 32 bit ELF"));
+}
+
+void tst_FlashImage::byteOrder()
+{
+    QByteArray file = elf(QList<Load>() << load(FlashStart, pattern(16, 3)));
+    file[5] = 3;
+    FlashImage image;
+    QVERIFY(!image.open(write(file), FlashStart));
+    QVERIFY(image.errorString().contains("unknown byte order"));
+}
+
+void tst_FlashImage::noProgramHeaders()
+{
+    FlashImage image;
+    QVERIFY(!image.open(write(elf(QList<Load>())), FlashStart));
+    QVERIFY(image.errorString().contains("no program headers"));
+}
+
+void tst_FlashImage::truncatedProgramHeaders()
+{
+    QList<Load> loads;
+    loads << load(FlashStart, QByteArray()) << load(FlashStart + 0x100, QByteArray());
+    QByteArray file = elf(loads);
+    FlashImage image;
+    QVERIFY(!image.open(write(file.left(ElfHeader + Phdr + 8)), FlashStart));
+    QVERIFY(image.errorString().contains("broken program headers"));
+
+    put(file, 42, 16, 2, false);	// e_phentsize below the size of a header
+    QVERIFY(!image.open(write(file), FlashStart));
+    QVERIFY(image.errorString().contains("broken program headers"));
+
+    file = elf(loads);
+    put(file, 28, 0xfffffff0, 4, false);	// e_phoff far behind the end
+    QVERIFY(!image.open(write(file), FlashStart));
+    QVERIFY(image.errorString().contains("broken program headers"));
+}
+
+void tst_FlashImage::segmentBehindEnd()
+{
+    QByteArray file = elf(QList<Load>() << load(FlashStart, pattern(256, 4)));
+    FlashImage image;
+    QVERIFY(!image.open(write(file.left(file.size() - 1)), FlashStart));
+    QVERIFY(image.errorString().contains("segment 0 ends behind the end of the file"));
+}
+
+void tst_FlashImage::segmentWraps()
+{
+    FlashImage image;
+    QVERIFY(!image.open(write(elf(QList<Load>() << load(0xfffffff0, pattern(32, 5)))), FlashStart));
+    QVERIFY(image.errorString().contains("wraps the address space"));
+}
+
+void tst_FlashImage::nothingToLoad() // only .bss and a note
+{
+    QList<Load> loads;
+    loads << load(0x20000000, QByteArray()) << load(FlashStart, pattern(16, 6), 4);
+    FlashImage image;
+    QVERIFY(!image.open(write(elf(loads)), FlashStart));
+    QVERIFY(image.errorString().contains("nothing to load"));
+}
+
+void tst_FlashImage::elfSegments()
+{
+    QList<Load> loads;
+    loads << load(FlashStart, pattern(300, 7))
+          << load(0x20000000, QByteArray())		// .bss
+          << load(0, pattern(40, 8), 4)			// PT_NOTE
+          << load(FlashStart + 0x1000, pattern(77, 9));
+    FlashImage image;
+    QVERIFY(image.openIn(write(elf(loads)), FlashStart, FlashSize));
+    QCOMPARE(image.format(), FlashImage::Elf);
+    QCOMPARE(image.segments().size(), 2);
+    QCOMPARE(image.segments().at(0).address, FlashStart);
+    QCOMPARE(image.segments().at(1).address, FlashStart + 0x1000);
+    QCOMPARE(image.totalSize(), qint64(300 + 77));
+    QVERIFY(image.data(image.segments().at(0)) == pattern(300, 7));
+    QVERIFY(image.data(image.segments().at(1)) == pattern(77, 9));
+}
+
+void tst_FlashImage::elfBigEndian()
+{
+    FlashImage image;
+    QVERIFY(image.open(write(elf(QList<Load>() << load(0x00400000, pattern(64, 10)), true)), FlashStart));
+    QCOMPARE(image.segments().size(), 1);
+    QCOMPARE(image.segments().at(0).address, quint32(0x00400000));
+    QVERIFY(image.data(image.segments().at(0)) == pattern(64, 10));
+}
+
+void tst_FlashImage::elfOutsideRange() // a segment in RAM, one ending one byte behind the flash
+{
+    FlashImage image;
+    QList<Load> loads;
+    loads << load(FlashStart, pattern(16, 11)) << load(0x20000000, pattern(16, 12));
+    QVERIFY(!image.openIn(write(elf(loads)), FlashStart, FlashSize));
+    QVERIFY(image.errorString().contains("segment 0x20000000-0x2000000f is outside"));
+
+    loads.clear();
+    loads << load(FlashStart + FlashSize - 16, pattern(17, 13));
+    QVERIFY(!image.openIn(write(elf(loads)), FlashStart, FlashSize));
+    QVERIFY(image.errorString().contains("is outside"));
+
+    loads.clear();
+    loads << load(FlashStart - 4, pattern(8, 14));
+    QVERIFY(!image.openIn(write(elf(loads)), FlashStart, FlashSize));
+}
+
+void tst_FlashImage::transferCommands() // a binary as it is, ELF segments as slices
+{
+    FlashImage image;
+    QList<qint64> sizes;
+    QStringList slices;
+    QString name = write(pattern(100, 15));
+    QVERIFY(image.open(name, FlashStart));
+    QCOMPARE(image.transferCommands("flash write_image ", &sizes, &slices),
+             QStringList("flash write_image " + name + " 0x08000000 bin"));
+    QCOMPARE(sizes, QList<qint64>() << 100);
+    QVERIFY(slices.isEmpty());
+
+    QList<Load> loads;
+    loads << load(FlashStart, pattern(20, 16)) << load(FlashStart + 0x400, pattern(30, 17));
+    QVERIFY(image.open(write(elf(loads)), FlashStart));
+    sizes.clear();
+    QStringList commands = image.transferCommands("load_image ", &sizes, &slices);
+    QCOMPARE(commands.size(), 2);
+    QCOMPARE(slices.size(), 2);
+    QCOMPARE(sizes, QList<qint64>() << 20 << 30);
+    for (int i = 0; i < 2; i++)
+    {
+        QCOMPARE(commands.at(i), "load_image " + slices.at(i) + QString(" 0x%1 bin").arg(loads.at(i).address, 8, 16, QChar('0')));
+        QFile slice(slices.at(i));
+        QVERIFY(slice.open(QIODevice::ReadOnly));
+        QVERIFY(slice.readAll() == loads.at(i).data);
+        slice.close();
+        QVERIFY(QFile::remove(slices.at(i)));
+    }
+}
+
+
+
+// private Funktions:
+QString tst_FlashImage::write(const QByteArray &data, const char *suffix) // a file kept until cleanup()
+{
+    QTemporaryFile *file = new QTemporaryFile(QDir::tempPath() + "/tst_flashimage-XXXXXX." + suffix);
+    files << file;
+    if (!file->open() || file->write(data) != data.size())
+        return QString();
+    file->flush();
+    return file->fileName();
+}
+
+// ELF32 header, program headers, then the data of the segments in order
+QByteArray tst_FlashImage::elf(const QList<Load> &loads, bool big)
+{
+    QByteArray file(ElfHeader + Phdr * loads.size(), 0);
+    file[0] = 0x7f;
+    file[1] = 'E';
+    file[2] = 'L';
+    file[3] = 'F';
+    file[4] = 1;			// ELFCLASS32
+    file[5] = big ? 2 : 1;
+    file[6] = 1;
+    put(file, 16, 2, 2, big);	// ET_EXEC
+    put(file, 28, loads.isEmpty() ? 0 : ElfHeader, 4, big);
+    put(file, 40, ElfHeader, 2, big);
+    put(file, 42, Phdr, 2, big);
+    put(file, 44, loads.size(), 2, big);
+    for (int i = 0; i < loads.size(); i++)
+    {
+        int ph = ElfHeader + Phdr * i;
+        put(file, ph, loads.at(i).type, 4, big);
+        put(file, ph + 4, file.size(), 4, big);
+        put(file, ph + 8, loads.at(i).address, 4, big);
+        put(file, ph + 12, loads.at(i).address, 4, big);
+        put(file, ph + 16, loads.at(i).data.size(), 4, big);
+        put(file, ph + 20, loads.at(i).data.size() + 64, 4, big);
+        file += loads.at(i).data;
+    }
+    return file;
+}
+
+tst_FlashImage::Load tst_FlashImage::load(quint32 address, const QByteArray &data, quint32 type)
+{
+    Load segment = { type, address, data };
+    return segment;
+}
+
+void tst_FlashImage::put(QByteArray &bytes, int at, quint32 value, int size, bool big)
+{
+    for (int i = 0; i < size; i++)
+        bytes[at + (big ? size - 1 - i : i)] = char(value >> (8 * i));
+}
+
+QByteArray tst_FlashImage::pattern(int size, int seed)
+{
+    QByteArray bytes(size, 0);
+    for (int i = 0; i < size; i++)
+        bytes[i] = char(i * 13 + seed * 31 + i / 256);
+    return bytes;
+}
+
+QTEST_APPLESS_MAIN(tst_FlashImage)
+#include "tst_flashimage.moc"
@@ -0,0 +1,10 @@
+TEMPLATE = app
+TARGET = tst_gdbremote
+CONFIG += qtestlib
+QT += network
+QT -= gui
+DEPENDPATH += . ../shared ../..
+INCLUDEPATH += . ../shared ../..
+
+HEADERS += ../shared/rspstub.h ../../gdbremote.h
+SOURCES += tst_gdbremote.cpp ../shared/rspstub.cpp ../../gdbremote.cpp
@@ -0,0 +1,234 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gdbremote.h"
+#include "rspstub.h"
+#include <QtTest/QtTest>
+
+static const quint32 Base = 0x20000000;
+static const int Size = 64 * 1024;
+
+
+// GdbRemote against an RSP stub: negotiation, reads and writes split into
+// packets of the size the server allows, escaping, the M fallback, monitor
+// commands, target errors and cancelled transfers.
+class tst_GdbRemote : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void negotiation();
+    void packetSizeLimit();
+    void read();
+    void writeBinary();
+    void writeHex();
+    void withAcks();
+    void monitor();
+    void targetError();
+    void cancelWrite();
+    void cancelQueued();
+    void detach();
+
+private:
+    bool connectGdb();
+    static bool waitFor(QSignalSpy &spy);
+    static QByteArray allBytes(int size);
+
+    RspStub *stub;
+    GdbRemote *gdb;
+};
+
+
+void tst_GdbRemote::init()
+{
+    stub = new RspStub(Base, Size);
+    stub->setPacketSize(0x400);
+    QVERIFY(stub->listen());
+    gdb = new GdbRemote;
+}
+
+void tst_GdbRemote::cleanup()
+{
+    delete gdb;
+    delete stub;
+}
+
+bool tst_GdbRemote::connectGdb()
+{
+    QSignalSpy connected(gdb, SIGNAL(connected()));
+    gdb->connectToHost("127.0.0.1", stub->port());
+    return waitFor(connected) && gdb->isConnected();
+}
+
+bool tst_GdbRemote::waitFor(QSignalSpy &spy)
+{
+    for (int i = 0; i < 200 && spy.isEmpty(); i++)
+        QTest::qWait(10);
+    return !spy.isEmpty();
+}
+
+// every byte value, the ones X has to escape included
+QByteArray tst_GdbRemote::allBytes(int size)
+{
+    QByteArray bytes(size, 0);
+    for (int i = 0; i < size; i++)
+        bytes[i] = char(i * 7 + i / 256);
+    return bytes;
+}
+
+void tst_GdbRemote::negotiation()
+{
+    QVERIFY(connectGdb());
+    QCOMPARE(gdb->packetSize(), 0x400);
+    QCOMPARE(stub->packets(), 2);	// qSupported, QStartNoAckMode
+}
+
+void tst_GdbRemote::packetSizeLimit()
+{
+    stub->setPacketSize(0x100000);
+    QVERIFY(connectGdb());
+    QCOMPARE(gdb->packetSize(), 64 * 1024);
+}
+
+void tst_GdbRemote::read()
+{
+    QVERIFY(connectGdb());
+    stub->setMemory(allBytes(Size));
+    QSignalSpy read(gdb, SIGNAL(memoryRead(quint32, QByteArray)));
+    gdb->readMemory(Base + 3, 9000);
+    QVERIFY(waitFor(read));
+    QCOMPARE(read.at(0).at(0).toUInt(), Base + 3);
+    QVERIFY(read.at(0).at(1).toByteArray() == allBytes(Size).mid(3, 9000));
+    // two hex characters per byte in a reply of at most 0x400
+    QCOMPARE(stub->packets() - 2, (9000 + 509) / 510);
+}
+
+void tst_GdbRemote::writeBinary()
+{
+    QVERIFY(connectGdb());
+    QSignalSpy written(gdb, SIGNAL(memoryWritten(quint32, qint64)));
+    const QByteArray bytes = allBytes(20000);
+    gdb->writeMemory(Base + 1, bytes);
+    QVERIFY(waitFor(written));
+    QCOMPARE(written.at(0).at(1).toLongLong(), qint64(bytes.size()));
+    QVERIFY(stub->memory().mid(1, bytes.size()) == bytes);
+    QVERIFY(stub->memory().at(0) == 0);
+    QVERIFY(stub->largestPacket() <= 0x400);
+}
+
+void tst_GdbRemote::writeHex()
+{
+    stub->setBinaryWrite(false);	// X unknown, M it is
+    QVERIFY(connectGdb());
+    QSignalSpy written(gdb, SIGNAL(memoryWritten(quint32, qint64)));
+    const QByteArray bytes = allBytes(3000);
+    gdb->writeMemory(Base, bytes);
+    QVERIFY(waitFor(written));
+    QVERIFY(stub->memory().left(bytes.size()) == bytes);
+    QVERIFY(stub->largestPacket() <= 0x400);
+}
+
+void tst_GdbRemote::withAcks()
+{
+    stub->setNoAck(false);
+    QVERIFY(connectGdb());
+    QSignalSpy written(gdb, SIGNAL(memoryWritten(quint32, qint64)));
+    QSignalSpy read(gdb, SIGNAL(memoryRead(quint32, QByteArray)));
+    gdb->writeMemory(Base, "acknowledged");
+    gdb->readMemory(Base, 12);
+    QVERIFY(waitFor(read));
+    QCOMPARE(written.count(), 1);
+    QCOMPARE(read.at(0).at(1).toByteArray(), QByteArray("acknowledged"));
+}
+
+void tst_GdbRemote::monitor()
+{
+    QVERIFY(connectGdb());
+    QSignalSpy output(gdb, SIGNAL(output(QString)));
+    QSignalSpy finished(gdb, SIGNAL(monitorFinished(QString)));
+    gdb->monitor("soft_reset_halt");
+    QVERIFY(waitFor(finished));
+    QCOMPARE(finished.at(0).at(0).toString(), QString("soft_reset_halt"));
+    QCOMPARE(output.count(), 1);
+    QCOMPARE(output.at(0).at(0).toString(), QString("monitor done\n"));
+    QCOMPARE(stub->monitorCommands(), QStringList() << "soft_reset_halt");
+}
+
+void tst_GdbRemote::targetError()
+{
+    QVERIFY(connectGdb());
+    QSignalSpy error(gdb, SIGNAL(error(QString)));
+    QSignalSpy read(gdb, SIGNAL(memoryRead(quint32, QByteArray)));
+    gdb->readMemory(Base + Size - 4, 8);	// runs off the end
+    gdb->readMemory(Base, 4);		// dropped with the failed one
+    QVERIFY(waitFor(error));
+    QVERIFY(error.at(0).at(0).toString().contains("Target error"));
+    QVERIFY(!gdb->isBusy());
+    QVERIFY(gdb->isConnected());
+    QTest::qWait(50);
+    QCOMPARE(read.count(), 0);
+}
+
+void tst_GdbRemote::cancelWrite() // the packet in flight ends it, no memoryWritten for the cut write
+{
+    stub->setDelay(50);
+    QVERIFY(connectGdb());
+    QSignalSpy written(gdb, SIGNAL(memoryWritten(quint32, qint64)));
+    QSignalSpy cancelled(gdb, SIGNAL(cancelled(quint32, qint64)));
+    const QByteArray bytes = allBytes(20000);
+    gdb->writeMemory(Base, bytes);
+    gdb->writeMemory(Base + 0x8000, bytes);
+    gdb->cancel();
+    QVERIFY(cancelled.isEmpty());		// not before the server answered
+    QVERIFY(waitFor(cancelled));
+    QCOMPARE(cancelled.at(0).at(0).toUInt(), Base);
+    qint64 done = cancelled.at(0).at(1).toLongLong();
+    QVERIFY(done > 0 && done < bytes.size());
+    QVERIFY(!gdb->isBusy());
+    QTest::qWait(150);
+    QCOMPARE(written.count(), 0);
+    QCOMPARE(cancelled.count(), 1);
+    QVERIFY(stub->memory().left(done) == bytes.left(done));
+    QVERIFY(stub->memory().mid(done, 0x8000 - done) == QByteArray(0x8000 - done, 0));
+}
+
+void tst_GdbRemote::cancelQueued() // nothing on the wire yet, cancelled at once
+{
+    QSignalSpy cancelled(gdb, SIGNAL(cancelled(quint32, qint64)));
+    gdb->writeMemory(Base, "queued");	// waits for the connection
+    gdb->cancel();
+    QCOMPARE(cancelled.count(), 1);
+    QCOMPARE(cancelled.at(0).at(1).toLongLong(), qint64(0));
+    QVERIFY(!gdb->isBusy());
+    gdb->cancel();			// idle, nothing to report
+    QCOMPARE(cancelled.count(), 1);
+}
+
+void tst_GdbRemote::detach()
+{
+    QVERIFY(connectGdb());
+    gdb->close();
+    for (int i = 0; i < 100 && !stub->isDetached(); i++)
+        QTest::qWait(10);
+    QVERIFY(stub->isDetached());
+}
+
+QTEST_MAIN(tst_GdbRemote)
+#include "tst_gdbremote.moc"
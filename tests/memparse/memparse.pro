@@ -0,0 +1,9 @@
+TEMPLATE = app
+TARGET = tst_memparse
+CONFIG += qtestlib
+QT -= gui
+DEPENDPATH += . ../..
+INCLUDEPATH += . ../..
+
+HEADERS += ../../memparse.h
+SOURCES += tst_memparse.cpp ../../memparse.cpp
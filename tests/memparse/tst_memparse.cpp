@@ -0,0 +1,219 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "memparse.h"
+#include <QtTest/QtTest>
+
+static const char WordDump[] =
+    "mdw 0x00200000 6\r\n"
+    "0x00200000: deadbeef 00000000 cafebabe 12345678 \r\n"
+    "0x00200010: 00000001 FFFFFFFF \r\n"
+    "\r\n";
+
+
+// The parser of mdw/mdh/mdb dumps and Tcl value lists.
+class tst_MemoryParser : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void words();
+    void halfwords();
+    void bytes();
+    void countLimit();
+    void otherLines();
+    void addressGap();
+    void widthMismatch();
+    void chunked();
+    void list();
+    void invalidToken();
+    void dump();
+    void vectorised();
+};
+
+
+void tst_MemoryParser::words()
+{
+    MemoryParser parser(0x00200000, 4);
+    quint32 values[8];
+    QCOMPARE(parser.parseDump(WordDump, sizeof(WordDump) - 1, values, 8), 6);
+    QVERIFY(!parser.hasError());
+    QCOMPARE(values[0], quint32(0xdeadbeef));
+    QCOMPARE(values[1], quint32(0x00000000));
+    QCOMPARE(values[2], quint32(0xcafebabe));
+    QCOMPARE(values[3], quint32(0x12345678));
+    QCOMPARE(values[4], quint32(0x00000001));
+    QCOMPARE(values[5], quint32(0xffffffff));
+    QCOMPARE(parser.nextAddress(), quint32(0x00200018));
+}
+
+void tst_MemoryParser::halfwords()
+{
+    const char text[] = "0x00000100: beef dead 0001 \r\n";
+    MemoryParser parser(0x100, 2);
+    quint16 values[4];
+    QCOMPARE(parser.parseDump(text, sizeof(text) - 1, values, 4), 3);
+    QCOMPARE(values[0], quint16(0xbeef));
+    QCOMPARE(values[1], quint16(0xdead));
+    QCOMPARE(values[2], quint16(0x0001));
+    QCOMPARE(parser.nextAddress(), quint32(0x106));
+}
+
+void tst_MemoryParser::bytes()
+{
+    const char text[] = "0x00000100: de ad be ef 01\n0x00000105: 02";
+    MemoryParser parser(0x100, 1);
+    quint8 values[8];
+    QCOMPARE(parser.parseDump(text, sizeof(text) - 1, values, 8), 6);
+    QCOMPARE(values[0], quint8(0xde));
+    QCOMPARE(values[4], quint8(0x01));
+    QCOMPARE(values[5], quint8(0x02));
+    QCOMPARE(parser.nextAddress(), quint32(0x106));
+}
+
+void tst_MemoryParser::countLimit()
+{
+    MemoryParser parser(0x00200000, 4);
+    quint32 values[3];
+    QCOMPARE(parser.parseDump(WordDump, sizeof(WordDump) - 1, values, 3), 3);
+    QCOMPARE(values[2], quint32(0xcafebabe));
+    QCOMPARE(parser.nextAddress(), quint32(0x0020000c));
+}
+
+void tst_MemoryParser::otherLines()
+{
+    const char text[] =
+        "> mdw 0x1000 2\r\n"
+        "target halted due to debug-request\r\n"
+        "\t0x00001000: 00000011 00000022 \r\n"
+        "> ";
+    MemoryParser parser(0x1000, 4);
+    quint32 values[2];
+    QCOMPARE(parser.parseDump(text, sizeof(text) - 1, values, 2), 2);
+    QVERIFY(!parser.hasError());
+    QCOMPARE(values[1], quint32(0x22));
+}
+
+void tst_MemoryParser::addressGap()
+{
+    const char text[] = "0x00000000: 00000001 \n0x00000010: 00000002 \n";
+    MemoryParser parser(0, 4);
+    quint32 values[2];
+    QCOMPARE(parser.parseDump(text, sizeof(text) - 1, values, 2), 1);
+    QVERIFY(parser.hasError());
+    QVERIFY(parser.errorString().contains("0x00000010"));
+    QVERIFY(parser.errorString().contains("0x00000004"));
+}
+
+void tst_MemoryParser::widthMismatch()
+{
+    MemoryParser parser(0x00200000, 2);
+    quint32 values[6];
+    QCOMPARE(parser.parseDump(WordDump, sizeof(WordDump) - 1, values, 6), 0);
+    QVERIFY(parser.hasError());
+}
+
+void tst_MemoryParser::chunked()
+{
+    const char first[] = "0x00001000: 00000001 00000002 \r\n";
+    const char second[] = "mdw 0x1008 2\r\n0x00001008: 00000003 00000004 \r\n";
+    MemoryParser parser(0x1000, 4);
+    quint32 values[4];
+    QCOMPARE(parser.parseDump(first, sizeof(first) - 1, values, 4), 2);
+    QCOMPARE(parser.nextAddress(), quint32(0x1008));
+    QCOMPARE(parser.parseDump(second, sizeof(second) - 1, values + 2, 2), 2);
+    QVERIFY(!parser.hasError());
+    QCOMPARE(values[3], quint32(4));
+    QCOMPARE(parser.nextAddress(), quint32(0x1010));
+}
+
+void tst_MemoryParser::list()
+{
+    const char bytes[] = "0xde 0xAD {be ef}\r\n";
+    MemoryParser byteParser(0, 1);
+    quint8 b[8];
+    QCOMPARE(byteParser.parseList(bytes, sizeof(bytes) - 1, b, 8), 4);
+    QVERIFY(!byteParser.hasError());
+    QCOMPARE(b[1], quint8(0xad));
+    QCOMPARE(b[3], quint8(0xef));
+
+    const char words[] = "{deadbeef 0x12345678}";
+    MemoryParser wordParser(0x100, 4);
+    quint32 w[2];
+    QCOMPARE(wordParser.parseList(words, sizeof(words) - 1, w, 2), 2);
+    QCOMPARE(w[0], quint32(0xdeadbeef));
+    QCOMPARE(w[1], quint32(0x12345678));
+    QCOMPARE(wordParser.nextAddress(), quint32(0x108));
+}
+
+void tst_MemoryParser::invalidToken()
+{
+    const char garbage[] = "0x12 zz 0x34";
+    MemoryParser parser(0, 1);
+    quint8 values[3];
+    QCOMPARE(parser.parseList(garbage, sizeof(garbage) - 1, values, 3), 1);
+    QVERIFY(parser.hasError());
+    QVERIFY(parser.errorString().contains("'zz'"));
+
+    const char wide[] = "0x123";
+    MemoryParser narrow(0, 1);
+    QCOMPARE(narrow.parseList(wide, sizeof(wide) - 1, values, 3), 0);
+    QVERIFY(narrow.hasError());
+}
+
+void tst_MemoryParser::dump()
+{
+    const QString text("0x00000000: 04030201 08070605 \r\n");
+    QCOMPARE(MemoryParser::dump(text, 0, 4, 8), QByteArray("\x01\x02\x03\x04\x05\x06\x07\x08"));
+    QVERIFY(MemoryParser::dump(text, 0, 4, 12).isEmpty());	// short
+    QVERIFY(MemoryParser::dump(text, 4, 4, 8).isEmpty());	// wrong address
+}
+
+void tst_MemoryParser::vectorised()
+{
+    // the SSE2 word pairs have to give what the scalar decoder gives
+    qsrand(1);
+    QByteArray text;
+    quint32 address = 0x20000000;
+    for (int line = 0; line < 64; ++line, address += 16)
+    {
+        text += QString("0x%1:").arg(address, 8, 16, QChar('0')).toLatin1();
+        for (int i = 0; i < 4; ++i)
+        {
+            QByteArray word = QByteArray::number(quint32(qrand()) << 16 ^ quint32(qrand()), 16).rightJustified(8, '0');
+            text += ' ' + (line % 2 ? word.toUpper() : word);
+        }
+        text += line % 3 ? " \r\n" : "\n";
+    }
+    for (int cut = 0; cut < text.size(); cut += 37)
+    {
+        QByteArray part = text;
+        part[cut] = 'g';		// one character wrong each time
+        QVector<quint32> fast(256), slow(256);
+        MemoryParser vector(0x20000000, 4), scalar(0x20000000, 4);
+        scalar.setVectorised(false);
+        int n = vector.parseDump(part.constData(), part.size(), fast.data(), fast.size());
+        QCOMPARE(n, scalar.parseDump(part.constData(), part.size(), slow.data(), slow.size()));
+        QVERIFY(fast.mid(0, n) == slow.mid(0, n));
+        QCOMPARE(vector.nextAddress(), scalar.nextAddress());
+        QCOMPARE(vector.errorString(), scalar.errorString());
+    }
+}
+
+QTEST_APPLESS_MAIN(tst_MemoryParser)
+#include "tst_memparse.moc"
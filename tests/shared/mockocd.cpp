@@ -0,0 +1,371 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mockocd.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QFile>
+#include <QCoreApplication>
+#include <cstdio>
+#if defined (Q_OS_UNIX)
+#  include <sys/types.h>
+#  include <sys/socket.h>
+#endif
+
+static const char IAC = char(255);
+static const char SB = char(250);
+static const char SE = char(240);
+static const char IP = char(244);
+static const int FloodBuffer = 256 * 1024;	// written ahead while flooding
+
+
+MockOcd::MockOcd(Protocol protocol, QObject *parent) : QObject(parent), protocol(protocol),
+    floodAddress(0), delay(0), writeRate(0), commandCount(0), readCount(0), flooded(0), written(0)
+{
+    server = new QTcpServer(this);
+    floodTimer = new QTimer(this);
+    floodTimer->setInterval(0);
+    answerTimer = new QTimer(this);
+    answerTimer->setSingleShot(true);
+    clock.start();
+    connect(server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+    connect(floodTimer, SIGNAL(timeout()), this, SLOT(flood()));
+    connect(answerTimer, SIGNAL(timeout()), this, SLOT(sendAnswer()));
+}
+
+bool MockOcd::listen(quint16 port)
+{
+    return server->listen(QHostAddress::LocalHost, port);
+}
+
+quint16 MockOcd::port() const
+{
+    return server->serverPort();
+}
+
+bool MockOcd::isFlooding() const
+{
+    return floodTimer->isActive();
+}
+
+void MockOcd::setBytes(quint32 address, const QByteArray &data) // little endian into the words of memory
+{
+    for (int i = 0; i < data.size(); i++)
+    {
+        const quint32 at = address + i;
+        const int shift = 8 * (at & 3);
+        quint32 value = memory.value(at & ~3u) & ~(0xffu << shift);
+        memory.insert(at & ~3u, value | (quint32(uchar(data.at(i))) << shift));
+    }
+}
+
+QByteArray MockOcd::bytes(quint32 address, int length) const
+{
+    QByteArray data(length, 0);
+    for (int i = 0; i < length; i++)
+    {
+        const quint32 at = address + i;
+        data[i] = char(memory.value(at & ~3u) >> (8 * (at & 3)));
+    }
+    return data;
+}
+
+int MockOcd::runAsOpenOcd(const QStringList &arguments) // main() of a mock openOCD process, on the ports set with -c
+{
+    MockOcd telnet(Telnet);
+    MockOcd tcl(TclRpc);
+    const qint64 rate = qgetenv("MOCKOCD_WRITE_RATE").toLongLong();
+    telnet.setWriteRate(rate);
+    tcl.setWriteRate(rate);
+
+    for (int i = 0; i + 1 < arguments.size(); i++)
+    {
+        if (arguments.at(i) != "-c")
+            continue;
+        QStringList commands = arguments.at(i + 1).split(';');
+        for (int j = 0; j < commands.size(); j++)
+        {
+            QStringList words = commands.at(j).simplified().split(' ');
+            if (words.size() != 2)
+                continue;
+            MockOcd *mock = words.at(0) == "telnet_port" ? &telnet : words.at(0) == "tcl_port" ? &tcl : 0;
+            if (mock && !mock->listen(words.at(1).toUShort()))
+            {
+                fprintf(stderr, "Error: couldn't bind %s to socket\n", qPrintable(words.at(0)));
+                return 1;
+            }
+            if (mock)
+                fprintf(stderr, "Info : Listening on port %d for %s connections\n", mock->port(),
+                        mock == &tcl ? "tcl" : "telnet");
+        }
+    }
+    return QCoreApplication::exec();
+}
+
+
+
+// private slots:
+void MockOcd::newConnection()
+{
+    QTcpSocket *socket = server->nextPendingConnection();
+    if (client)
+    {
+        socket->close();		// one client at a time
+        socket->deleteLater();
+        return;
+    }
+    client = socket;
+#if defined (Q_OS_UNIX)
+    // the Data Mark of a Synch stays in the stream, as with openOCD
+    const int on = 1;
+    ::setsockopt(client->socketDescriptor(), SOL_SOCKET, SO_OOBINLINE, (const char *)&on, sizeof(on));
+#endif
+    client->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(client, SIGNAL(readyRead()), this, SLOT(readyRead()));
+    connect(client, SIGNAL(disconnected()), client, SLOT(deleteLater()));
+    input.clear();
+    line.clear();
+    lines.clear();
+    answers.clear();
+    due.clear();
+    if (protocol == Telnet)
+        client->write("Open On-Chip Debugger\r\n> ");
+}
+
+void MockOcd::readyRead()
+{
+    input += client->readAll();
+    const int before = commandCount + lines.size();
+    if (protocol == Telnet)
+        parseTelnet();
+    else
+        parseTclRpc();
+    if (commandCount + lines.size() > before)
+        readCount++;
+    runQueued();
+}
+
+void MockOcd::sendAnswer() // all that are due, in the order of their commands
+{
+    while (!answers.isEmpty() && due.head() <= clock.elapsed())
+    {
+        due.dequeue();
+        QByteArray answer = answers.dequeue();
+        if (client)
+            client->write(answer);
+    }
+    if (!answers.isEmpty())
+        answerTimer->start(int(due.head() - clock.elapsed()));
+}
+
+void MockOcd::flood()
+{
+    if (!client)
+    {
+        floodTimer->stop();
+        return;
+    }
+    char text[64];
+    QByteArray block;
+    while (client->bytesToWrite() + block.size() < FloodBuffer)
+    {
+        int length = sprintf(text, "0x%08x: %08x %08x %08x %08x \r\n", floodAddress,
+                             floodAddress, ~floodAddress, floodAddress * 3, floodAddress ^ 0xa5a5a5a5);
+        block.append(text, length);
+        floodAddress += 16;
+    }
+    flooded += block.size();
+    client->write(block);
+}
+
+
+
+// private Funktions:
+void MockOcd::parseTelnet() // commands into lines, IAC sequences answered or dropped
+{
+    int i = 0;
+    while (i < input.size())
+    {
+        char c = input.at(i);
+        if (c == IAC)
+        {
+            if (i + 1 >= input.size())
+                break;
+            char command = input.at(i + 1);
+            if (command == IAC)
+            {
+                line += IAC;
+                i += 2;
+            }
+            else if (command == SB)
+            {
+                int end = input.indexOf(QByteArray(1, IAC) + SE, i + 2);
+                if (end == -1)
+                    break;
+                i = end + 2;
+            }
+            else if (uchar(command) >= 251)	// WILL, WONT, DO, DONT with their option
+            {
+                if (i + 2 >= input.size())
+                    break;
+                i += 3;
+            }
+            else
+            {
+                if (command == IP)
+                    interrupt();
+                i += 2;		// DM and the other two byte commands
+            }
+            continue;
+        }
+        if (c == '\n')
+        {
+            lines.enqueue(line);
+            line.clear();
+        }
+        else if (c != '\r' && c != '\0')
+        {
+            line += c;
+        }
+        i++;
+    }
+    input.remove(0, i);
+}
+
+void MockOcd::parseTclRpc()
+{
+    int end;
+    while ((end = input.indexOf('\x1a')) != -1)
+    {
+        lines.enqueue(input.left(end));
+        input.remove(0, end + 1);
+    }
+}
+
+void MockOcd::runQueued() // everything received in one read is answered at once
+{
+    QByteArray answer;
+    int wait = delay;
+    while (!lines.isEmpty() && !isFlooding())
+    {
+        QByteArray command = lines.dequeue();
+        commandCount++;
+        QByteArray output = run(command.trimmed(), &wait);
+        if (protocol == Telnet)
+            answer += command + "\r\n" + output + (isFlooding() ? "" : "> ");
+        else
+            answer += output + '\x1a';
+    }
+    if (answer.isEmpty() || !client)
+        return;
+    if ((wait <= 0 && answers.isEmpty()) || isFlooding())	// the echo goes out before the flood
+    {
+        client->write(answer);
+        return;
+    }
+    // never before an answer still waiting, a server answers in order
+    answers.enqueue(answer);
+    due.enqueue(qMax(clock.elapsed() + wait, due.isEmpty() ? 0 : due.last()));
+    if (!answerTimer->isActive())
+        answerTimer->start(wait);
+}
+
+QByteArray MockOcd::run(const QByteArray &command, int *wait) // the output of one command
+{
+    QList<QByteArray> words = command.simplified().split(' ');
+    const QByteArray name = words.at(0);
+    bool ok = true;
+    QByteArray output;
+
+    if (name == "mdw" && words.size() >= 2)
+    {
+        quint32 address = words.at(1).toUInt(&ok, 0);
+        int count = words.size() > 2 ? words.at(2).toInt(&ok, 0) : 1;
+        char text[16];
+        for (int i = 0; ok && i < count; i++)
+        {
+            if (i % 8 == 0)		// eight words to a line, as openOCD prints them
+            {
+                if (i)
+                    output += " \r\n";
+                sprintf(text, "0x%08x:", address + 4 * i);
+                output += text;
+            }
+            sprintf(text, " %08x", memory.value(address + 4 * i));
+            output += text;
+        }
+        output += " \r\n";
+    }
+    else if (name == "mww" && words.size() >= 3)
+    {
+        quint32 address = words.at(1).toUInt(&ok, 0);
+        quint32 value = words.at(2).toUInt(&ok, 0);
+        int count = words.size() > 3 ? words.at(3).toInt(&ok, 0) : 1;
+        for (int i = 0; ok && i < count; i++)
+            memory.insert(address + 4 * i, value);
+    }
+    else if (name == "echo")
+    {
+        output = command.mid(5) + "\r\n";
+    }
+    else if (name == "flood")
+    {
+        floodTimer->start();
+    }
+    else if (name == "load_image" || name == "write_image" || (name == "flash" && words.value(1) == "write_image"))
+    {
+        int file = name == "flash" ? 2 : 1;
+        if (words.value(file) == "erase")
+            file++;
+        QFile image(QString::fromLocal8Bit(words.value(file)));
+        if (!image.open(QIODevice::ReadOnly))
+            return "Error: couldn't open " + words.value(file) + "\r\n";
+        QByteArray data = image.readAll();
+        setBytes(words.value(file + 1, "0").toUInt(&ok, 0), data);
+        written += data.size();
+        if (writeRate > 0)
+            *wait += int(data.size() * 1000 / writeRate);
+        output = "wrote " + QByteArray::number(data.size()) + " bytes from file " + words.value(file) + "\r\n";
+    }
+    else if (name == "verify_image" || name == "verify_image_checksum")
+    {
+        QFile image(QString::fromLocal8Bit(words.value(1)));
+        if (!image.open(QIODevice::ReadOnly))
+            return "Error: couldn't open " + words.value(1) + "\r\n";
+        QByteArray data = image.readAll();
+        quint32 address = words.value(2, "0").toUInt(&ok, 0);
+        if (ok && bytes(address, data.size()) == data)
+            output = "verified " + QByteArray::number(data.size()) + " bytes in 0.000000s\r\n";
+        else if (ok)
+            output = name == "verify_image" ? "checksum mismatch - attempting binary compare\r\nError: verify failed\r\n"
+                                            : "Error: checksum mismatch\r\n";
+    }
+    if (!ok)
+        return "Error: invalid command argument\r\n";
+    return output;
+}
+
+void MockOcd::interrupt() // IAC IP: the running command ends, with its prompt
+{
+    if (!isFlooding())
+        return;
+    floodTimer->stop();
+    if (client)
+        client->write("\r\n> ");
+}
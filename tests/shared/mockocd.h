@@ -0,0 +1,101 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MOCKOCD_H
+#define MOCKOCD_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QStringList>
+#include <QQueue>
+#include <QHash>
+#include <QPointer>
+#include <QElapsedTimer>
+
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+
+// Stands in for openOCD on a local port: its telnet server (banner, echo
+// and the "> " prompt, IAC IP stops the running command) or its Tcl RPC
+// server (every command and result terminated by 0x1a). It knows mdw and
+// mww on a memory of its own, load_image and write_image into that memory
+// at a given rate, verify_image and verify_image_checksum against it, echo,
+// and "flood", which prints memory lines until interrupted. Anything else
+// is answered with no output.
+class MockOcd : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Protocol { Telnet, TclRpc };
+
+    MockOcd(Protocol protocol, QObject *parent = 0);
+
+    bool listen(quint16 port = 0);
+    quint16 port() const;
+    void setDelay(int ms) { delay = ms; }	// before every answer, a round trip on a real link
+    void setWriteRate(qint64 bytes) { writeRate = bytes; }	// of images per second, 0 for no wait
+    void setWord(quint32 address, quint32 value) { memory.insert(address, value); }
+    quint32 word(quint32 address) const { return memory.value(address); }
+    void setBytes(quint32 address, const QByteArray &data);
+    QByteArray bytes(quint32 address, int length) const;
+
+    int commands() const { return commandCount; }
+    int reads() const { return readCount; }	// socket reads that brought commands
+    qint64 floodBytes() const { return flooded; }
+    qint64 writtenBytes() const { return written; }	// by image writes
+    bool isFlooding() const;
+
+    static int runAsOpenOcd(const QStringList &arguments);
+
+private slots:
+    void newConnection();
+    void readyRead();
+    void sendAnswer();
+    void flood();
+
+private:
+    void parseTelnet();
+    void parseTclRpc();
+    void runQueued();
+    QByteArray run(const QByteArray &line, int *wait);
+    void interrupt();
+
+    Protocol protocol;
+    QTcpServer *server;
+    QPointer<QTcpSocket> client;
+    QTimer *floodTimer;
+    QByteArray input;		// not parsed yet
+    QByteArray line;		// telnet command being received
+    QQueue<QByteArray> lines;	// commands waiting for a flood to end
+    QQueue<QByteArray> answers;	// waiting for their delay
+    QQueue<qint64> due;		// ms on clock when each answer goes out
+    QElapsedTimer clock;
+    QTimer *answerTimer;
+    QHash<quint32, quint32> memory;
+    quint32 floodAddress;
+    int delay;
+    qint64 writeRate;
+    int commandCount;
+    int readCount;
+    qint64 flooded;
+    qint64 written;
+};
+
+#endif // MOCKOCD_H
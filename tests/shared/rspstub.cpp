@@ -0,0 +1,179 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "rspstub.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+
+RspStub::RspStub(quint32 base, int size, QObject *parent) : QObject(parent), base(base), data(size, 0),
+    packetSize(0x4000), delay(0), offerNoAck(true), noAck(false), binaryWrite(true), detached(false),
+    packetCount(0), largest(0)
+{
+    server = new QTcpServer(this);
+    connect(server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+}
+
+bool RspStub::listen(quint16 port)
+{
+    return server->listen(QHostAddress::LocalHost, port);
+}
+
+quint16 RspStub::port() const
+{
+    return server->serverPort();
+}
+
+
+
+// private slots:
+void RspStub::newConnection()
+{
+    QTcpSocket *socket = server->nextPendingConnection();
+    if (client)
+    {
+        socket->close();		// one debugger at a time
+        socket->deleteLater();
+        return;
+    }
+    client = socket;
+    client->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(client, SIGNAL(readyRead()), this, SLOT(readyRead()));
+    connect(client, SIGNAL(disconnected()), client, SLOT(deleteLater()));
+    received.clear();
+    replies.clear();
+    noAck = false;
+    detached = false;
+}
+
+void RspStub::readyRead()
+{
+    received += client->readAll();
+    while (!received.isEmpty())
+    {
+        if (received.at(0) != '$')		// acks and anything between packets
+        {
+            received.remove(0, 1);
+            continue;
+        }
+        int end = received.indexOf('#');	// never in a payload, X escapes it
+        if (end == -1 || received.size() < end + 3)
+            return;
+        QByteArray payload = received.mid(1, end - 1);
+        bool ok;
+        int sum = received.mid(end + 1, 2).toInt(&ok, 16);
+        largest = qMax(largest, end + 3);
+        received.remove(0, end + 3);
+
+        quint8 check = 0;
+        for (int i = 0; i < payload.size(); i++)
+            check += quint8(payload.at(i));
+        if (!ok || check != sum)
+        {
+            client->write("-");
+            continue;
+        }
+        if (!noAck)
+            client->write("+");
+        packetCount++;
+        QByteArray answer = handle(payload);
+        if (payload != "D")
+            reply(answer);
+        else
+            detached = true;
+        if (payload == "QStartNoAckMode")
+            noAck = true;		// from the next packet on
+    }
+}
+
+void RspStub::sendReply()
+{
+    if (!replies.isEmpty() && client)
+        client->write(replies.dequeue());
+}
+
+
+
+// private Funktions:
+QByteArray RspStub::handle(const QByteArray &payload) // the reply to one packet
+{
+    if (payload.startsWith("qSupported"))
+        return "PacketSize=" + QByteArray::number(packetSize, 16) + (offerNoAck ? ";QStartNoAckMode+" : "");
+    if (payload == "QStartNoAckMode")
+        return offerNoAck ? "OK" : "";
+    if (payload.startsWith("qRcmd,"))
+    {
+        monitors << QString::fromLocal8Bit(QByteArray::fromHex(payload.mid(6)));
+        reply("O" + QByteArray("monitor done\n").toHex());
+        return "OK";
+    }
+
+    const char type = payload.at(0);
+    if (type != 'm' && type != 'M' && type != 'X')
+        return "";			// not supported
+    if (type == 'X' && !binaryWrite)
+        return "";
+    int comma = payload.indexOf(',');
+    int colon = payload.indexOf(':');
+    if (comma == -1 || (type != 'm' && colon < comma))
+        return "E01";
+    bool ok1, ok2;
+    quint32 address = payload.mid(1, comma - 1).toUInt(&ok1, 16);
+    int length = payload.mid(comma + 1, colon == -1 ? -1 : colon - comma - 1).toInt(&ok2, 16);
+    if (!ok1 || !ok2 || !inRange(address, length))
+        return "E01";
+    const int offset = int(address - base);
+
+    if (type == 'm')
+        return data.mid(offset, length).toHex();
+    QByteArray bytes;
+    if (type == 'M')
+    {
+        bytes = QByteArray::fromHex(payload.mid(colon + 1));
+    }
+    else
+    {
+        for (int i = colon + 1; i < payload.size(); i++)
+            bytes += payload.at(i) == '}' && i + 1 < payload.size() ? char(payload.at(++i) ^ 0x20) : payload.at(i);
+    }
+    if (bytes.size() != length)
+        return "E02";
+    data.replace(offset, length, bytes);
+    return "OK";
+}
+
+bool RspStub::inRange(quint32 address, int length) const
+{
+    return length >= 0 && address >= base && qint64(address) - base + length <= data.size();
+}
+
+void RspStub::reply(const QByteArray &payload)
+{
+    quint8 sum = 0;
+    for (int i = 0; i < payload.size(); i++)
+        sum += quint8(payload.at(i));
+    QByteArray packet = '$' + payload + '#' + QByteArray::number(sum, 16).rightJustified(2, '0');
+    if (delay <= 0 && replies.isEmpty())
+    {
+        client->write(packet);
+        return;
+    }
+    replies.enqueue(packet);	// the same delay for all, so in order
+    QTimer::singleShot(delay, this, SLOT(sendReply()));
+}
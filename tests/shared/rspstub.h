@@ -0,0 +1,82 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RSPSTUB_H
+#define RSPSTUB_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QStringList>
+#include <QQueue>
+#include <QPointer>
+
+class QTcpServer;
+class QTcpSocket;
+
+// The gdb remote protocol as openOCD's gdb_port speaks it, on a memory
+// range of its own: qSupported with PacketSize, QStartNoAckMode, m, M, X,
+// qRcmd and D. Accesses outside of the range are answered with E01.
+class RspStub : public QObject
+{
+    Q_OBJECT
+
+public:
+    RspStub(quint32 base, int size, QObject *parent = 0);
+
+    bool listen(quint16 port = 0);
+    quint16 port() const;
+    void setPacketSize(int bytes) { packetSize = bytes; }
+    void setDelay(int ms) { delay = ms; }	// before every reply, a round trip on a real link
+    void setNoAck(bool offer) { offerNoAck = offer; }
+    void setBinaryWrite(bool on) { binaryWrite = on; }	// else X is answered as unknown
+
+    QByteArray memory() const { return data; }
+    void setMemory(const QByteArray &bytes) { data = bytes; }
+    int packets() const { return packetCount; }
+    int largestPacket() const { return largest; }	// received, with "$#xx"
+    QStringList monitorCommands() const { return monitors; }
+    bool isDetached() const { return detached; }
+
+private slots:
+    void newConnection();
+    void readyRead();
+    void sendReply();
+
+private:
+    QByteArray handle(const QByteArray &payload);
+    bool inRange(quint32 address, int length) const;
+    void reply(const QByteArray &payload);
+
+    QTcpServer *server;
+    QPointer<QTcpSocket> client;
+    QByteArray received;
+    QQueue<QByteArray> replies;	// waiting for their delay
+    quint32 base;
+    QByteArray data;
+    int packetSize;
+    int delay;
+    bool offerNoAck;
+    bool noAck;
+    bool binaryWrite;
+    bool detached;
+    int packetCount;
+    int largest;
+    QStringList monitors;
+};
+
+#endif // RSPSTUB_H
@@ -0,0 +1,9 @@
+TEMPLATE = app
+TARGET = tst_snapshot
+CONFIG += qtestlib
+QT += network
+DEPENDPATH += . ../.. ../../QtTelnet
+INCLUDEPATH += . ../.. ../../QtTelnet
+
+HEADERS += ../../snapshot.h ../../memparse.h ../../ocdtransport.h ../../spscqueue.h ../../QtTelnet/qttelnet.h
+SOURCES += tst_snapshot.cpp ../../snapshot.cpp ../../memparse.cpp ../../ocdtransport.cpp ../../QtTelnet/qttelnet.cpp
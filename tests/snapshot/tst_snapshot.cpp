@@ -0,0 +1,228 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snapshot.h"
+#include <QtTest/QtTest>
+#include <QDir>
+#include <QFile>
+
+
+// Snapshot::diff against a word by word comparison, and the file format.
+class tst_Snapshot : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void identical();
+    void singleWord();
+    void adjacentWords();
+    void separateRuns();
+    void maxRuns();
+    void offsetRanges();
+    void disjointRanges();
+    void randomChanges();
+    void saveLoad();
+    void loadHeaderOnly();
+    void loadGarbage();
+
+private:
+    static Snapshot filled(quint32 address, int bytes);
+    static void setWord(Snapshot &snapshot, quint32 address, quint32 value);
+    static QList<Snapshot::Run> naiveDiff(const Snapshot &before, const Snapshot &after);
+};
+
+
+Snapshot tst_Snapshot::filled(quint32 address, int bytes)
+{
+    Snapshot snapshot;
+    snapshot.address = address;
+    snapshot.size = bytes;
+    snapshot.data.resize(bytes);
+    for (int i = 0; i < bytes; ++i)
+        snapshot.data[i] = char(i * 7 + 3);
+    return snapshot;
+}
+
+void tst_Snapshot::setWord(Snapshot &snapshot, quint32 address, quint32 value)
+{
+    memcpy(snapshot.data.data() + (address - snapshot.address), &value, 4);
+}
+
+QList<Snapshot::Run> tst_Snapshot::naiveDiff(const Snapshot &before, const Snapshot &after)
+{
+    QList<Snapshot::Run> runs;
+    for (int i = 0; i + 4 <= before.data.size(); i += 4)
+    {
+        if (!memcmp(before.data.constData() + i, after.data.constData() + i, 4))
+            continue;
+        if (!runs.isEmpty() && runs.last().address + 4 * runs.last().words == before.address + i)
+        {
+            runs.last().words++;
+        }
+        else
+        {
+            Snapshot::Run run = { before.address + i, 1 };
+            runs << run;
+        }
+    }
+    return runs;
+}
+
+void tst_Snapshot::identical()
+{
+    Snapshot a = filled(0x20000000, 4096);
+    QVERIFY(Snapshot::diff(a, a).isEmpty());
+}
+
+void tst_Snapshot::singleWord()
+{
+    Snapshot a = filled(0x20000000, 4096);
+    Snapshot b = a;
+    setWord(b, 0x20000804, 0xdeadbeef);
+    QList<Snapshot::Run> runs = Snapshot::diff(a, b);
+    QCOMPARE(runs.size(), 1);
+    QCOMPARE(runs.at(0).address, quint32(0x20000804));
+    QCOMPARE(runs.at(0).words, 1);
+}
+
+void tst_Snapshot::adjacentWords()
+{
+    Snapshot a = filled(0x20000000, 4096);
+    Snapshot b = a;
+    for (quint32 address = 0x2000003c; address < 0x20000048; address += 4)	// over a cache line
+        setWord(b, address, 0);
+    QList<Snapshot::Run> runs = Snapshot::diff(a, b);
+    QCOMPARE(runs.size(), 1);
+    QCOMPARE(runs.at(0).address, quint32(0x2000003c));
+    QCOMPARE(runs.at(0).words, 3);
+}
+
+void tst_Snapshot::separateRuns()
+{
+    Snapshot a = filled(0, 256);
+    Snapshot b = a;
+    setWord(b, 0x00, 1);
+    setWord(b, 0x08, 1);
+    setWord(b, 0xfc, 1);
+    QList<Snapshot::Run> runs = Snapshot::diff(a, b);
+    QCOMPARE(runs.size(), 3);
+    QCOMPARE(runs.at(0).address, quint32(0x00));
+    QCOMPARE(runs.at(1).address, quint32(0x08));
+    QCOMPARE(runs.at(2).address, quint32(0xfc));
+    QCOMPARE(runs.at(2).words, 1);
+}
+
+void tst_Snapshot::maxRuns()
+{
+    Snapshot a = filled(0, 1024);
+    Snapshot b = a;
+    for (quint32 address = 0; address < 1024; address += 8)
+        setWord(b, address, 0xffffffff);
+    QCOMPARE(Snapshot::diff(a, b).size(), 128);
+    QCOMPARE(Snapshot::diff(a, b, 10).size(), 10);
+}
+
+void tst_Snapshot::offsetRanges()
+{
+    // only the range both cover is compared, addresses are the target's
+    Snapshot a = filled(0x1000, 256);
+    Snapshot b = filled(0x1080, 256);
+    memcpy(b.data.data(), a.data.constData() + 0x80, 0x80);
+    setWord(b, 0x10a0, 0);
+    setWord(b, 0x1100, 0);		// outside of a
+    QList<Snapshot::Run> runs = Snapshot::diff(a, b);
+    QCOMPARE(runs.size(), 1);
+    QCOMPARE(runs.at(0).address, quint32(0x10a0));
+    QCOMPARE(Snapshot::diff(b, a).size(), 1);
+}
+
+void tst_Snapshot::disjointRanges()
+{
+    QVERIFY(Snapshot::diff(filled(0, 256), filled(0x100, 256)).isEmpty());
+}
+
+void tst_Snapshot::randomChanges()
+{
+    qsrand(1);
+    for (int round = 0; round < 200; ++round)
+    {
+        Snapshot a = filled(0x20000000, 4 * (1 + qrand() % 600));
+        Snapshot b = a;
+        for (int n = qrand() % 20; n > 0; --n)
+        {
+            int word = qrand() % (a.data.size() / 4);
+            for (int length = qrand() % 5; length >= 0 && word < a.data.size() / 4; --length, ++word)
+                b.data[4 * word + qrand() % 4] ^= char(1 + qrand() % 255);
+        }
+        QList<Snapshot::Run> runs = Snapshot::diff(a, b);
+        QList<Snapshot::Run> expected = naiveDiff(a, b);
+        QCOMPARE(runs.size(), expected.size());
+        for (int i = 0; i < runs.size(); ++i)
+        {
+            QCOMPARE(runs.at(i).address, expected.at(i).address);
+            QCOMPARE(runs.at(i).words, expected.at(i).words);
+        }
+    }
+}
+
+void tst_Snapshot::saveLoad()
+{
+    Snapshot a = filled(0x00200000, 65536);
+    a.name = "after reset";
+    a.when = QDateTime(QDate(2013, 11, 8), QTime(17, 11, 49));
+    const QString fileName = QDir::temp().filePath("tst_snapshot.oosn");
+    QVERIFY(a.save(fileName));
+
+    Snapshot b;
+    QVERIFY(b.load(fileName));
+    QFile::remove(fileName);
+    QCOMPARE(b.name, a.name);
+    QCOMPARE(b.address, a.address);
+    QCOMPARE(b.size, a.size);
+    QCOMPARE(b.when, a.when);
+    QCOMPARE(b.file, fileName);
+    QVERIFY(b.data == a.data);
+}
+
+void tst_Snapshot::loadHeaderOnly()
+{
+    Snapshot a = filled(0x1000, 4096);
+    const QString fileName = QDir::temp().filePath("tst_snapshot.oosn");
+    QVERIFY(a.save(fileName));
+    Snapshot b;
+    QVERIFY(b.load(fileName, false));
+    QFile::remove(fileName);
+    QCOMPARE(b.size, quint32(4096));
+    QVERIFY(b.data.isEmpty());
+}
+
+void tst_Snapshot::loadGarbage()
+{
+    const QString fileName = QDir::temp().filePath("tst_snapshot.oosn");
+    QFile out(fileName);
+    QVERIFY(out.open(QIODevice::WriteOnly));
+    out.write("no snapshot at all");
+    out.close();
+    Snapshot b;
+    QVERIFY(!b.load(fileName));
+    QFile::remove(fileName);
+    QVERIFY(!b.load(fileName));		// missing
+}
+
+QTEST_APPLESS_MAIN(tst_Snapshot)
+#include "tst_snapshot.moc"
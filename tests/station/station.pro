@@ -0,0 +1,9 @@
+TEMPLATE = app
+TARGET = tst_station
+CONFIG += qtestlib
+QT += network
+DEPENDPATH += . ../shared ../.. ../../QtTelnet
+INCLUDEPATH += . ../shared ../.. ../../QtTelnet
+
+HEADERS += ../shared/mockocd.h ../../station.h ../../ocdtransport.h ../../spscqueue.h ../../QtTelnet/qttelnet.h
+SOURCES += tst_station.cpp ../shared/mockocd.cpp ../../station.cpp ../../ocdtransport.cpp ../../QtTelnet/qttelnet.cpp
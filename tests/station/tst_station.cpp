@@ -0,0 +1,237 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "station.h"
+#include "mockocd.h"
+#include <QtTest/QtTest>
+#include <QTemporaryFile>
+#include <QTcpServer>
+
+static const qint64 ImageSize = 512 * 1024;	// bytes per board
+static const qint64 WriteRate = 1024 * 1024;	// bytes/s of every mock adapter
+static const int ImageMs = ImageSize * 1000 / WriteRate;
+
+
+// StationTarget against N local mock openOCD processes: this binary is
+// started in place of openOCD (see main()), every target gets its own
+// process and ports, and the boards are flashed side by side.
+class tst_Station : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanup();
+    void single();
+    void missingImage();
+    void stopWithoutWaiting();
+    void parallel_data();
+    void parallel();
+
+private:
+    void startTargets(int count);
+    static quint16 freePorts(int count);
+    bool waitFinished(const QList<QSignalSpy *> &spies, int ms);
+    QStringList flashCommands(const QString &file) const;
+
+    QTemporaryFile image;
+    QList<StationTarget *> targets;
+};
+
+
+void tst_Station::initTestCase()
+{
+    qputenv("MOCKOCD_WRITE_RATE", QByteArray::number(WriteRate));
+    QVERIFY(image.open());
+    QCOMPARE(image.write(QByteArray(ImageSize, '\xa5')), ImageSize);
+    image.flush();
+}
+
+void tst_Station::cleanup()
+{
+    qDeleteAll(targets);		// stops the mock processes
+    targets.clear();
+}
+
+void tst_Station::single()
+{
+    startTargets(1);
+    StationTarget *target = targets.first();
+    QCOMPARE(target->tclPort(), quint16(target->telnetPort() + 2));
+
+    QSignalSpy spy(target, SIGNAL(finished(bool)));
+    target->run(flashCommands(image.fileName()), QList<qint64>() << 0 << ImageSize << 0);
+    QCOMPARE(target->state(), StationTarget::Busy);
+    QVERIFY(waitFinished(QList<QSignalSpy *>() << &spy, 10 * ImageMs));
+    QCOMPARE(spy.first().at(0).toBool(), true);
+    QCOMPARE(target->state(), StationTarget::Passed);
+    QCOMPARE(target->done(), ImageSize);
+    QCOMPARE(target->total(), ImageSize);
+    QVERIFY(target->elapsed() >= ImageMs);
+    QVERIFY(target->isReady());		// ready for the next board
+}
+
+void tst_Station::missingImage()
+{
+    startTargets(1);
+    StationTarget *target = targets.first();
+
+    QSignalSpy spy(target, SIGNAL(finished(bool)));
+    target->run(flashCommands(image.fileName() + ".missing"), QList<qint64>() << 0 << ImageSize << 0);
+    QVERIFY(waitFinished(QList<QSignalSpy *>() << &spy, 10 * ImageMs));
+    QCOMPARE(spy.first().at(0).toBool(), false);
+    QCOMPARE(target->state(), StationTarget::Failed);
+    QVERIFY(target->message().startsWith("Error: couldn't open"));
+    QCOMPARE(target->done(), qint64(0));
+}
+
+void tst_Station::stopWithoutWaiting()
+{
+    startTargets(1);
+    StationTarget *target = targets.first();
+
+    QElapsedTimer clock;
+    clock.start();
+    target->stop();
+    QVERIFY(clock.elapsed() < 100);
+    QCOMPARE(target->state(), StationTarget::Stopping);
+    QVERIFY(!target->isReady());
+    for (int i = 0; i < 100 && target->state() != StationTarget::Stopped; i++)
+        QTest::qWait(20);
+    QCOMPARE(target->state(), StationTarget::Stopped);
+
+    target->start();		// the ports are free again
+    for (int i = 0; i < 250 && !target->isReady(); i++)
+        QTest::qWait(40);
+    QVERIFY2(target->isReady(), qPrintable(target->message()));
+}
+
+void tst_Station::parallel_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("1 board") << 1;
+    QTest::newRow("2 boards") << 2;
+    QTest::newRow("4 boards") << 4;
+    QTest::newRow("8 boards") << 8;
+}
+
+void tst_Station::parallel()
+{
+    QFETCH(int, count);
+    startTargets(count);
+
+    QList<QSignalSpy *> spies;
+    QElapsedTimer clock;
+    clock.start();
+    for (int i = 0; i < targets.size(); i++)
+    {
+        spies << new QSignalSpy(targets.at(i), SIGNAL(finished(bool)));
+        targets.at(i)->run(flashCommands(image.fileName()), QList<qint64>() << 0 << ImageSize << 0);
+    }
+    bool finished = waitFinished(spies, 10 * ImageMs);
+    qint64 ms = clock.elapsed();
+    int passed = 0;
+    for (int i = 0; i < spies.size(); i++)
+        passed += spies.at(i)->count() == 1 && spies.at(i)->first().at(0).toBool();
+    qDeleteAll(spies);
+
+    qDebug("%d boards: %lld ms, %.0f boards/hour", count, ms, ms > 0 ? count * 3600000.0 / ms : 0.0);
+    QVERIFY(finished);
+    QCOMPARE(passed, count);
+    QVERIFY2(ms < 3 * ImageMs, "the boards were not flashed in parallel");
+}
+
+
+// private Funktions:
+void tst_Station::startTargets(int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        quint16 port = freePorts(3);		// telnet, gdb and tcl
+        QVERIFY(port != 0);
+        StationTarget *target = new StationTarget("mock.cfg", port);
+        target->setProgram(QCoreApplication::applicationFilePath());
+        target->start();
+        targets << target;
+    }
+    for (int i = 0; i < targets.size(); i++)
+    {
+        for (int n = 0; n < 250 && !targets.at(i)->isReady(); n++)
+            QTest::qWait(40);
+        QVERIFY2(targets.at(i)->isReady(), qPrintable(targets.at(i)->message()));
+    }
+}
+
+quint16 tst_Station::freePorts(int count) // the first of count consecutive ports nobody listens on
+{
+    for (int attempt = 0; attempt < 100; attempt++)
+    {
+        QList<QTcpServer *> servers;
+        servers << new QTcpServer;
+        if (!servers.first()->listen(QHostAddress::LocalHost))
+        {
+            qDeleteAll(servers);
+            return 0;
+        }
+        quint16 first = servers.first()->serverPort();
+        while (servers.size() < count && first + servers.size() <= 0xffff)
+        {
+            servers << new QTcpServer;
+            if (!servers.last()->listen(QHostAddress::LocalHost, first + servers.size() - 1))
+                break;
+        }
+        bool free = servers.size() == count && servers.last()->isListening();
+        qDeleteAll(servers);		// closed again for the mock openOCD
+        if (free)
+            return first;
+    }
+    return 0;
+}
+
+bool tst_Station::waitFinished(const QList<QSignalSpy *> &spies, int ms)
+{
+    QElapsedTimer clock;
+    clock.start();
+    for (int i = 0; i < spies.size(); i++)
+    {
+        while (spies.at(i)->isEmpty() && clock.elapsed() < ms)
+            QTest::qWait(10);
+        if (spies.at(i)->isEmpty())
+            return false;
+    }
+    return true;
+}
+
+QStringList tst_Station::flashCommands(const QString &file) const
+{
+    return QStringList() << "reset halt"
+                         << "flash write_image erase " + file + " 0x08000000"
+                         << "reset run";
+}
+
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    if (app.arguments().contains("-f"))	// started by a StationTarget in place of openOCD
+        return MockOcd::runAsOpenOcd(app.arguments());
+    tst_Station test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_station.moc"
@@ -0,0 +1,10 @@
+TEMPLATE = app
+TARGET = tst_tclrpc
+CONFIG += qtestlib
+QT += network
+QT -= gui
+DEPENDPATH += . ../shared ../.. ../../QtTelnet
+INCLUDEPATH += . ../shared ../.. ../../QtTelnet
+
+HEADERS += ../shared/mockocd.h ../../ocdtransport.h ../../spscqueue.h ../../QtTelnet/qttelnet.h
+SOURCES += tst_tclrpc.cpp ../shared/mockocd.cpp ../../ocdtransport.cpp ../../QtTelnet/qttelnet.cpp
@@ -0,0 +1,227 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ocdtransport.h"
+#include "mockocd.h"
+#include <QtTest/QtTest>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+
+
+// TclRpcTransport against the Tcl RPC server of a mock openOCD: 0x1a
+// framing in both directions, results matched to commands in order,
+// batches, aborted commands whose results still arrive, many results in
+// one read and results over the limit.
+class tst_TclRpc : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void notConnected();
+    void single();
+    void writeAndRead();
+    void batch();
+    void splitResults();
+    void abortSkipsResults();
+    void manyResults();
+    void resultLimit();
+    void disconnect();
+
+private:
+    static bool waitFor(const QList<OcdReply *> &replies);
+    static bool waitFor(OcdReply *reply) { return waitFor(QList<OcdReply *>() << reply); }
+    bool connectTo(quint16 port);
+
+    MockOcd *mock;
+    TclRpcTransport *transport;
+};
+
+
+void tst_TclRpc::init()
+{
+    mock = new MockOcd(MockOcd::TclRpc);
+    QVERIFY(mock->listen());
+    transport = new TclRpcTransport;
+    QVERIFY(connectTo(mock->port()));
+}
+
+void tst_TclRpc::cleanup()
+{
+    delete transport;
+    delete mock;
+}
+
+bool tst_TclRpc::connectTo(quint16 port)
+{
+    QSignalSpy connected(transport, SIGNAL(connected()));
+    transport->connectToHost("127.0.0.1", port);
+    for (int i = 0; i < 100 && connected.isEmpty(); i++)
+        QTest::qWait(20);
+    return transport->isConnected();
+}
+
+bool tst_TclRpc::waitFor(const QList<OcdReply *> &replies)
+{
+    for (int wait = 0; wait < 500; wait++)
+    {
+        int done = 0;
+        for (int i = 0; i < replies.size(); i++)
+            done += replies.at(i)->isFinished();
+        if (done == replies.size())
+            return true;
+        QTest::qWait(10);
+    }
+    return false;
+}
+
+void tst_TclRpc::notConnected()
+{
+    TclRpcTransport idle;
+    OcdReply *reply = idle.execute("mdw 0");
+    QVERIFY(waitFor(reply));
+    QVERIFY(reply->isAborted());
+    QCOMPARE(reply->latency(), qint64(-1));
+}
+
+void tst_TclRpc::single()
+{
+    mock->setWord(0x20000000, 0x12345678);
+    QSignalSpy output(transport, SIGNAL(output(QByteArray)));
+    OcdReply *reply = transport->execute("mdw 0x20000000");
+    QVERIFY(waitFor(reply));
+    QVERIFY(!reply->isAborted());
+    QCOMPARE(reply->response().trimmed(), QString("0x20000000: 12345678"));
+    QVERIFY(reply->latency() >= 0);
+    QCOMPARE(output.count(), 1);
+    QVERIFY(output.at(0).at(0).toByteArray().endsWith('\n'));
+    QCOMPARE(mock->commands(), 1);
+}
+
+void tst_TclRpc::writeAndRead()
+{
+    OcdReply *write = transport->execute("mww 0x20000100 0xdeadbeef 2");
+    OcdReply *read = transport->execute("mdw 0x20000100 2");
+    QVERIFY(waitFor(QList<OcdReply *>() << write << read));
+    QCOMPARE(mock->word(0x20000104), quint32(0xdeadbeef));
+    QVERIFY(write->response().isEmpty());
+    QCOMPARE(read->response().trimmed(), QString("0x20000100: deadbeef deadbeef"));
+}
+
+void tst_TclRpc::batch()
+{
+    QStringList commands;
+    for (int i = 0; i < 50; i++)
+        commands << QString("echo result %1").arg(i);
+    QList<OcdReply *> replies = transport->execute(commands);
+    QCOMPARE(replies.size(), commands.size());
+    QVERIFY(waitFor(replies));
+    for (int i = 0; i < replies.size(); i++)
+        QCOMPARE(replies.at(i)->response().trimmed(), QString("result %1").arg(i));
+    QVERIFY(mock->reads() <= 2);	// one write for the batch
+}
+
+void tst_TclRpc::splitResults()
+{
+    // results cut anywhere by the network, two in one segment
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+    transport->close();
+    QVERIFY(connectTo(server.serverPort()));
+    for (int i = 0; i < 50 && !server.hasPendingConnections(); i++)
+        QTest::qWait(10);
+    QTcpSocket *peer = server.nextPendingConnection();
+    QVERIFY(peer != 0);
+
+    QList<OcdReply *> replies = transport->execute(QStringList() << "one" << "two" << "three");
+    for (int i = 0; i < 50 && peer->bytesAvailable() < 14; i++)
+        QTest::qWait(10);
+    QCOMPARE(peer->readAll(), QByteArray("one\x1atwo\x1athree\x1a"));
+
+    const char *segments[] = { "fir", "st\x1ase", "cond\x1a", "\x1a" };
+    for (int i = 0; i < 4; i++)
+    {
+        peer->write(segments[i]);
+        peer->flush();
+        QTest::qWait(20);
+        if (i == 0)
+            QVERIFY(!replies.at(0)->isFinished());
+    }
+    QVERIFY(waitFor(replies));
+    QCOMPARE(replies.at(0)->response(), QString("first"));
+    QCOMPARE(replies.at(1)->response(), QString("second"));
+    QCOMPARE(replies.at(2)->response(), QString());
+}
+
+void tst_TclRpc::abortSkipsResults()
+{
+    // the results of aborted commands must not end up in later replies
+    mock->setDelay(100);
+    QList<OcdReply *> aborted = transport->execute(QStringList() << "echo old 1" << "echo old 2");
+    QTest::qWait(20);
+    transport->abort();
+    for (int i = 0; i < aborted.size(); i++)
+    {
+        QVERIFY(aborted.at(i)->isFinished());
+        QVERIFY(aborted.at(i)->isAborted());
+    }
+    mock->setDelay(0);
+    OcdReply *reply = transport->execute("echo new");
+    QVERIFY(waitFor(reply));
+    QVERIFY(!reply->isAborted());
+    QCOMPARE(reply->response().trimmed(), QString("new"));
+}
+
+void tst_TclRpc::manyResults() // thousands of results in one read, each matched once
+{
+    QStringList commands;
+    for (int i = 0; i < 5000; i++)
+        commands << QString("echo %1").arg(i);
+    QList<OcdReply *> replies = transport->execute(commands);
+    QVERIFY(waitFor(replies));
+    for (int i = 0; i < replies.size(); i++)
+        QCOMPARE(replies.at(i)->response().trimmed(), QString::number(i));
+}
+
+void tst_TclRpc::resultLimit() // an endless result fails its reply, the memory stays bounded
+{
+    transport->setResultLimit(1024 * 1024);
+    OcdReply *reply = transport->execute("flood");
+    QVERIFY(waitFor(reply));
+    QVERIFY(reply->failed());
+    QVERIFY(OcdReply::errorLine(reply->response()).contains("dropped"));
+    QTest::qWait(100);		// still flooding, everything is dropped
+    QVERIFY(mock->floodBytes() > 1024 * 1024);
+}
+
+void tst_TclRpc::disconnect()
+{
+    mock->setDelay(200);
+    QSignalSpy disconnected(transport, SIGNAL(disconnected()));
+    OcdReply *reply = transport->execute("echo never");
+    delete mock;			// the server goes away with a command pending
+    mock = 0;
+    QVERIFY(waitFor(reply));
+    QVERIFY(reply->isAborted());
+    QCOMPARE(disconnected.count(), 1);
+    QVERIFY(!transport->isConnected());
+}
+
+QTEST_MAIN(tst_TclRpc)
+#include "tst_tclrpc.moc"
@@ -0,0 +1,10 @@
+TEMPLATE = app
+TARGET = tst_telnetabort
+CONFIG += qtestlib
+QT += network
+QT -= gui
+DEPENDPATH += . ../shared ../../QtTelnet
+INCLUDEPATH += . ../shared ../../QtTelnet
+
+HEADERS += ../shared/mockocd.h ../../QtTelnet/qttelnet.h
+SOURCES += tst_telnetabort.cpp ../shared/mockocd.cpp ../../QtTelnet/qttelnet.cpp
@@ -0,0 +1,154 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "qttelnet.h"
+#include "mockocd.h"
+#include <QtTest/QtTest>
+
+static const qint64 FloodBefore = 4 * 1024 * 1024;	// bytes out before the abort
+static const int UsableWithin = 2000;		// ms
+
+
+// QtTelnet::abort() against a mock openOCD flooding the connection: the
+// server is interrupted, the output still on its way is dropped unseen and
+// the next command gets its own answer, all within a bounded time.
+class tst_TelnetAbort : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void idle();
+    void flood();
+    void floodWithQueued();
+
+private:
+    QtTelnetReply *run(const QString &command);
+    static QByteArray joined(const QSignalSpy &spy);
+    static bool waitFor(QtTelnetReply *reply, int ms);
+
+    MockOcd *mock;
+    QtTelnet *telnet;
+};
+
+
+void tst_TelnetAbort::init()
+{
+    mock = new MockOcd(MockOcd::Telnet);
+    QVERIFY(mock->listen());
+    telnet = new QtTelnet;
+    telnet->setPromptString("> ");
+    telnet->connectToHost("127.0.0.1", mock->port());
+    for (int i = 0; i < 100 && telnet->socket()->state() != QAbstractSocket::ConnectedState; i++)
+        QTest::qWait(20);
+    QCOMPARE(telnet->socket()->state(), QAbstractSocket::ConnectedState);
+    QtTelnetReply *ready = run("echo ready");	// after the banner
+    QVERIFY(ready->isFinished() && !ready->isAborted());
+}
+
+void tst_TelnetAbort::cleanup()
+{
+    delete telnet;
+    delete mock;
+}
+
+QtTelnetReply *tst_TelnetAbort::run(const QString &command)
+{
+    QtTelnetReply *reply = telnet->execute(command);
+    waitFor(reply, UsableWithin);
+    return reply;
+}
+
+QByteArray tst_TelnetAbort::joined(const QSignalSpy &spy)
+{
+    QByteArray data;
+    for (int i = 0; i < spy.count(); i++)
+        data += spy.at(i).at(0).toByteArray();
+    return data;
+}
+
+bool tst_TelnetAbort::waitFor(QtTelnetReply *reply, int ms)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!reply->isFinished() && timer.elapsed() < ms)
+        QTest::qWait(1);
+    return reply->isFinished();
+}
+
+void tst_TelnetAbort::idle()
+{
+    telnet->abort();		// nothing to interrupt, no prompt owed
+    QtTelnetReply *after = run("echo after");
+    QVERIFY(after->isFinished() && !after->isAborted());
+    QCOMPARE(after->response().trimmed(), QString("after"));
+}
+
+void tst_TelnetAbort::flood()
+{
+    QtTelnetReply *flood = telnet->execute("flood");
+    for (int i = 0; i < 1000 && mock->floodBytes() < FloodBefore; i++)
+        QTest::qWait(5);
+    QVERIFY(mock->isFlooding());
+
+    QSignalSpy output(telnet, SIGNAL(rawMessage(QByteArray)));
+    const qint64 flooded = mock->floodBytes();
+    QElapsedTimer timer;
+    timer.start();
+    telnet->abort();
+    QVERIFY(flood->isFinished() && flood->isAborted());
+    QtTelnetReply *after = telnet->execute("echo after");
+
+    qint64 stopped = -1;
+    while (!after->isFinished() && timer.elapsed() < UsableWithin)
+    {
+        QTest::qWait(1);
+        if (stopped < 0 && !mock->isFlooding())
+            stopped = timer.elapsed();
+    }
+    const qint64 usable = timer.elapsed();
+    qDebug("abort after %lld bytes: server quiet after %lld ms, %lld bytes more, next answer after %lld ms",
+           flooded, stopped, mock->floodBytes() - flooded, usable);
+
+    QVERIFY(stopped >= 0);
+    QVERIFY(after->isFinished() && !after->isAborted());
+    QCOMPARE(after->response().trimmed(), QString("after"));
+    QVERIFY(usable < UsableWithin);
+    QVERIFY2(!joined(output).contains("0x"), "flood output shown after the abort");
+    QVERIFY(!mock->isFlooding());
+}
+
+void tst_TelnetAbort::floodWithQueued()
+{
+    // the prompts of all commands written before the abort are waited for
+    QList<QtTelnetReply *> aborted = telnet->execute(QStringList() << "flood" << "echo queued");
+    for (int i = 0; i < 1000 && mock->floodBytes() < FloodBefore / 4; i++)
+        QTest::qWait(5);
+    telnet->abort();
+    QVERIFY(aborted.at(0)->isAborted());
+    QVERIFY(aborted.at(1)->isAborted());
+
+    QtTelnetReply *after = run("echo after");
+    QVERIFY(after->isFinished() && !after->isAborted());
+    QCOMPARE(after->response().trimmed(), QString("after"));
+    QCOMPARE(mock->commands(), 4);	// ready, flood, queued, after
+}
+
+QTEST_MAIN(tst_TelnetAbort)
+#include "tst_telnetabort.moc"
@@ -0,0 +1,182 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "qttelnet.h"
+#include "mockocd.h"
+#include <QtTest/QtTest>
+
+static const int Commands = 100;
+static const int RoundTrip = 5;		// ms the mock waits before answering
+
+
+// A batch of commands against a mock openOCD that answers after a round
+// trip: written at once, the batch costs about one round trip instead of
+// one per command, and every reply still gets its own response.
+class tst_TelnetBatch : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void oneByOne();
+    void batch();
+    void batchAgainstOneByOne();
+
+private:
+    static QStringList commands();
+    static bool waitFor(const QList<QtTelnetReply *> &replies);
+    static bool checkResponses(const QList<QtTelnetReply *> &replies);
+    int runOneByOne();
+    int runBatch();
+
+    MockOcd *mock;
+    QtTelnet *telnet;
+};
+
+
+void tst_TelnetBatch::init()
+{
+    mock = new MockOcd(MockOcd::Telnet);
+    QVERIFY(mock->listen());
+    for (int i = 0; i < Commands; i++)
+        mock->setWord(0x20000000 + 4 * i, 0x01010101 * i);
+    mock->setDelay(RoundTrip);
+
+    telnet = new QtTelnet;
+    telnet->setPromptString("> ");
+    telnet->connectToHost("127.0.0.1", mock->port());
+    for (int i = 0; i < 100 && telnet->socket()->state() != QAbstractSocket::ConnectedState; i++)
+        QTest::qWait(20);
+    QCOMPARE(telnet->socket()->state(), QAbstractSocket::ConnectedState);
+    QList<QtTelnetReply *> ready;
+    ready << telnet->execute("echo ready");	// held until the banner prompt
+    QVERIFY(waitFor(ready));
+    ready.at(0)->deleteLater();
+}
+
+void tst_TelnetBatch::cleanup()
+{
+    delete telnet;
+    delete mock;
+}
+
+// echo and mdw in turn, every response tells which command it belongs to
+QStringList tst_TelnetBatch::commands()
+{
+    QStringList list;
+    for (int i = 0; i < Commands; i++)
+    {
+        if (i % 2)
+            list << QString("mdw 0x%1").arg(0x20000000 + 4 * i, 8, 16, QChar('0'));
+        else
+            list << QString("echo reply %1").arg(i);
+    }
+    return list;
+}
+
+bool tst_TelnetBatch::waitFor(const QList<QtTelnetReply *> &replies)
+{
+    for (int wait = 0; wait < 1000; wait++)
+    {
+        int done = 0;
+        for (int i = 0; i < replies.size(); i++)
+            done += replies.at(i)->isFinished();
+        if (done == replies.size())
+            return true;
+        QTest::qWait(10);
+    }
+    return false;
+}
+
+bool tst_TelnetBatch::checkResponses(const QList<QtTelnetReply *> &replies)
+{
+    for (int i = 0; i < replies.size(); i++)
+    {
+        QString expected = i % 2 ? QString("0x%1: %2").arg(0x20000000 + 4 * i, 8, 16, QChar('0'))
+                                   .arg(0x01010101 * i, 8, 16, QChar('0'))
+                                 : QString("reply %1").arg(i);
+        if (replies.at(i)->isAborted() || replies.at(i)->response().trimmed() != expected)
+        {
+            qWarning("reply %d: '%s' where '%s' was expected", i,
+                     qPrintable(replies.at(i)->response().trimmed()), qPrintable(expected));
+            return false;
+        }
+    }
+    return true;
+}
+
+int tst_TelnetBatch::runOneByOne() // ms, -1 on a wrong response
+{
+    const QStringList list = commands();
+    QList<QtTelnetReply *> replies;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < list.size(); i++)
+    {
+        replies << telnet->execute(list.at(i));
+        if (!waitFor(replies.mid(i)))
+            return -1;
+    }
+    int ms = int(timer.elapsed());
+    bool ok = checkResponses(replies);
+    for (int i = 0; i < replies.size(); i++)
+        replies.at(i)->deleteLater();
+    return ok ? ms : -1;
+}
+
+int tst_TelnetBatch::runBatch()
+{
+    QElapsedTimer timer;
+    timer.start();
+    QList<QtTelnetReply *> replies = telnet->execute(commands());
+    if (!waitFor(replies))
+        return -1;
+    int ms = int(timer.elapsed());
+    bool ok = checkResponses(replies);
+    for (int i = 0; i < replies.size(); i++)
+        replies.at(i)->deleteLater();
+    return ok ? ms : -1;
+}
+
+void tst_TelnetBatch::oneByOne()
+{
+    const int reads = mock->reads();
+    QVERIFY(runOneByOne() >= 0);
+    QCOMPARE(mock->reads() - reads, Commands);
+}
+
+void tst_TelnetBatch::batch()
+{
+    const int reads = mock->reads();
+    QVERIFY(runBatch() >= 0);
+    QVERIFY2(mock->reads() - reads <= 3, qPrintable(QString("%1 reads").arg(mock->reads() - reads)));
+}
+
+void tst_TelnetBatch::batchAgainstOneByOne() // the times are reported, a loaded machine must not fail it
+{
+    const int oneByOne = runOneByOne();
+    const int batch = runBatch();
+    QVERIFY(oneByOne >= 0 && batch >= 0);
+    qDebug("%d commands with a %d ms round trip: %d ms one by one, %d ms as a batch",
+           Commands, RoundTrip, oneByOne, batch);
+    QVERIFY(oneByOne >= Commands * RoundTrip);	// every answer waits a round trip
+}
+
+QTEST_MAIN(tst_TelnetBatch)
+#include "tst_telnetbatch.moc"
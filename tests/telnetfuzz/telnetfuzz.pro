@@ -0,0 +1,10 @@
+TEMPLATE = app
+TARGET = tst_telnetfuzz
+CONFIG += qtestlib
+QT += network
+QT -= gui
+DEPENDPATH += . ../../QtTelnet
+INCLUDEPATH += . ../../QtTelnet
+
+HEADERS += ../../QtTelnet/qttelnet.h
+SOURCES += tst_telnetfuzz.cpp ../../QtTelnet/qttelnet.cpp
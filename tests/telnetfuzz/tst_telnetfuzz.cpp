@@ -0,0 +1,244 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "qttelnet.h"
+#include <QtTest/QtTest>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+// Bytes the parser treats specially, drawn more often than the rest
+static const uchar Special[] = {
+    255, 255, 255,		// IAC
+    250, 240,			// SB, SE
+    251, 252, 253, 254,		// WILL, WONT, DO, DONT
+    242, 241,			// DM, NOP
+    1, 24, 31, 37		// SEND, TerminalType, NAWS, Authentication
+};
+
+static const int Rounds = 500;
+static const int LongSubOption = 16 * 1024 * 1024;
+
+
+// Feeds a QtTelnet random streams of IAC sequences, broken suboptions and
+// text from a local server; the client has to survive them, stay in sync
+// and keep its memory bounded however long a suboption gets.
+class tst_TelnetFuzz : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+    void randomStreams();
+    void unterminatedSubOption();
+    void longSubOption();
+
+private:
+    bool waitForText(QSignalSpy &spy, const QString &text);
+    void resync();
+
+    QTcpServer server;
+    QTcpSocket *peer;
+    QtTelnet *telnet;
+};
+
+
+static void quietHandler(QtMsgType type, const char *message)
+{
+    // the parser warns about every unknown command; only fatal ones matter
+    if (type == QtFatalMsg)
+    {
+        fprintf(stderr, "%s\n", message);
+        abort();
+    }
+}
+
+static QtMsgHandler previousHandler = 0;
+
+static QByteArray noise(int length)
+{
+    QByteArray out;
+    out.reserve(length + 16);
+    while (out.size() < length)
+    {
+        switch (qrand() % 4)
+        {
+            case 0:
+                out.append(char(qrand() & 0xff));
+                break;
+            case 1:
+                out.append(char(Special[qrand() % sizeof(Special)]));
+                break;
+            default:
+            {
+                const int run = qrand() % 16;
+                for (int i = 0; i < run; ++i)
+                    out.append(char(' ' + qrand() % 95));
+                break;
+            }
+        }
+    }
+    // WONT Logout makes the client hang up, which is no parser failure;
+    // a trailing WONT could pair with a Logout starting the next stream
+    out.replace(QByteArray("\xfc\x12"), QByteArray("\xfc\x13"));
+    while (out.endsWith('\xfc'))
+        out.chop(1);
+    return out;
+}
+
+static qint64 residentBytes()
+{
+#ifdef Q_OS_LINUX
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly))
+    {
+        const QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 1)
+            return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+    }
+#endif
+    return -1;
+}
+
+
+void tst_TelnetFuzz::initTestCase()
+{
+    previousHandler = qInstallMsgHandler(quietHandler);
+    qsrand(0x0cd5eed);
+}
+
+void tst_TelnetFuzz::cleanupTestCase()
+{
+    qInstallMsgHandler(previousHandler);
+}
+
+void tst_TelnetFuzz::init()
+{
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+    telnet = new QtTelnet;
+    telnet->connectToHost("127.0.0.1", server.serverPort());
+    for (int i = 0; i < 100 && !server.hasPendingConnections(); ++i)
+        QTest::qWait(50);
+    peer = server.nextPendingConnection();
+    QVERIFY(peer != 0);
+    for (int i = 0; i < 100 && telnet->socket()->state() != QAbstractSocket::ConnectedState; ++i)
+        QTest::qWait(50);
+    QCOMPARE(telnet->socket()->state(), QAbstractSocket::ConnectedState);
+}
+
+void tst_TelnetFuzz::cleanup()
+{
+    delete telnet;
+    telnet = 0;
+    server.close();
+}
+
+// Waits until the text received so far contains \a text.
+bool tst_TelnetFuzz::waitForText(QSignalSpy &spy, const QString &text)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 10000)
+    {
+        QString received;
+        for (int i = 0; i < spy.count(); ++i)
+            received += spy.at(i).at(0).toString();
+        if (received.contains(text))
+            return true;
+        peer->readAll();
+        QTest::qWait(10);
+    }
+    return false;
+}
+
+// Brings the parser back to plain data from whatever state the noise left
+// it in: the first IAC SE ends a suboption, the second one any sequence
+// that swallowed the first as an option byte or an escaped IAC.
+void tst_TelnetFuzz::resync()
+{
+    peer->write("\xff\xf0\xff\xf0\r\n");
+}
+
+void tst_TelnetFuzz::randomStreams()
+{
+    QSignalSpy spy(telnet, SIGNAL(message(QString)));
+    for (int round = 0; round < Rounds; ++round)
+    {
+        peer->write(noise(qrand() % 4096 + 1));
+        QCoreApplication::processEvents();
+        peer->readAll();
+        QCOMPARE(telnet->socket()->state(), QAbstractSocket::ConnectedState);
+    }
+    resync();
+    peer->write("fuzz-end\r\n");
+    QVERIFY(waitForText(spy, "fuzz-end"));
+    QCOMPARE(telnet->socket()->state(), QAbstractSocket::ConnectedState);
+}
+
+void tst_TelnetFuzz::unterminatedSubOption()
+{
+    // IAC SB without IAC SE, cut by another IAC SB and by plain commands
+    QSignalSpy spy(telnet, SIGNAL(message(QString)));
+    peer->write(QByteArray("\xff\xfa\x18\x01\xff\xfa\x25\x01\x00\xff\xf1\xff\xfa", 13));
+    peer->write(QByteArray(1024, '\xff'));
+    resync();
+    peer->write("sub-end\r\n");
+    QVERIFY(waitForText(spy, "sub-end"));
+}
+
+void tst_TelnetFuzz::longSubOption()
+{
+    // without a cap the suboption buffer grows by every byte sent
+    QSignalSpy spy(telnet, SIGNAL(message(QString)));
+    QTest::qWait(100);
+    const qint64 before = residentBytes();
+
+    peer->write("\xff\xfa\x18");
+    const QByteArray chunk(64 * 1024, 'x');
+    QElapsedTimer timer;
+    timer.start();
+    for (int sent = 0; sent < LongSubOption && timer.elapsed() < 30000; )
+    {
+        if (peer->bytesToWrite() < 4 * chunk.size())
+        {
+            peer->write(chunk);
+            sent += chunk.size();
+        }
+        QCoreApplication::processEvents();
+    }
+    resync();
+    peer->write("long-end\r\n");
+    QVERIFY(waitForText(spy, "long-end"));
+
+    const qint64 after = residentBytes();
+    if (before >= 0 && after >= 0)
+        QVERIFY2(after - before < LongSubOption / 4,
+                 qPrintable(QString("resident set grew by %1 bytes").arg(after - before)));
+}
+
+QTEST_MAIN(tst_TelnetFuzz)
+#include "tst_telnetfuzz.moc"
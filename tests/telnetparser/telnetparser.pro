@@ -0,0 +1,10 @@
+TEMPLATE = app
+TARGET = tst_telnetparser
+CONFIG += qtestlib
+QT += network
+QT -= gui
+DEPENDPATH += . ../../QtTelnet
+INCLUDEPATH += . ../../QtTelnet
+
+HEADERS += ../../QtTelnet/qttelnet.h
+SOURCES += tst_telnetparser.cpp ../../QtTelnet/qttelnet.cpp
@@ -0,0 +1,211 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "qttelnet.h"
+#include <QtTest/QtTest>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+
+// text, IAC IAC, a negotiation, a suboption and a command in one stream
+static const char Stream[] = "one\r\n\xff\xfb\x01two\xff\xff\xff\xfa\x18\x01\xff\xf0three\xff\xf1\r\n";
+static const char StreamText[] = "one\r\ntwo\xffthree\r\n";
+static const char TerminalTypeIs[] = "\xff\xfa\x18\x00UNKNOWN\xff\xf0";
+
+
+// The telnet stream parser as a server sees it: text is delivered byte
+// for byte, IAC sequences are taken out and answered wherever the TCP
+// segments split them, and responses are cut at the prompt.
+class tst_TelnetParser : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void plainText();
+    void escapedIac();
+    void negotiationSplit();
+    void subOptionSplit();
+    void everySplit();
+    void promptSplit();
+    void pipelinedResponses();
+
+private:
+    void send(const QByteArray &data);
+    QByteArray peerReceived(int bytes);
+    static QByteArray joined(const QSignalSpy &spy);
+
+    QTcpServer server;
+    QTcpSocket *peer;
+    QtTelnet *telnet;
+};
+
+
+void tst_TelnetParser::init()
+{
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+    telnet = new QtTelnet;
+    telnet->connectToHost("127.0.0.1", server.serverPort());
+    for (int i = 0; i < 100 && !server.hasPendingConnections(); ++i)
+        QTest::qWait(50);
+    peer = server.nextPendingConnection();
+    QVERIFY(peer != 0);
+    for (int i = 0; i < 100 && telnet->socket()->state() != QAbstractSocket::ConnectedState; ++i)
+        QTest::qWait(50);
+    QCOMPARE(telnet->socket()->state(), QAbstractSocket::ConnectedState);
+    QTest::qWait(50);
+    peer->readAll();		// the options the client offers
+}
+
+void tst_TelnetParser::cleanup()
+{
+    delete telnet;
+    telnet = 0;
+    server.close();
+}
+
+// Writes data as a segment of its own and lets the client read it.
+void tst_TelnetParser::send(const QByteArray &data)
+{
+    peer->write(data);
+    peer->flush();
+    QTest::qWait(20);
+}
+
+// Waits for at least bytes from the client, returns all it sent so far.
+QByteArray tst_TelnetParser::peerReceived(int bytes)
+{
+    QByteArray data;
+    for (int i = 0; i < 100 && data.size() < bytes; ++i)
+    {
+        QTest::qWait(20);
+        data += peer->readAll();
+    }
+    return data;
+}
+
+QByteArray tst_TelnetParser::joined(const QSignalSpy &spy)
+{
+    QByteArray data;
+    for (int i = 0; i < spy.count(); ++i)
+        data += spy.at(i).at(0).toByteArray();
+    return data;
+}
+
+void tst_TelnetParser::plainText()
+{
+    QSignalSpy spy(telnet, SIGNAL(rawMessage(QByteArray)));
+    QByteArray text;
+    for (int i = 0; i < 1000; ++i)
+        text += "0x00200000: deadbeef 00000000 cafebabe 12345678 \r\n";
+    send(text);
+    QCOMPARE(joined(spy), text);
+}
+
+void tst_TelnetParser::escapedIac()
+{
+    QSignalSpy spy(telnet, SIGNAL(rawMessage(QByteArray)));
+    send("a\xff\xff");
+    send("\xff");
+    send("\xff" "b\xff\xff\xff\xff" "c");
+    QCOMPARE(joined(spy), QByteArray("a\xff\xff" "b\xff\xff" "c"));
+}
+
+void tst_TelnetParser::negotiationSplit()
+{
+    // IAC WILL ECHO cut after every byte, refused with IAC DONT ECHO
+    QSignalSpy spy(telnet, SIGNAL(rawMessage(QByteArray)));
+    send("ab\xff");
+    send("\xfb");
+    send("\x01" "cd");
+    QCOMPARE(joined(spy), QByteArray("abcd"));
+    QVERIFY(peerReceived(3).contains("\xff\xfe\x01"));
+}
+
+void tst_TelnetParser::subOptionSplit()
+{
+    QSignalSpy spy(telnet, SIGNAL(rawMessage(QByteArray)));
+    const QByteArray sub("x\xff\xfa\x18\x01\xff\xf0y");
+    for (int i = 1; i < sub.size(); ++i)
+    {
+        send(sub.left(i));
+        send(sub.mid(i));
+    }
+    QByteArray expected;
+    for (int i = 1; i < sub.size(); ++i)
+        expected += "xy";
+    QCOMPARE(joined(spy), expected);
+    const QByteArray answer(TerminalTypeIs, sizeof(TerminalTypeIs) - 1);
+    QCOMPARE(peerReceived(answer.size() * (sub.size() - 1)).count(answer), sub.size() - 1);
+}
+
+void tst_TelnetParser::everySplit()
+{
+    const QByteArray stream(Stream, sizeof(Stream) - 1);
+    const QByteArray text(StreamText, sizeof(StreamText) - 1);
+    for (int i = 1; i < stream.size(); ++i)
+    {
+        QSignalSpy spy(telnet, SIGNAL(rawMessage(QByteArray)));
+        send(stream.left(i));
+        send(stream.mid(i));
+        QVERIFY2(joined(spy) == text, qPrintable(QString("split at %1").arg(i)));
+    }
+}
+
+void tst_TelnetParser::promptSplit()
+{
+    telnet->setPromptString("> ");
+    send("Open On-Chip Debugger\r\n> ");
+    QtTelnetReply *reply = telnet->execute("mdw 0x0 2");
+    QVERIFY(peerReceived(11).startsWith("mdw 0x0 2\r\n"));
+
+    send("mdw 0x0 2\r\n0x00000000: 12345678 9abcdef0 \r\n");
+    send(">");
+    QVERIFY(!reply->isFinished());
+    send(" ");
+    QVERIFY(reply->isFinished());
+    QVERIFY(!reply->isAborted());
+    QCOMPARE(reply->response().trimmed(), QString("0x00000000: 12345678 9abcdef0"));
+    reply->deleteLater();
+}
+
+void tst_TelnetParser::pipelinedResponses()
+{
+    telnet->setPromptString("> ");
+    send("Open On-Chip Debugger\r\n> ");
+    const QStringList commands = QStringList() << "halt" << "mdw 0x0" << "resume";
+    QList<QtTelnetReply *> replies = telnet->execute(commands);
+    QCOMPARE(replies.size(), 3);
+    QCOMPARE(peerReceived(26).count('\n'), 3);
+
+    QByteArray answers;
+    for (int i = 0; i < commands.size(); ++i)
+        answers += commands.at(i).toLatin1() + "\r\nanswer " + QByteArray::number(i) + "\r\n> ";
+    for (int i = 0; i < answers.size(); i += 7)	// in pieces that split everything
+        send(answers.mid(i, 7));
+
+    for (int i = 0; i < replies.size(); ++i)
+    {
+        QVERIFY(replies.at(i)->isFinished());
+        QCOMPARE(replies.at(i)->response().trimmed(), QString("answer %1").arg(i));
+        replies.at(i)->deleteLater();
+    }
+}
+
+QTEST_MAIN(tst_TelnetParser)
+#include "tst_telnetparser.moc"
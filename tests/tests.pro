@@ -0,0 +1,7 @@
+######################################################################
+# Unit tests, built apart from the application:
+#   cd tests && qmake && make, then run the tst_* programs
+######################################################################
+
+TEMPLATE = subdirs
+SUBDIRS += telnetfuzz telnetparser memparse snapshot blockcache watchplan telnetbatch tclrpc gdbremote telnetabort station batch flashimage delta
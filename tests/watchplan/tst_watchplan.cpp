@@ -0,0 +1,162 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "watch.h"
+#include "ocdtransport.h"
+#include "mockocd.h"
+#include <QtTest/QtTest>
+#include <QSet>
+
+
+// How the watch poller merges the watched addresses into reads, and what
+// it shows for them once read from a mock openOCD.
+class tst_WatchPlan : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void empty();
+    void adjacent();
+    void duplicates();
+    void unsorted();
+    void gap();
+    void unaligned();
+    void random();
+    void lookup();
+
+private:
+    static void compareRead(const WatchPoller::Read &read, quint32 address, int words);
+};
+
+
+void tst_WatchPlan::compareRead(const WatchPoller::Read &read, quint32 address, int words)
+{
+    QCOMPARE(read.address, address);
+    QCOMPARE(read.words, words);
+}
+
+void tst_WatchPlan::empty()
+{
+    QVERIFY(WatchPoller::plan(QList<quint32>()).isEmpty());
+}
+
+void tst_WatchPlan::adjacent()
+{
+    QList<WatchPoller::Read> reads = WatchPoller::plan(QList<quint32>() << 0x1000 << 0x1004 << 0x1008);
+    QCOMPARE(reads.size(), 1);
+    compareRead(reads.at(0), 0x1000, 3);
+}
+
+void tst_WatchPlan::duplicates()
+{
+    QList<WatchPoller::Read> reads = WatchPoller::plan(QList<quint32>() << 0x1000 << 0x1000 << 0x1004 << 0x1004);
+    QCOMPARE(reads.size(), 1);
+    compareRead(reads.at(0), 0x1000, 2);
+}
+
+void tst_WatchPlan::unsorted()
+{
+    QList<WatchPoller::Read> reads = WatchPoller::plan(QList<quint32>() << 0x2008 << 0x1000 << 0x2000 << 0x2004);
+    QCOMPARE(reads.size(), 2);
+    compareRead(reads.at(0), 0x1000, 1);
+    compareRead(reads.at(1), 0x2000, 3);
+}
+
+void tst_WatchPlan::gap()
+{
+    // one word apart is two reads, the word between may be a register
+    QList<WatchPoller::Read> reads = WatchPoller::plan(QList<quint32>() << 0x40000000 << 0x40000008);
+    QCOMPARE(reads.size(), 2);
+    compareRead(reads.at(0), 0x40000000, 1);
+    compareRead(reads.at(1), 0x40000008, 1);
+}
+
+void tst_WatchPlan::unaligned()
+{
+    QList<WatchPoller::Read> reads = WatchPoller::plan(QList<quint32>() << 0x1003 << 0x1001 << 0x1005);
+    QCOMPARE(reads.size(), 1);
+    compareRead(reads.at(0), 0x1000, 2);
+}
+
+void tst_WatchPlan::random()
+{
+    // every watched word is read exactly once and nothing else is
+    qsrand(1);
+    for (int round = 0; round < 200; ++round)
+    {
+        QList<quint32> addresses;
+        QSet<quint32> watched;
+        for (int n = qrand() % 40; n > 0; --n)
+        {
+            quint32 address = 0x20000000 + qrand() % 256;
+            addresses << address;
+            watched << (address & ~quint32(3));
+        }
+        QList<WatchPoller::Read> reads = WatchPoller::plan(addresses);
+        QSet<quint32> read;
+        for (int i = 0; i < reads.size(); ++i)
+        {
+            QVERIFY(reads.at(i).words > 0);
+            if (i > 0)		// sorted and never adjacent
+                QVERIFY(reads.at(i).address > reads.at(i - 1).address + 4 * reads.at(i - 1).words);
+            for (int w = 0; w < reads.at(i).words; ++w)
+                read << reads.at(i).address + 4 * w;
+        }
+        QVERIFY(read == watched);
+    }
+}
+
+void tst_WatchPlan::lookup() // unaligned watches read their byte of the word
+{
+    MockOcd mock(MockOcd::TclRpc);
+    QVERIFY(mock.listen());
+    mock.setWord(0x20000100, 0x44332211);
+    mock.setWord(0x20000104, 0x88776655);
+    TclRpcTransport transport;
+    QSignalSpy connected(&transport, SIGNAL(connected()));
+    transport.connectToHost("127.0.0.1", mock.port());
+    for (int i = 0; i < 200 && connected.isEmpty(); i++)
+        QTest::qWait(10);
+    QVERIFY(transport.isConnected());
+
+    WatchPoller poller;
+    poller.setTransport(&transport);
+    poller.setAddresses(QList<quint32>() << 0x20000100 << 0x20000101 << 0x20000107);
+    QSignalSpy updated(&poller, SIGNAL(updated()));
+    poller.start();
+    for (int i = 0; i < 200 && updated.isEmpty(); i++)
+        QTest::qWait(10);
+    poller.stop();
+    QVERIFY(!updated.isEmpty());
+
+    QVERIFY(poller.isValid(0x20000101));
+    QVERIFY(poller.isValid(0x20000107));
+    QVERIFY(!poller.isValid(0x20000108));
+    QCOMPARE(poller.value(0x20000100), quint32(0x44332211));
+    QCOMPARE(poller.value(0x20000101), quint32(0x22));
+    QCOMPARE(poller.value(0x20000103), quint32(0x44));
+    QCOMPARE(poller.value(0x20000107), quint32(0x88));
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);	// sockets for lookup(), no display needed
+    tst_WatchPlan test;
+    return QTest::qExec(&test, argc, argv);
+}
+#include "tst_watchplan.moc"
@@ -0,0 +1,9 @@
+TEMPLATE = app
+TARGET = tst_watchplan
+CONFIG += qtestlib
+QT += network
+DEPENDPATH += . ../shared ../.. ../../QtTelnet
+INCLUDEPATH += . ../shared ../.. ../../QtTelnet
+
+HEADERS += ../shared/mockocd.h ../../watch.h ../../memparse.h ../../ocdtransport.h ../../spscqueue.h ../../QtTelnet/qttelnet.h
+SOURCES += tst_watchplan.cpp ../shared/mockocd.cpp ../../watch.cpp ../../memparse.cpp ../../ocdtransport.cpp ../../QtTelnet/qttelnet.cpp
@@ -0,0 +1,365 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "watch.h"
+#include "memparse.h"
+#include "ocdtransport.h"
+#include <QTimer>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QSpinBox>
+#include <QLabel>
+#include <QPushButton>
+#include <QBoxLayout>
+#include <QStringList>
+#include <QtAlgorithms>
+
+static const int MaxBackoff = 16;	// times the interval asked for
+
+
+WatchPoller::WatchPoller(QObject *parent) : QObject(parent), base(500), backoff(1), rounds(0)
+{
+    timer = new QTimer(this);
+    timer->setInterval(base);
+    connect(timer, SIGNAL(timeout()), this, SLOT(poll()));
+}
+
+void WatchPoller::setTransport(OcdTransport *transport)
+{
+    this->transport = transport;
+    pending.clear();	// replies of the old one are ignored
+    values.clear();
+}
+
+void WatchPoller::setAddresses(const QList<quint32> &addresses)
+{
+    reads = plan(addresses);
+    pending.clear();
+    values.clear();
+}
+
+void WatchPoller::setInterval(int ms)
+{
+    base = qMax(ms, 10);
+    backoff = 1;
+    timer->setInterval(base);
+}
+
+int WatchPoller::interval() const
+{
+    return base * backoff;
+}
+
+bool WatchPoller::isRunning() const
+{
+    return timer->isActive();
+}
+
+quint32 WatchPoller::value(quint32 address) const // the word, or the byte of an unaligned address
+{
+    quint32 word = values.value(address & ~quint32(3));
+    if (address & 3)
+        return (word >> (8 * (address & 3))) & 0xff;	// little endian target, as mdw shows it
+    return word;
+}
+
+QList<WatchPoller::Read> WatchPoller::plan(const QList<quint32> &addresses) // as few reads as possible, no word read that is not watched
+{
+    QList<quint32> words;
+    for (int i = 0; i < addresses.size(); i++)
+        words << (addresses.at(i) & ~quint32(3));
+    qSort(words);
+
+    QList<Read> reads;
+    for (int i = 0; i < words.size(); i++)
+    {
+        if (!reads.isEmpty())
+        {
+            Read &last = reads.last();
+            quint32 end = last.address + 4 * last.words;
+            if (words.at(i) < end)
+                continue;		// overlapping
+            if (words.at(i) == end)
+            {
+                last.words++;	// adjacent, registers with side effects on read are never touched in between
+                continue;
+            }
+        }
+        Read read = { words.at(i), 1 };
+        reads << read;
+    }
+    return reads;
+}
+
+void WatchPoller::start()
+{
+    rounds = 0;
+    rateClock.start();
+    timer->start();
+    poll();
+}
+
+void WatchPoller::stop()
+{
+    timer->stop();
+    pending.clear();
+}
+
+
+
+// private Slots:
+void WatchPoller::poll()
+{
+    if (!transport || !transport->isConnected() || reads.isEmpty())
+        return;
+    if (!pending.isEmpty())
+    {
+        if (backoff < MaxBackoff)	// the last round is still on the link
+        {
+            backoff *= 2;
+            timer->setInterval(base * backoff);
+        }
+        return;
+    }
+
+    QStringList commands;
+    for (int i = 0; i < reads.size(); i++)
+        commands << QString("mdw 0x%1 %2").arg(reads.at(i).address, 8, 16, QChar('0')).arg(reads.at(i).words);
+    roundClock.start();
+    QList<OcdReply *> replies = transport->execute(commands);
+    for (int i = 0; i < replies.size(); i++)
+    {
+        pending.insert(replies.at(i), i);
+        connect(replies.at(i), SIGNAL(finished()), this, SLOT(replyFinished()));
+    }
+}
+
+void WatchPoller::replyFinished()
+{
+    OcdReply *reply = qobject_cast<OcdReply *>(sender());
+    if (!reply)
+        return;
+    reply->deleteLater();
+    if (!pending.contains(reply))
+        return;		// stale, the watches or the transport changed
+    int index = pending.take(reply);
+    if (index >= reads.size())
+        return;
+
+    const Read &read = reads.at(index);
+    QVector<quint32> words(read.words);
+    QByteArray text = reply->response().toLatin1();
+    MemoryParser parser(read.address, 4);
+    bool ok = !reply->isAborted() && parser.parseDump(text.constData(), text.size(), words.data(), words.size()) == words.size();
+    for (int i = 0; i < read.words; i++)
+    {
+        if (ok)
+            values.insert(read.address + 4 * i, words.at(i));
+        else
+            values.remove(read.address + 4 * i);
+    }
+    if (pending.isEmpty())
+        finishRound();
+}
+
+
+
+// private Funktions:
+void WatchPoller::finishRound()
+{
+    if (backoff > 1 && roundClock.elapsed() < base * backoff / 4)	// the link keeps up again
+    {
+        backoff /= 2;
+        timer->setInterval(base * backoff);
+    }
+    rounds++;
+    emit updated();
+
+    qint64 ms = rateClock.elapsed();
+    if (ms >= 1000)
+    {
+        emit rate(rounds * 1000.0 / ms, interval());
+        rounds = 0;
+        rateClock.start();
+    }
+}
+
+
+
+WatchView::WatchView(QWidget *parent) : QWidget(parent)
+{
+    poller = new WatchPoller(this);
+
+    table = new QTableWidget(0, 3, this);
+    table->setHorizontalHeaderLabels(QStringList() << "Name" << "Address" << "Value");
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->horizontalHeader()->setStretchLastSection(true);
+
+    buttonAdd = new QPushButton("Add", this);
+    buttonRemove = new QPushButton("Remove", this);
+    buttonStart = new QPushButton("Start", this);
+    period = new QSpinBox(this);
+    period->setRange(10, 10000);
+    period->setSingleStep(100);
+    period->setValue(poller->interval());
+    period->setSuffix(" ms");
+    period->setToolTip("time between two reads of all watches");
+    status = new QLabel(this);
+
+    QHBoxLayout *buttons = new QHBoxLayout;
+    buttons->addWidget(buttonAdd);
+    buttons->addWidget(buttonRemove);
+    buttons->addStretch();
+    buttons->addWidget(new QLabel("Interval:", this));
+    buttons->addWidget(period);
+    buttons->addWidget(buttonStart);
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(buttons);
+    layout->addWidget(table);
+    layout->addWidget(status);
+
+    connect(buttonAdd, SIGNAL(clicked()), this, SLOT(addRow()));
+    connect(buttonRemove, SIGNAL(clicked()), this, SLOT(removeRow()));
+    connect(buttonStart, SIGNAL(clicked()), this, SLOT(startStop()));
+    connect(period, SIGNAL(valueChanged(int)), this, SLOT(intervalChanged(int)));
+    connect(table, SIGNAL(itemChanged(QTableWidgetItem *)), this, SLOT(watchesChanged()));
+    connect(poller, SIGNAL(updated()), this, SLOT(showValues()));
+    connect(poller, SIGNAL(rate(double, int)), this, SLOT(showRate(double, int)));
+}
+
+void WatchView::setTransport(OcdTransport *transport)
+{
+    poller->setTransport(transport);
+}
+
+void WatchView::addWatch(const QString &name, quint32 address) // replaces the address of a watch with the same name
+{
+    int row = 0;
+    while (row < table->rowCount() && table->item(row, 0)->text() != name)
+        row++;
+    bool blocked = table->blockSignals(true);
+    if (row == table->rowCount())
+    {
+        table->insertRow(row);
+        table->setItem(row, 0, new QTableWidgetItem(name));
+        table->setItem(row, 1, new QTableWidgetItem);
+        QTableWidgetItem *value = new QTableWidgetItem;
+        value->setFlags(value->flags() & ~Qt::ItemIsEditable);
+        table->setItem(row, 2, value);
+    }
+    table->item(row, 1)->setText(QString("0x%1").arg(address, 8, 16, QChar('0')));
+    table->blockSignals(blocked);
+    watchesChanged();
+}
+
+
+
+// private Slots:
+void WatchView::addRow()
+{
+    addWatch(QString("watch %1").arg(table->rowCount() + 1), 0x00200000);
+    table->editItem(table->item(table->rowCount() - 1, 1));
+}
+
+void WatchView::removeRow()
+{
+    int row = table->currentRow();
+    if (row < 0)
+        return;
+    table->removeRow(row);
+    watchesChanged();
+}
+
+void WatchView::startStop()
+{
+    if (poller->isRunning())
+    {
+        poller->stop();
+        buttonStart->setText("Start");
+        status->setText(QString("%1 watch(es) in %2 read(s), stopped").arg(table->rowCount()).arg(poller->readCount()));
+    }
+    else
+    {
+        poller->start();
+        buttonStart->setText("Stop");
+    }
+}
+
+void WatchView::watchesChanged()
+{
+    poller->setAddresses(addresses());
+    shown.fill(QString(), table->rowCount());
+    status->setText(QString("%1 watch(es) in %2 read(s)").arg(table->rowCount()).arg(poller->readCount()));
+}
+
+void WatchView::intervalChanged(int ms)
+{
+    poller->setInterval(ms);
+}
+
+void WatchView::showValues()
+{
+    bool blocked = table->blockSignals(true);
+    for (int row = 0; row < table->rowCount() && row < shown.size(); row++)
+    {
+        bool ok;
+        quint32 address = addressOf(table->item(row, 1), &ok);
+        QString text = "invalid address";
+        if (ok)
+            text = poller->isValid(address) ? QString("0x%1").arg(poller->value(address), address & 3 ? 2 : 8, 16, QChar('0'))
+                                            : QString("not readable");
+
+        QTableWidgetItem *item = table->item(row, 2);
+        QFont font = item->font();
+        font.setBold(!shown.at(row).isEmpty() && text != shown.at(row));
+        item->setFont(font);
+        item->setText(text);
+        shown[row] = text;
+    }
+    table->blockSignals(blocked);
+}
+
+void WatchView::showRate(double polls, int interval)
+{
+    status->setText(QString("%1 watch(es) in %2 read(s), %3 of %4 polls/s%5")
+                    .arg(table->rowCount()).arg(poller->readCount())
+                    .arg(polls, 0, 'f', 1).arg(1000.0 / period->value(), 0, 'f', 1)
+                    .arg(interval > period->value() ? QString(", link saturated, backed off to %1 ms").arg(interval) : QString()));
+}
+
+
+
+// private Funktions:
+QList<quint32> WatchView::addresses() const
+{
+    QList<quint32> list;
+    for (int row = 0; row < table->rowCount(); row++)
+    {
+        bool ok;
+        quint32 address = addressOf(table->item(row, 1), &ok);
+        if (ok)
+            list << address;
+    }
+    return list;
+}
+
+quint32 WatchView::addressOf(const QTableWidgetItem *item, bool *ok)
+{
+    *ok = false;
+    return item ? item->text().trimmed().toUInt(ok, 0) : 0;
+}
@@ -0,0 +1,131 @@
+/*
+Graphical frontend for the Open On-Chip Debugger
+Copyright (C) 2013 Sven Sperner
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <QWidget>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QPointer>
+#include <QElapsedTimer>
+
+class OcdTransport;
+class OcdReply;
+class QTimer;
+class QTableWidget;
+class QTableWidgetItem;
+class QSpinBox;
+class QLabel;
+class QPushButton;
+
+// Polls a set of word addresses at a fixed rate. Adjacent and overlapping
+// addresses are merged into one "mdw", all reads of a round go out in one
+// batch. A round still running when the next is due means the link is
+// saturated: the interval is doubled, and halved again once rounds are
+// quick.
+class WatchPoller : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Read
+    {
+        quint32 address;
+        int words;
+    };
+
+    WatchPoller(QObject *parent = 0);
+
+    void setTransport(OcdTransport *transport);
+    void setAddresses(const QList<quint32> &addresses);
+    void setInterval(int ms);
+    int interval() const;		// with the back off
+    bool isRunning() const;
+    int readCount() const { return reads.size(); }
+
+    bool isValid(quint32 address) const { return values.contains(address & ~quint32(3)); }
+    quint32 value(quint32 address) const;
+
+    static QList<Read> plan(const QList<quint32> &addresses);
+
+public slots:
+    void start();
+    void stop();
+
+signals:
+    void updated();
+    void rate(double polls, int interval);	// achieved rounds per second
+
+private slots:
+    void poll();
+    void replyFinished();
+
+private:
+    void finishRound();
+
+    QPointer<OcdTransport> transport;
+    QTimer *timer;
+    QList<Read> reads;
+    QHash<OcdReply *, int> pending;	// index into reads
+    QHash<quint32, quint32> values;
+    int base;			// interval asked for, ms
+    int backoff;			// multiplier of base
+    QElapsedTimer roundClock;
+    QElapsedTimer rateClock;
+    int rounds;			// since rateClock started
+};
+
+// Watch tab: named addresses with their current value, changed values
+// are shown in bold.
+class WatchView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    WatchView(QWidget *parent = 0);
+
+    void setTransport(OcdTransport *transport);
+    void addWatch(const QString &name, quint32 address);
+
+private slots:
+    void addRow();
+    void removeRow();
+    void startStop();
+    void watchesChanged();
+    void intervalChanged(int ms);
+    void showValues();
+    void showRate(double polls, int interval);
+
+private:
+    QList<quint32> addresses() const;
+    static quint32 addressOf(const QTableWidgetItem *item, bool *ok);
+
+    WatchPoller *poller;
+    QVector<QString> shown;		// value text of every row, to spot changes
+
+    QTableWidget *table;
+    QSpinBox *period;
+    QLabel *status;
+    QPushButton *buttonAdd;
+    QPushButton *buttonRemove;
+    QPushButton *buttonStart;
+};
+
+#endif // WATCH_H